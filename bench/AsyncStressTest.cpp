@@ -0,0 +1,228 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Stress test for WorkerPool and callAsync(): tasks submitted by other threads and by workers, the sleep and wake-up of
+// idle workers, the destructor executing pending tasks, and results and exceptions delivered through futures.
+// Exits with status 1 on failure. Meant to be run under ThreadSanitizer as well (-DAURORA_SANITIZER=thread).
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+#include <Aurora/Dispatch/AsyncDispatch.hpp>
+#include <Aurora/Tools/WorkerPool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	const int submitterCount = 4;
+	const int submitCount = 5000;
+
+	// Many tasks from threads that are not workers
+	void testSubmitFromOutside()
+	{
+		aurora::WorkerPool pool(4);
+		std::atomic<int> executed(0);
+
+		std::vector<std::thread> submitters;
+		for (int t = 0; t < submitterCount; ++t)
+		{
+			submitters.emplace_back([&] ()
+			{
+				std::vector<std::future<int>> results;
+				for (int i = 0; i < submitCount; ++i)
+					results.push_back(pool.submit([&executed, i] () { ++executed; return i; }));
+
+				for (int i = 0; i < submitCount; ++i)
+					check(results[i].get() == i, "result of task " + std::to_string(i));
+			});
+		}
+
+		for (std::thread& submitter : submitters)
+			submitter.join();
+
+		check(executed == submitterCount * submitCount, "all tasks executed once, got " + std::to_string(executed.load()));
+	}
+
+	// Tasks that submit further tasks from a worker thread, into the worker's own queue
+	void testSubmitFromWorker()
+	{
+		aurora::WorkerPool pool(4);
+		std::atomic<int> executed(0);
+		const int outerCount = 200;
+		const int innerCount = 50;
+
+		std::vector<std::future<std::vector<std::future<void>>>> outer;
+		for (int i = 0; i < outerCount; ++i)
+		{
+			outer.push_back(pool.submit([&pool, &executed] ()
+			{
+				std::vector<std::future<void>> inner;
+				for (int j = 0; j < innerCount; ++j)
+					inner.push_back(pool.submit([&executed] () { ++executed; }));
+
+				return inner;
+			}));
+		}
+
+		for (std::future<std::vector<std::future<void>>>& result : outer)
+		{
+			for (std::future<void>& inner : result.get())
+				inner.get();
+		}
+
+		check(executed == outerCount * innerCount, "all nested tasks executed once, got " + std::to_string(executed.load()));
+	}
+
+	// Single tasks with pauses in between, so that the workers go to sleep and must be woken up each time
+	void testSleepAndWake()
+	{
+		aurora::WorkerPool pool(2);
+
+		for (int i = 0; i < 200; ++i)
+		{
+			check(pool.submit([i] () { return i; }).get() == i, "task after sleep " + std::to_string(i));
+
+			if (i % 20 == 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	// The destructor executes all tasks that are still queued
+	void testDestructorDrains()
+	{
+		std::atomic<int> executed(0);
+		const int taskCount = 1000;
+
+		{
+			aurora::WorkerPool pool(1);
+			std::promise<void> gate;
+			std::shared_future<void> opened = gate.get_future().share();
+
+			// Block the only worker, so that the other tasks are still pending when the destructor starts
+			pool.execute([opened] () { opened.wait(); });
+			for (int i = 0; i < taskCount; ++i)
+				pool.execute([&executed] () { ++executed; });
+
+			gate.set_value();
+		}
+
+		check(executed == taskCount, "destructor executed pending tasks, got " + std::to_string(executed.load()));
+	}
+
+	// Exceptions thrown by tasks reach their futures
+	void testSubmitException()
+	{
+		aurora::WorkerPool pool(2);
+		std::future<int> result = pool.submit([] () -> int { throw std::runtime_error("task"); });
+
+		bool thrown = false;
+		try
+		{
+			result.get();
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		check(thrown, "exception of a task reaches the future");
+	}
+
+	struct Shape
+	{
+		virtual ~Shape()
+		{
+		}
+	};
+
+	struct Circle : Shape {};
+	struct Square : Shape {};
+
+	typedef aurora::SingleDispatcher<std::thread::id(const Shape&)> ShapeDispatcher;
+
+	// callAsync() with a policy: Inline keys run on the calling thread and return a ready future, others use the pool
+	void testCallAsync()
+	{
+		ShapeDispatcher dispatcher;
+		dispatcher.bind(aurora::Type<Circle>(), [] (const Circle&) { return std::this_thread::get_id(); });
+		dispatcher.bind(aurora::Type<Square>(), [] (const Square&) -> std::thread::id { throw std::runtime_error("square"); });
+
+		aurora::AsyncPolicy<ShapeDispatcher::KeyTraits> policy;
+		policy.mode(aurora::Type<Circle>(), aurora::AsyncMode::Inline);
+
+		const Circle circle;
+		std::future<std::thread::id> inlineResult = aurora::callAsync(policy, dispatcher, circle);
+		check(inlineResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready, "Inline mode returns a ready future");
+		check(inlineResult.get() == std::this_thread::get_id(), "Inline mode executes on the calling thread");
+
+		std::future<std::thread::id> poolResult = aurora::callAsync(dispatcher, circle);
+		check(poolResult.get() != std::this_thread::get_id(), "Pool mode executes on a worker");
+
+		// Exceptions of the dispatched function, in either mode
+		const Square square;
+		for (int inlineMode = 0; inlineMode < 2; ++inlineMode)
+		{
+			policy.mode(aurora::Type<Square>(), inlineMode ? aurora::AsyncMode::Inline : aurora::AsyncMode::Pool);
+			std::future<std::thread::id> result = aurora::callAsync(policy, dispatcher, square);
+
+			bool thrown = false;
+			try
+			{
+				result.get();
+			}
+			catch (const std::runtime_error&)
+			{
+				thrown = true;
+			}
+
+			check(thrown, std::string("exception reaches the future in ") + (inlineMode ? "Inline" : "Pool") + " mode");
+		}
+	}
+
+} // namespace
+
+
+int main()
+{
+	testSubmitFromOutside();
+	testSubmitFromWorker();
+	testSleepAndWake();
+	testDestructorDrains();
+	testSubmitException();
+	testCallAsync();
+
+	return bench::testResult("AsyncStressTest: " + std::to_string(submitterCount) + " submitters, passed");
+}
@@ -0,0 +1,177 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Minimal benchmark harness: times a function over several repetitions and writes one CSV row per measurement.
+
+#ifndef AURORA_BENCH_BENCHMARK_HPP
+#define AURORA_BENCH_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace bench
+{
+
+	// Stores a value where the compiler cannot see it, so that the computation producing it is not optimized away
+	template <typename T>
+	void keep(const T& value)
+	{
+		static volatile std::uint64_t sink;
+		sink = sink + static_cast<std::uint64_t>(value);
+	}
+
+	// Deterministic random number generator (xorshift64*), so that all runs use the same workload
+	class Random
+	{
+		public:
+			explicit Random(std::uint64_t seed = 0x9e3779b97f4a7c15ull)
+			: mState(seed)
+			{
+			}
+
+			std::uint64_t next()
+			{
+				mState ^= mState >> 12;
+				mState ^= mState << 25;
+				mState ^= mState >> 27;
+				return mState * 0x2545f4914f6cdd1dull;
+			}
+
+			// Returns a number in [0, bound)
+			std::size_t below(std::size_t bound)
+			{
+				return static_cast<std::size_t>(next() % bound);
+			}
+
+		private:
+			std::uint64_t mState;
+	};
+
+	// Indices of the types in a workload. Skewed workloads follow a Zipf distribution (s = 1): the type with index i is
+	// chosen with a probability proportional to 1 / (i + 1).
+	inline std::vector<std::size_t> typeSequence(std::size_t length, std::size_t types, bool skewed, Random& random)
+	{
+		std::vector<double> cumulative(types);
+		double sum = 0.0;
+		for (std::size_t i = 0; i < types; ++i)
+			cumulative[i] = (sum += skewed ? 1.0 / static_cast<double>(i + 1) : 1.0);
+
+		std::vector<std::size_t> sequence(length);
+		for (std::size_t& index : sequence)
+		{
+			const double x = static_cast<double>(random.next() >> 11) / 9007199254740992.0 * sum;
+			index = std::min<std::size_t>(std::upper_bound(cumulative.begin(), cumulative.end(), x) - cumulative.begin(), types - 1);
+		}
+
+		return sequence;
+	}
+
+	// Runs benchmarks and writes the results to stdout, as CSV with the columns
+	// suite, benchmark, implementation, parameters, operations, ns_per_op, mops_per_s.
+	// Parameters are space-separated key=value pairs. Command line options:
+	//  --quick        few operations and a single repetition, for smoke tests
+	//  --filter text  only run benchmarks whose "benchmark,implementation" contains text
+	class Reporter
+	{
+		public:
+			Reporter(const std::string& suite, int argc, char** argv)
+			: mSuite(suite)
+			, mFilter()
+			, mQuick(false)
+			{
+				for (int i = 1; i < argc; ++i)
+				{
+					if (std::strcmp(argv[i], "--quick") == 0)
+						mQuick = true;
+					else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+						mFilter = argv[++i];
+					else
+					{
+						std::cerr << "Usage: " << argv[0] << " [--quick] [--filter text]\n";
+						std::exit(2);
+					}
+				}
+
+				std::cout << "suite,benchmark,implementation,parameters,operations,ns_per_op,mops_per_s\n";
+			}
+
+			bool quick() const
+			{
+				return mQuick;
+			}
+
+			// Reduces an operation count in quick mode
+			std::size_t scale(std::size_t operations) const
+			{
+				return mQuick ? std::max<std::size_t>(operations / 256, 1) : operations;
+			}
+
+			// Calls function() once for warming up, then repeatedly, and reports the median time per operation.
+			// function performs the given number of operations per invocation.
+			template <typename Fn>
+			void run(const std::string& benchmark, const std::string& implementation, const std::string& parameters,
+				std::size_t operations, Fn function)
+			{
+				if (!mFilter.empty() && (benchmark + "," + implementation).find(mFilter) == std::string::npos)
+					return;
+
+				typedef std::chrono::steady_clock Clock;
+
+				function();
+
+				std::vector<double> times;
+				const std::size_t repetitions = mQuick ? 1 : 7;
+				for (std::size_t i = 0; i < repetitions; ++i)
+				{
+					const Clock::time_point start = Clock::now();
+					function();
+					const Clock::time_point end = Clock::now();
+
+					times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+				}
+
+				std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+				const double nsPerOp = times[times.size() / 2] / static_cast<double>(operations);
+
+				std::cout << mSuite << ',' << benchmark << ',' << implementation << ',' << parameters << ',' << operations
+					<< ',' << nsPerOp << ',' << 1000.0 / nsPerOp << std::endl;
+			}
+
+		private:
+			std::string		mSuite;
+			std::string		mFilter;
+			bool			mQuick;
+	};
+
+} // namespace bench
+
+#endif // AURORA_BENCH_BENCHMARK_HPP
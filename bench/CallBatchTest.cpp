@@ -0,0 +1,202 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Test for SingleDispatcher::callBatch(): grouping order, the fallback group, exceptions before any call, and batches
+// started from within a dispatched function. Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <vector>
+#include <string>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	struct Base
+	{
+		explicit Base(int id)
+		: id(id)
+		{
+		}
+
+		virtual ~Base()
+		{
+		}
+
+		int id;
+	};
+
+	struct A : Base { explicit A(int id) : Base(id) {} };
+	struct B : Base { explicit B(int id) : Base(id) {} };
+	struct C : Base { explicit C(int id) : Base(id) {} };
+	struct DerivedA : A { explicit DerivedA(int id) : A(id) {} };
+
+	typedef std::vector<int> Log;
+	typedef aurora::SingleDispatcher<void(Base&, Log&)> Dispatcher;
+
+	std::string toString(const Log& log)
+	{
+		std::string result;
+		for (int id : log)
+			result += std::to_string(id) + " ";
+
+		return result;
+	}
+
+	void record(Base& object, Log& log)
+	{
+		log.push_back(object.id);
+	}
+
+	// Groups are invoked in the order of their first object, objects within a group in the order of the range
+	void testGrouping()
+	{
+		Dispatcher dispatcher(true);
+		dispatcher.bind(aurora::Type<A>(), [] (A& a, Log& log) { record(a, log); });
+		dispatcher.bind(aurora::Type<B>(), [] (B& b, Log& log) { log.push_back(100 + b.id); });
+
+		B b1(1), b4(4);
+		A a2(2), a6(6);
+		DerivedA d5(5);
+		C c3(3), c7(7);
+
+		// DerivedA is resolved to the function of A and shares its group; C objects go to the fallback group
+		std::vector<Base*> objects = { &b1, &a2, &c3, &b4, &d5, &a6, &c7 };
+
+		bool thrown = false;
+		Log log;
+		try
+		{
+			dispatcher.callBatch(objects.begin(), objects.end(), log);
+		}
+		catch (const aurora::FunctionCallException&)
+		{
+			thrown = true;
+		}
+
+		check(thrown && log.empty(), "unregistered key without fallback throws before any call");
+
+		dispatcher.fallback([] (Base& object, Log& log) { log.push_back(-object.id); });
+		dispatcher.callBatch(objects.begin(), objects.end(), log);
+		check(log == Log({ 101, 104, 2, 5, 6, -3, -7 }), "grouping order, got " + toString(log));
+
+		// Range of objects instead of pointers
+		std::vector<B> values = { B(1), B(2), B(3) };
+		log.clear();
+		dispatcher.callBatch(values.begin(), values.end(), log);
+		check(log == Log({ 101, 102, 103 }), "range of objects, got " + toString(log));
+
+		// Empty range
+		log.clear();
+		dispatcher.callBatch(objects.end(), objects.end(), log);
+		check(log.empty(), "empty range");
+	}
+
+	// A dispatched function starts another batch, which must not overwrite the buffers of the enclosing one
+	void testNested()
+	{
+		Dispatcher dispatcher;
+
+		B b1(1), b2(2), b3(3);
+		C c4(4), c5(5);
+		A a3(3);
+		std::vector<Base*> inner = { &b1, &c4, &b2, &c5, &b3 };
+		std::vector<Base*> nested = { &a3 };
+
+		dispatcher.bind(aurora::Type<B>(), [] (B& b, Log& log) { record(b, log); });
+		dispatcher.bind(aurora::Type<C>(), [] (C& c, Log& log) { record(c, log); });
+		dispatcher.bind(aurora::Type<A>(), [&dispatcher, &inner, &nested] (A& a, Log& log)
+		{
+			log.push_back(10 * a.id);
+
+			// For a.id == 2, the batch of a3 starts a third level of batches
+			if (a.id == 2)
+				dispatcher.callBatch(nested.begin(), nested.end(), log);
+
+			dispatcher.callBatch(inner.begin(), inner.end(), log);
+		});
+
+		A a1(1), a2(2);
+		C c6(6);
+		std::vector<Base*> outer = { &a1, &c6, &a2 };
+
+		Log log;
+		dispatcher.callBatch(outer.begin(), outer.end(), log);
+		check(log == Log({ 10, 1, 2, 3, 4, 5, 20, 30, 1, 2, 3, 4, 5, 1, 2, 3, 4, 5, 6 }), "nested batches, got " + toString(log));
+
+		// The thread's buffers are released again
+		log.clear();
+		dispatcher.callBatch(inner.begin(), inner.end(), log);
+		check(log == Log({ 1, 2, 3, 4, 5 }), "batch after nested batches, got " + toString(log));
+	}
+
+	// A function that throws leaves the buffers usable for the next batch
+	void testThrow()
+	{
+		Dispatcher dispatcher;
+		dispatcher.bind(aurora::Type<A>(), [] (A& a, Log& log)
+		{
+			record(a, log);
+			if (a.id == 1)
+				throw 42;
+		});
+
+		A a1(1), a2(2);
+		std::vector<Base*> objects = { &a1, &a2 };
+
+		Log log;
+		bool thrown = false;
+		try
+		{
+			dispatcher.callBatch(objects.begin(), objects.end(), log);
+		}
+		catch (int)
+		{
+			thrown = true;
+		}
+
+		check(thrown && log == Log({ 1 }), "exception of a function is propagated");
+
+		log.clear();
+		dispatcher.callBatch(objects.begin() + 1, objects.end(), log);
+		check(log == Log({ 2 }), "batch after an exception, got " + toString(log));
+	}
+
+} // namespace
+
+
+int main()
+{
+	testGrouping();
+	testNested();
+	testThrow();
+
+	return bench::testResult("CallBatchTest: passed");
+}
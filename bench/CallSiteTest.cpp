@@ -0,0 +1,174 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Test for SingleDispatcher::CallSite: cache hits and misses, round-robin replacement, and invalidation when the
+// dispatcher is modified by bind() or seal(). Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <string>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	struct Base
+	{
+		virtual ~Base()
+		{
+		}
+	};
+
+	struct A : Base {};
+	struct B : Base {};
+	struct C : Base {};
+	struct D : Base {};
+
+	typedef aurora::SingleDispatcher<std::string(Base&)> Dispatcher;
+
+	template <typename T>
+	void bindName(Dispatcher& dispatcher, const char* name)
+	{
+		dispatcher.bind(aurora::Type<T>(), [name] (T&) { return std::string(name); });
+	}
+
+	// Site must pick up a function bound after the key has been cached
+	void testRebind()
+	{
+		Dispatcher dispatcher;
+		bindName<A>(dispatcher, "a1");
+
+		Dispatcher::CallSite<> site;
+
+		A a;
+		check(site.call(dispatcher, a) == "a1", "first call");
+		check(site.call(dispatcher, a) == "a1", "cached call");
+		check(site.hits() == 1u && site.misses() == 1u, "one hit after the first miss");
+
+		bindName<A>(dispatcher, "a2");
+		check(site.call(dispatcher, a) == "a2", "call after rebinding the cached key");
+		check(site.misses() == 2u, "bind() invalidates the cache");
+
+		check(site.call(dispatcher, a) == "a2", "cached call after rebinding");
+		check(site.hits() == 2u, "new function is cached");
+
+		// Binding an unrelated key invalidates the cache, too
+		bindName<B>(dispatcher, "b");
+		check(site.call(dispatcher, a) == "a2", "call after binding another key");
+		check(site.misses() == 3u, "bind() of another key invalidates the cache");
+	}
+
+	// With 2 entries, keys are replaced in the order they were inserted
+	void testRoundRobin()
+	{
+		Dispatcher dispatcher;
+		bindName<A>(dispatcher, "a");
+		bindName<B>(dispatcher, "b");
+		bindName<C>(dispatcher, "c");
+
+		Dispatcher::CallSite<2> site;
+
+		A a;
+		B b;
+		C c;
+		check(site.call(dispatcher, a) == "a", "round robin: a");
+		check(site.call(dispatcher, b) == "b", "round robin: b");
+		check(site.call(dispatcher, a) == "a", "round robin: a again");
+		check(site.hits() == 1u && site.misses() == 2u, "round robin: a and b cached");
+
+		// c replaces a, the oldest entry, although a was used more recently
+		check(site.call(dispatcher, c) == "c", "round robin: c");
+		check(site.call(dispatcher, b) == "b", "round robin: b still cached");
+		check(site.hits() == 2u && site.misses() == 3u, "round robin: b hit after c");
+
+		check(site.call(dispatcher, a) == "a", "round robin: a evicted");
+		check(site.misses() == 4u, "round robin: a missed after eviction");
+
+		// a replaced b, so c is still there
+		check(site.call(dispatcher, c) == "c", "round robin: c still cached");
+		check(site.hits() == 3u, "round robin: c hit");
+		check(site.hitRate() == 3.f / 7.f, "round robin: hit rate");
+	}
+
+	// Sealing may relocate the functions, the site must not use the old ones
+	void testSeal()
+	{
+		aurora::SingleDispatcher<std::string(Base&), aurora::RttiDispatchTraits<std::string(Base&), 1>, aurora::PerfectHashStorage> dispatcher;
+		dispatcher.bind(aurora::Type<A>(), [] (A&) { return std::string("a"); });
+		dispatcher.bind(aurora::Type<B>(), [] (B&) { return std::string("b"); });
+
+		decltype(dispatcher)::CallSite<> site;
+
+		A a;
+		B b;
+		check(site.call(dispatcher, a) == "a" && site.call(dispatcher, b) == "b", "calls before seal()");
+
+		dispatcher.seal();
+		check(site.call(dispatcher, a) == "a" && site.call(dispatcher, b) == "b", "calls after seal()");
+		check(site.hits() == 0u && site.misses() == 4u, "seal() invalidates the cache");
+
+		check(site.call(dispatcher, a) == "a", "cached call after seal()");
+		check(site.hits() == 1u, "cached after seal()");
+	}
+
+	// Site used alternately with two dispatchers, and unregistered keys that go to the fallback
+	void testDispatchersAndFallback()
+	{
+		Dispatcher first;
+		Dispatcher second;
+		bindName<A>(first, "first");
+		bindName<A>(second, "second");
+		second.fallback([] (Base&) { return std::string("fallback"); });
+
+		Dispatcher::CallSite<> site;
+
+		A a;
+		D d;
+		check(site.call(first, a) == "first", "first dispatcher");
+		check(site.call(second, a) == "second", "second dispatcher");
+		check(site.call(first, a) == "first", "first dispatcher again");
+		check(site.misses() == 3u, "switching dispatchers invalidates the cache");
+
+		check(site.call(second, d) == "fallback", "unregistered key invokes the fallback");
+		check(site.call(second, d) == "fallback", "unregistered key invokes the fallback again");
+		check(site.misses() == 5u, "unregistered keys are not cached");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testRebind();
+	testRoundRobin();
+	testSeal();
+	testDispatchersAndFallback();
+
+	return bench::testResult("CallSiteTest: passed");
+}
@@ -0,0 +1,142 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Scaling of call() with 1 to 32 reader threads: ConcurrentDispatcher compared with a SingleDispatcher that is not
+// modified (no synchronization) and one protected by a mutex. Optionally, a writer rebinds a function every millisecond.
+// ns_per_op is the wall-clock time divided by the total number of calls of all threads.
+
+#include "Benchmark.hpp"
+#include "Hierarchy.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	typedef Family<32> F;
+	typedef aurora::SingleDispatcher<int(const Base&)> Dispatcher;
+
+	const std::size_t workloadLength = 4096;
+	const std::size_t mask = workloadLength - 1;
+
+	// Runs call() on the given number of threads, each performing operations/threads calls
+	template <typename Fn>
+	void runReaders(Reporter& reporter, const std::string& implementation, std::size_t threads, bool writer,
+		const Workload<F>& workload, Fn call, std::function<void()> modify)
+	{
+		const std::size_t perThread = reporter.scale(1u << 20);
+		const std::string params = "threads=" + std::to_string(threads) + " writer=" + (writer ? "1" : "0");
+
+		reporter.run("concurrent_call", implementation, params, perThread * threads, [&] ()
+		{
+			std::atomic<bool> done(false);
+			std::thread writerThread;
+			if (writer)
+			{
+				writerThread = std::thread([&] ()
+				{
+					while (!done.load())
+					{
+						modify();
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+				});
+			}
+
+			std::vector<std::thread> readers;
+			for (std::size_t t = 0; t < threads; ++t)
+			{
+				readers.emplace_back([&, t] ()
+				{
+					int sum = 0;
+					for (std::size_t i = 0; i < perThread; ++i)
+						sum += call(*workload.objects[(i + t * 97) & mask]);
+
+					keep(sum);
+				});
+			}
+
+			for (std::thread& reader : readers)
+				reader.join();
+
+			done = true;
+			if (writer)
+				writerThread.join();
+		});
+	}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	Reporter reporter("concurrent", argc, argv);
+	const Workload<F> workload(workloadLength, false, 100u);
+
+	Dispatcher plain;
+	F::bindAll(plain);
+
+	Dispatcher locked;
+	F::bindAll(locked);
+	std::mutex mutex;
+
+	aurora::ConcurrentDispatcher<Dispatcher> concurrent;
+	F::bindAll(concurrent);
+
+	for (std::size_t threads : { 1u, 2u, 4u, 8u, 16u, 32u })
+	{
+		runReaders(reporter, "SingleDispatcher/unsynchronized", threads, false, workload,
+			[&] (const Base& b) { return plain.call(b); }, nullptr);
+
+		for (bool writer : { false, true })
+		{
+			runReaders(reporter, "SingleDispatcher/mutex", threads, writer, workload, [&] (const Base& b)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				return locked.call(b);
+			},
+			[&] ()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				locked.bind(aurora::Type<Derived<0>>(), Handler<0>());
+			});
+
+			runReaders(reporter, "ConcurrentDispatcher", threads, writer, workload,
+				[&] (const Base& b) { return concurrent.call(b); },
+				[&] () { concurrent.bind(aurora::Type<Derived<0>>(), Handler<0>()); });
+		}
+	}
+}
@@ -0,0 +1,182 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Stress test for ConcurrentDispatcher: reader threads call the dispatcher while another thread keeps binding functions.
+// Checks that readers only observe complete, published functions, in publication order. Exits with status 1 on failure.
+// Meant to be run under ThreadSanitizer as well (configure with -DAURORA_SANITIZER=thread).
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	const int readerCount = 4;
+	const int bindCount = 2000;
+
+	// Phase 1: the binder registers keys 0, 1, ..., bindCount-1; the function of key k returns 2k+1
+	struct Event
+	{
+		int key;
+	};
+
+	struct EventTraits : aurora::DispatchTraits<int>
+	{
+		static int keyFromBase(const Event& event)
+		{
+			return event.key;
+		}
+	};
+
+	typedef aurora::SingleDispatcher<int(const Event&), EventTraits, aurora::HashStorage, aurora::DispatchStatistics> EventDispatcher;
+
+	void testBindWhileCalling()
+	{
+		aurora::ConcurrentDispatcher<EventDispatcher> dispatcher;
+		std::atomic<bool> done(false);
+		std::atomic<long long> hits(0);
+
+		std::vector<std::thread> readers;
+		for (int r = 0; r < readerCount; ++r)
+		{
+			readers.emplace_back([&, r] ()
+			{
+				// Keys are bound in ascending order, so once key k is seen, all keys below k must be bound
+				int highestSeen = -1;
+				unsigned int random = 12345u + static_cast<unsigned int>(r);
+				long long localHits = 0;
+
+				while (!done.load())
+				{
+					random = random * 1103515245u + 12345u;
+					const Event event = { static_cast<int>((random >> 8) % bindCount) };
+
+					aurora::Optional<int> result = dispatcher.tryCall(event);
+					if (result)
+					{
+						++localHits;
+						check(*result == 2 * event.key + 1, "function of key " + std::to_string(event.key) + " returned " + std::to_string(*result));
+						highestSeen = std::max(highestSeen, event.key);
+					}
+					else
+					{
+						check(event.key > highestSeen, "key " + std::to_string(event.key) + " vanished after key " + std::to_string(highestSeen) + " was seen");
+					}
+				}
+
+				hits += localHits;
+			});
+		}
+
+		for (int k = 0; k < bindCount; ++k)
+			dispatcher.bind(k, [k] (const Event&) { return 2 * k + 1; });
+
+		done = true;
+		for (std::thread& reader : readers)
+			reader.join();
+
+		for (int k = 0; k < bindCount; ++k)
+			check(dispatcher.contains(k), "key " + std::to_string(k) + " not bound at the end");
+
+		// Statistics are shared by all snapshots
+		long long recorded = 0;
+		for (const aurora::DispatchReport::Entry& entry : dispatcher.statistics().entries)
+			recorded += static_cast<long long>(entry.calls);
+
+		check(recorded == hits.load(), "statistics recorded " + std::to_string(recorded) + " calls instead of " + std::to_string(hits.load()));
+	}
+
+	// Phase 2: base class resolution. Readers call with Leaf objects, which have no own function; the binder rebinds the
+	// function of Mid with increasing versions. Every reader must observe non-decreasing versions.
+	struct Base
+	{
+		virtual ~Base()
+		{
+		}
+	};
+
+	struct Mid : Base
+	{
+	};
+
+	struct Leaf : Mid
+	{
+	};
+
+	void testResolveWhileBinding()
+	{
+		aurora::ConcurrentDispatcher<aurora::SingleDispatcher<int(const Base&)>> dispatcher(true);
+		dispatcher.bind(aurora::Type<Base>(), [] (const Base&) { return -1; });
+
+		std::atomic<bool> done(false);
+		std::vector<std::thread> readers;
+		for (int r = 0; r < readerCount; ++r)
+		{
+			readers.emplace_back([&] ()
+			{
+				const Leaf leaf;
+				int lastVersion = -1;
+
+				while (!done.load())
+				{
+					const int version = dispatcher.call(leaf);
+					check(version >= lastVersion, "version " + std::to_string(version) + " observed after " + std::to_string(lastVersion));
+					lastVersion = version;
+				}
+			});
+		}
+
+		for (int v = 0; v < bindCount; ++v)
+			dispatcher.bind(aurora::Type<Mid>(), [v] (const Mid&) { return v; });
+
+		done = true;
+		for (std::thread& reader : readers)
+			reader.join();
+
+		// No reader is left, so all retired snapshots can be deleted
+		dispatcher.collect();
+		check(dispatcher.call(Leaf()) == bindCount - 1, "final version not observed");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testBindWhileCalling();
+	testResolveWhileBinding();
+
+	return bench::testResult("ConcurrentStressTest: " + std::to_string(readerCount) + " readers, "
+		+ std::to_string(bindCount) + " binds per phase, passed");
+}
@@ -0,0 +1,278 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Compares SingleDispatcher and DoubleDispatcher with virtual functions, std::visit and dynamic_cast chains.
+// Measures bind cost, call throughput (independent calls) and latency (each call depends on the previous result),
+// for 4, 32 and 512 classes, uniform and skewed type distributions, hit ratios and with or without user data.
+
+#include "Benchmark.hpp"
+#include "Hierarchy.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <string>
+#include <variant>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	const std::size_t workloadLength = 4096;
+	const std::size_t mask = workloadLength - 1;
+
+	typedef aurora::RttiDispatchTraits<int(const Base&), 1>				RttiTraits;
+	typedef aurora::RttiDispatchTraits<int(const Base&, int), 1>		RttiDataTraits;
+	typedef aurora::DenseDispatchTraits<int(const Base&), 1>			DenseTraits;
+	typedef aurora::DenseDispatchTraits<int(const Base&, int), 1>		DenseDataTraits;
+
+	std::string parameters(std::size_t types, bool skewed, unsigned int hitPercent, bool userData)
+	{
+		return "types=" + std::to_string(types) + " distribution=" + (skewed ? "zipf" : "uniform")
+			+ " hit=" + std::to_string(hitPercent) + " userdata=" + (userData ? "1" : "0");
+	}
+
+	// Throughput: independent calls over the workload
+	template <typename Fn>
+	void runThroughput(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const std::vector<const Base*>& objects, Fn call)
+	{
+		const std::size_t operations = reporter.scale(1u << 22);
+		reporter.run("call_throughput", implementation, params, operations, [&] ()
+		{
+			int sum = 0;
+			for (std::size_t i = 0; i < operations; ++i)
+				sum += call(*objects[i & mask]);
+
+			keep(sum);
+		});
+	}
+
+	// Latency: the next object depends on the result of the previous call, so calls cannot overlap
+	template <typename Fn>
+	void runLatency(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const std::vector<const Base*>& objects, Fn call)
+	{
+		const std::size_t operations = reporter.scale(1u << 20);
+		reporter.run("call_latency", implementation, params, operations, [&] ()
+		{
+			std::size_t index = 0;
+			for (std::size_t i = 0; i < operations; ++i)
+				index = (index + 1 + static_cast<std::size_t>(call(*objects[index]) & 1)) & mask;
+
+			keep(index);
+		});
+	}
+
+	// Constructs dispatchers and registers the functions for all classes
+	template <class F, class Dispatcher>
+	void runBind(Reporter& reporter, const std::string& implementation)
+	{
+		const std::size_t rounds = reporter.scale(2048) / F::size + 1;
+		reporter.run("bind", implementation, "types=" + std::to_string(F::size), rounds * F::size, [&] ()
+		{
+			for (std::size_t i = 0; i < rounds; ++i)
+			{
+				Dispatcher dispatcher;
+				F::bindAll(dispatcher);
+				keep(dispatcher.contains(aurora::Type<Derived<0>>()));
+			}
+		});
+	}
+
+	template <class F>
+	void runFamily(Reporter& reporter)
+	{
+		// Bind cost
+		runBind<F, aurora::SingleDispatcher<int(const Base&), RttiTraits, aurora::HashStorage>>(reporter, "SingleDispatcher/Rtti/HashStorage");
+		runBind<F, aurora::SingleDispatcher<int(const Base&), RttiTraits, aurora::FlatStorage>>(reporter, "SingleDispatcher/Rtti/FlatStorage");
+		runBind<F, aurora::SingleDispatcher<int(const Base&), DenseTraits, aurora::DenseStorage>>(reporter, "SingleDispatcher/Dense/DenseStorage");
+
+		aurora::SingleDispatcher<int(const Base&), RttiTraits, aurora::HashStorage> rttiHash;
+		aurora::SingleDispatcher<int(const Base&), RttiTraits, aurora::FlatStorage> rttiFlat;
+		aurora::SingleDispatcher<int(const Base&), DenseTraits, aurora::DenseStorage> dense;
+		aurora::SingleDispatcher<int(const Base&, int), RttiDataTraits, aurora::HashStorage> rttiHashData;
+		aurora::SingleDispatcher<int(const Base&, int), RttiDataTraits, aurora::FlatStorage> rttiFlatData;
+		aurora::SingleDispatcher<int(const Base&, int), DenseDataTraits, aurora::DenseStorage> denseData;
+
+		F::bindAll(rttiHash);
+		F::bindAll(rttiFlat);
+		F::bindAll(dense);
+		F::bindAll(rttiHashData);
+		F::bindAll(rttiFlatData);
+		F::bindAll(denseData);
+
+		// Misses invoke the fallback function
+		rttiHash.fallback(aurora::NoOp<int, 1>());
+		rttiFlat.fallback(aurora::NoOp<int, 1>());
+		dense.fallback(aurora::NoOp<int, 1>());
+		rttiHashData.fallback(aurora::NoOp<int, 2>());
+		rttiFlatData.fallback(aurora::NoOp<int, 2>());
+		denseData.fallback(aurora::NoOp<int, 2>());
+
+		for (bool skewed : { false, true })
+		{
+			for (unsigned int hitPercent : { 100u, 90u, 50u })
+			{
+				const Workload<F> workload(workloadLength, skewed, hitPercent);
+				const std::vector<const Base*>& objects = workload.objects;
+				const std::string params = parameters(F::size, skewed, hitPercent, false);
+				const std::string dataParams = parameters(F::size, skewed, hitPercent, true);
+
+				runThroughput(reporter, "SingleDispatcher/Rtti/HashStorage", params, objects, [&] (const Base& b) { return rttiHash.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Rtti/FlatStorage", params, objects, [&] (const Base& b) { return rttiFlat.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Dense/DenseStorage", params, objects, [&] (const Base& b) { return dense.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Rtti/HashStorage", dataParams, objects, [&] (const Base& b) { return rttiHashData.call(b, 7); });
+				runThroughput(reporter, "SingleDispatcher/Rtti/FlatStorage", dataParams, objects, [&] (const Base& b) { return rttiFlatData.call(b, 7); });
+				runThroughput(reporter, "SingleDispatcher/Dense/DenseStorage", dataParams, objects, [&] (const Base& b) { return denseData.call(b, 7); });
+
+				// The alternatives have no notion of unregistered classes
+				if (hitPercent != 100u)
+					continue;
+
+				runThroughput(reporter, "virtual", params, objects, [] (const Base& b) { return b.virtualCall(); });
+				runThroughput(reporter, "virtual", dataParams, objects, [] (const Base& b) { return b.virtualCall(7); });
+
+				runLatency(reporter, "SingleDispatcher/Rtti/HashStorage", params, objects, [&] (const Base& b) { return rttiHash.call(b); });
+				runLatency(reporter, "SingleDispatcher/Rtti/FlatStorage", params, objects, [&] (const Base& b) { return rttiFlat.call(b); });
+				runLatency(reporter, "SingleDispatcher/Dense/DenseStorage", params, objects, [&] (const Base& b) { return dense.call(b); });
+				runLatency(reporter, "virtual", params, objects, [] (const Base& b) { return b.virtualCall(); });
+
+				// Long chains and variants with hundreds of alternatives are impractical
+				if constexpr (F::size <= 32)
+				{
+					runThroughput(reporter, "dynamic_cast", params, objects, [] (const Base& b) { return F::castChain(b); });
+					runLatency(reporter, "dynamic_cast", params, objects, [] (const Base& b) { return F::castChain(b); });
+
+					std::vector<typename F::Variant> variants;
+					for (std::size_t i = 0; i < workloadLength; ++i)
+						variants.push_back(F::createVariant(workload.types[i], objects[i]->payload));
+
+					auto visitor = [] (const auto& object)
+					{
+						return object.payload + static_cast<int>(std::decay_t<decltype(object)>::index);
+					};
+
+					const std::size_t operations = reporter.scale(1u << 22);
+					reporter.run("call_throughput", "std::visit", params, operations, [&] ()
+					{
+						int sum = 0;
+						for (std::size_t i = 0; i < operations; ++i)
+							sum += std::visit(visitor, variants[i & mask]);
+
+						keep(sum);
+					});
+				}
+			}
+		}
+	}
+
+	// DoubleDispatcher with all ordered pairs registered, compared with std::visit on two variants
+	template <class F>
+	void runPairs(Reporter& reporter)
+	{
+		typedef aurora::RttiDispatchTraits<int(const Base&, const Base&), 2>		PairTraits;
+		typedef aurora::DenseDispatchTraits<int(const Base&, const Base&), 2>		DensePairTraits;
+
+		aurora::DoubleDispatcher<int(const Base&, const Base&), PairTraits, aurora::HashStorage> rttiHash(false);
+		aurora::DoubleDispatcher<int(const Base&, const Base&), PairTraits, aurora::FlatStorage> rttiFlat(false);
+		aurora::DoubleDispatcher<int(const Base&, const Base&), DensePairTraits, aurora::DenseStorage> dense(false);
+
+		const std::size_t bindRounds = reporter.quick() ? 1 : 8;
+		reporter.run("bind", "DoubleDispatcher/Rtti/HashStorage", "types=" + std::to_string(F::size), bindRounds * F::size * F::size, [&] ()
+		{
+			for (std::size_t i = 0; i < bindRounds; ++i)
+			{
+				aurora::DoubleDispatcher<int(const Base&, const Base&), PairTraits, aurora::HashStorage> dispatcher(false);
+				F::bindAllPairs(dispatcher);
+				keep(dispatcher.contains(aurora::Type<Derived<0>>(), aurora::Type<Derived<0>>()));
+			}
+		});
+
+		F::bindAllPairs(rttiHash);
+		F::bindAllPairs(rttiFlat);
+		F::bindAllPairs(dense);
+
+		for (bool skewed : { false, true })
+		{
+			const Workload<F> first(workloadLength, skewed, 100u, 1);
+			const Workload<F> second(workloadLength, skewed, 100u, 2);
+			const std::string params = parameters(F::size, skewed, 100u, false);
+			const std::size_t operations = reporter.scale(1u << 21);
+
+			auto runPairThroughput = [&] (const std::string& implementation, auto call)
+			{
+				reporter.run("pair_throughput", implementation, params, operations, [&] ()
+				{
+					int sum = 0;
+					for (std::size_t i = 0; i < operations; ++i)
+						sum += call(*first.objects[i & mask], *second.objects[(i * 7) & mask]);
+
+					keep(sum);
+				});
+			};
+
+			runPairThroughput("DoubleDispatcher/Rtti/HashStorage", [&] (const Base& a, const Base& b) { return rttiHash.call(a, b); });
+			runPairThroughput("DoubleDispatcher/Rtti/FlatStorage", [&] (const Base& a, const Base& b) { return rttiFlat.call(a, b); });
+			runPairThroughput("DoubleDispatcher/Dense/DenseStorage", [&] (const Base& a, const Base& b) { return dense.call(a, b); });
+
+			std::vector<typename F::Variant> lhs, rhs;
+			for (std::size_t i = 0; i < workloadLength; ++i)
+			{
+				lhs.push_back(F::createVariant(first.types[i], first.objects[i]->payload));
+				rhs.push_back(F::createVariant(second.types[i], second.objects[i]->payload));
+			}
+
+			auto visitor = [] (const auto& a, const auto& b)
+			{
+				return a.payload * static_cast<int>(std::decay_t<decltype(a)>::index) + b.payload * static_cast<int>(std::decay_t<decltype(b)>::index);
+			};
+
+			reporter.run("pair_throughput", "std::visit", params, operations, [&] ()
+			{
+				int sum = 0;
+				for (std::size_t i = 0; i < operations; ++i)
+					sum += std::visit(visitor, lhs[i & mask], rhs[(i * 7) & mask]);
+
+				keep(sum);
+			});
+		}
+	}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	Reporter reporter("dispatch", argc, argv);
+
+	runFamily<Family<4>>(reporter);
+	runFamily<Family<32>>(reporter);
+	runFamily<Family<512>>(reporter);
+
+	runPairs<Family<4>>(reporter);
+	runPairs<Family<32>>(reporter);
+}
@@ -0,0 +1,286 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Test for DispatchQueue: objects posted by several threads, and from functions invoked by drain(), are dispatched
+// exactly once, grouped by key and in posting order per thread. Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	const int producerCount = 4;
+	const int postCount = 3000;
+
+	// Number of Event objects alive, to check that the queue destroys its copies
+	std::atomic<int> liveEvents(0);
+
+	struct Event
+	{
+		Event(int thread, int sequence)
+		: thread(thread)
+		, sequence(sequence)
+		{
+			++liveEvents;
+		}
+
+		Event(const Event& origin)
+		: thread(origin.thread)
+		, sequence(origin.sequence)
+		{
+			++liveEvents;
+		}
+
+		virtual ~Event()
+		{
+			--liveEvents;
+		}
+
+		int thread;
+		int sequence;
+	};
+
+	struct Collision : Event { using Event::Event; };
+	struct Explosion : Event { using Event::Event; };
+	struct Spawn : Event { using Event::Event; };
+
+	struct Dispatched
+	{
+		std::type_index key;
+		int thread;
+		int sequence;
+	};
+
+	typedef aurora::SingleDispatcher<void(Event&, std::vector<Dispatched>&)> Dispatcher;
+	typedef aurora::DispatchQueue<Dispatcher> Queue;
+
+	void record(Event& event, std::vector<Dispatched>& log)
+	{
+		Dispatched dispatched = { typeid(event), event.thread, event.sequence };
+		log.push_back(dispatched);
+	}
+
+	// Objects of several producers: each dispatched once, each key in one run, per-thread order within a key preserved
+	void testProducers()
+	{
+		Dispatcher dispatcher;
+		dispatcher.bind(aurora::Type<Collision>(), [] (Collision& e, std::vector<Dispatched>& log) { record(e, log); });
+		dispatcher.bind(aurora::Type<Explosion>(), [] (Explosion& e, std::vector<Dispatched>& log) { record(e, log); });
+		dispatcher.bind(aurora::Type<Spawn>(), [] (Spawn& e, std::vector<Dispatched>& log) { record(e, log); });
+
+		Queue queue(dispatcher);
+
+		std::vector<std::thread> producers;
+		for (int t = 0; t < producerCount; ++t)
+		{
+			producers.emplace_back([&queue, t] ()
+			{
+				for (int i = 0; i < postCount; ++i)
+				{
+					switch ((i * 7 + t) % 3)
+					{
+						case 0: queue.post(Collision(t, i)); break;
+						case 1: queue.post(Explosion(t, i)); break;
+						default: queue.post(Spawn(t, i)); break;
+					}
+				}
+			});
+		}
+
+		for (std::thread& producer : producers)
+			producer.join();
+
+		std::vector<Dispatched> log;
+		check(queue.drain(log) == static_cast<std::size_t>(producerCount * postCount), "drain() returns the number of posted objects");
+		check(liveEvents == 0, "queue destroys its copies after drain()");
+
+		// Exactly once
+		std::vector<int> seen(producerCount * postCount, 0);
+		for (const Dispatched& d : log)
+			++seen[d.thread * postCount + d.sequence];
+
+		for (std::size_t i = 0; i < seen.size(); ++i)
+			check(seen[i] == 1, "object " + std::to_string(i) + " dispatched " + std::to_string(seen[i]) + " times");
+
+		// One contiguous run per key, and per-thread order within it
+		std::vector<std::type_index> finished;
+		std::vector<int> lastSequence(producerCount, -1);
+		for (std::size_t i = 0; i < log.size(); ++i)
+		{
+			if (i > 0 && log[i].key != log[i - 1].key)
+			{
+				finished.push_back(log[i - 1].key);
+				lastSequence.assign(producerCount, -1);
+			}
+
+			for (const std::type_index& key : finished)
+				check(key != log[i].key, std::string("key ") + log[i].key.name() + " dispatched in more than one run");
+
+			check(log[i].sequence > lastSequence[log[i].thread], "posting order within a key and thread");
+			lastSequence[log[i].thread] = log[i].sequence;
+		}
+
+		check(queue.drain(log) == 0u, "second drain() finds no objects");
+	}
+
+	// Objects posted by a function during drain() are dispatched by the next drain()
+	void testPostDuringDrain()
+	{
+		Dispatcher dispatcher;
+		Queue queue(dispatcher);
+
+		dispatcher.bind(aurora::Type<Collision>(), [&queue] (Collision& e, std::vector<Dispatched>& log)
+		{
+			record(e, log);
+			queue.post(Spawn(e.thread, e.sequence));
+		});
+		dispatcher.bind(aurora::Type<Spawn>(), [] (Spawn& e, std::vector<Dispatched>& log) { record(e, log); });
+
+		queue.post(Collision(0, 0));
+		queue.post(Collision(0, 1));
+
+		std::vector<Dispatched> log;
+		check(queue.drain(log) == 2u && log.size() == 2u, "first drain() dispatches only the posted objects");
+
+		log.clear();
+		check(queue.drain(log) == 2u && log.size() == 2u && log[0].key == typeid(Spawn) && log[1].sequence == 1,
+			"second drain() dispatches the objects posted during the first");
+		check(liveEvents == 0, "all copies destroyed");
+	}
+
+	// A throwing function: the exception propagates, and the remaining objects are destroyed without being dispatched
+	void testThrow()
+	{
+		Dispatcher dispatcher;
+		dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<Dispatched>&) { throw 42; });
+		dispatcher.bind(aurora::Type<Explosion>(), [] (Explosion& e, std::vector<Dispatched>& log) { record(e, log); });
+
+		Queue queue(dispatcher);
+		for (int i = 0; i < 10; ++i)
+		{
+			queue.post(Collision(0, i));
+			queue.post(Explosion(0, i));
+		}
+
+		std::vector<Dispatched> log;
+		bool thrown = false;
+		try
+		{
+			queue.drain(log);
+		}
+		catch (int)
+		{
+			thrown = true;
+		}
+
+		check(thrown, "exception propagates out of drain()");
+		check(log.size() == 0u || log.size() == 10u, "dispatching stops at the exception");
+		check(liveEvents == 0, "remaining objects destroyed after the exception");
+
+		log.clear();
+		check(queue.drain(log) == 0u && log.empty(), "remaining objects not dispatched later");
+	}
+
+	// Pairs of objects with integral keys: sorted by the key values, so each key pair is dispatched in one run
+	struct Numbered
+	{
+		int key;
+		int sequence;
+	};
+
+	struct NumberTraits : aurora::DispatchTraits<int>
+	{
+		static int keyFromBase(const Numbered& object)
+		{
+			return object.key;
+		}
+	};
+
+	typedef std::pair<int, int> KeyPair;
+	typedef aurora::DoubleDispatcher<void(const Numbered&, const Numbered&, std::vector<KeyPair>&), NumberTraits> PairDispatcher;
+
+	void testPairs()
+	{
+		const int firstKeys = 300;
+		const int secondKeys = 3;
+
+		PairDispatcher dispatcher;
+		for (int k1 = 0; k1 < firstKeys; ++k1)
+		{
+			for (int k2 = 0; k2 < secondKeys; ++k2)
+			{
+				dispatcher.bind(k1, k2, [] (const Numbered& a, const Numbered& b, std::vector<KeyPair>& log)
+				{
+					log.push_back(KeyPair(a.key, b.key));
+				});
+			}
+		}
+
+		aurora::DispatchQueue<PairDispatcher, 2> queue(dispatcher);
+		for (int i = 0; i < 5000; ++i)
+		{
+			const Numbered a = { (i * 37) % firstKeys, i };
+			const Numbered b = { (i * 11) % secondKeys, i };
+			queue.post(a, b);
+		}
+
+		std::vector<KeyPair> log;
+		check(queue.drain(log) == 5000u, "all pairs dispatched");
+
+		std::vector<bool> finished(firstKeys * secondKeys, false);
+		for (std::size_t i = 0; i < log.size(); ++i)
+		{
+			const int index = log[i].first * secondKeys + log[i].second;
+			if (i > 0 && log[i] != log[i - 1])
+			{
+				finished[log[i - 1].first * secondKeys + log[i - 1].second] = true;
+				check(!finished[index], "key pair (" + std::to_string(log[i].first) + ", " + std::to_string(log[i].second) + ") dispatched in more than one run");
+			}
+		}
+	}
+
+} // namespace
+
+
+int main()
+{
+	testProducers();
+	testPostDuringDrain();
+	testThrow();
+	testPairs();
+
+	return bench::testResult("DispatchQueueTest: " + std::to_string(producerCount) + " producers, passed");
+}
@@ -0,0 +1,157 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Test for DoubleDispatcher in symmetric mode with dense and enum keys, which are ordered by value.
+// Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <string>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	struct Base
+	{
+		explicit Base(char name)
+		: name(name)
+		{
+		}
+
+		virtual ~Base()
+		{
+		}
+
+		virtual std::size_t typeId() const = 0;
+
+		char name;
+	};
+
+	template <typename T>
+	struct Derived : Base
+	{
+		explicit Derived(char name)
+		: Base(name)
+		{
+		}
+
+		virtual std::size_t typeId() const
+		{
+			return aurora::denseTypeId<Base, T>();
+		}
+	};
+
+	struct A : Derived<A> { A() : Derived('a') {} };
+	struct B : Derived<B> { B() : Derived('b') {} };
+	struct C : Derived<C> { C() : Derived('c') {} };
+
+	std::string sequence(const Base& first, const Base& second)
+	{
+		return std::string() + first.name + second.name;
+	}
+
+	typedef aurora::DenseDispatchTraits<std::string(Base&, Base&), 2> DenseTraits;
+	typedef aurora::DoubleDispatcher<std::string(Base&, Base&), DenseTraits> DenseDispatcher;
+
+	void testDense()
+	{
+		// Register the ids in the order a, b, c, then bind pairs with the greater id first
+		A a;
+		B b;
+		C c;
+		const std::size_t idA = a.typeId();
+		const std::size_t idB = b.typeId();
+		const std::size_t idC = c.typeId();
+		check(idA < idB && idB < idC, "dense ids in order of first use");
+
+		DenseDispatcher dispatcher(true);
+		dispatcher.bind(aurora::Type<C>(), aurora::Type<A>(), [] (C& c, A& a) { return sequence(c, a); });
+		dispatcher.bind(aurora::Type<B>(), aurora::Type<B>(), [] (B& b1, B& b2) { return sequence(b1, b2); });
+
+		check(dispatcher.call(c, a) == "ca", "symmetric dense (c, a)");
+		check(dispatcher.call(a, c) == "ca", "symmetric dense (a, c)");
+		check(dispatcher.call(b, b) == "bb", "symmetric dense (b, b)");
+		check(dispatcher.contains(aurora::Type<A>(), aurora::Type<C>()), "symmetric dense contains() in other order");
+		check(!dispatcher.contains(aurora::Type<A>(), aurora::Type<B>()), "symmetric dense contains() of an unbound pair");
+		check(!dispatcher.tryCall(b, c), "symmetric dense tryCall() of an unbound pair");
+
+		// Both orders refer to the same entry, so the last binding replaces the first
+		dispatcher.bind(aurora::Type<A>(), aurora::Type<C>(), [] (A& a, C& c) { return "new " + sequence(a, c); });
+		check(dispatcher.call(c, a) == "new ac", "rebinding in other order, got " + dispatcher.call(c, a));
+
+		DenseDispatcher asymmetric(false);
+		asymmetric.bind(aurora::Type<C>(), aurora::Type<A>(), [] (C& c, A& a) { return sequence(c, a); });
+		check(asymmetric.call(c, a) == "ca", "asymmetric dense (c, a)");
+		check(!asymmetric.contains(aurora::Type<A>(), aurora::Type<C>()), "asymmetric dense contains() in other order");
+	}
+
+	enum class Kind { Circle, Rect, Triangle };
+
+	struct Shape
+	{
+		Kind kind;
+		char name;
+	};
+
+	struct ShapeTraits : aurora::EnumDispatchTraits<Kind, Kind::Triangle>
+	{
+		static Kind keyFromBase(const Shape& shape)
+		{
+			return shape.kind;
+		}
+	};
+
+	void testEnum()
+	{
+		aurora::DoubleDispatcher<std::string(const Shape&, const Shape&), ShapeTraits> dispatcher(true);
+		dispatcher.bind(Kind::Triangle, Kind::Circle, [] (const Shape& first, const Shape& second)
+		{
+			return std::string() + first.name + second.name;
+		});
+
+		const Shape circle = { Kind::Circle, 'c' };
+		const Shape triangle = { Kind::Triangle, 't' };
+		const Shape rect = { Kind::Rect, 'r' };
+		check(dispatcher.call(triangle, circle) == "tc", "symmetric enum (triangle, circle)");
+		check(dispatcher.call(circle, triangle) == "tc", "symmetric enum (circle, triangle)");
+		check(dispatcher.contains(Kind::Circle, Kind::Triangle), "symmetric enum contains() in other order");
+		check(!dispatcher.tryCall(rect, circle), "symmetric enum tryCall() of an unbound pair");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testDense();
+	testEnum();
+
+	return bench::testResult("DoubleDispatcherTest: passed");
+}
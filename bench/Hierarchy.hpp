@@ -0,0 +1,273 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Class hierarchy with a configurable number of derived classes, shared by the benchmarks.
+
+#ifndef AURORA_BENCH_HIERARCHY_HPP
+#define AURORA_BENCH_HIERARCHY_HPP
+
+#include "Benchmark.hpp"
+
+#include <Aurora/Dispatch/DispatchTraits.hpp>
+#include <Aurora/Meta/Templates.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+namespace bench
+{
+
+	class Base
+	{
+		public:
+			explicit Base(int payload)
+			: payload(payload)
+			{
+			}
+
+			virtual ~Base()
+			{
+			}
+
+			virtual int virtualCall() const = 0;
+			virtual int virtualCall(int data) const = 0;
+
+			// Identification for aurora::DenseDispatchTraits
+			virtual std::size_t typeId() const = 0;
+
+		public:
+			int payload;
+	};
+
+	template <std::size_t I>
+	class Derived : public Base
+	{
+		public:
+			static const std::size_t index = I;
+
+		public:
+			explicit Derived(int payload)
+			: Base(payload)
+			{
+			}
+
+			virtual int virtualCall() const
+			{
+				return payload + static_cast<int>(I);
+			}
+
+			virtual int virtualCall(int data) const
+			{
+				return payload + static_cast<int>(I) + data;
+			}
+
+			virtual std::size_t typeId() const
+			{
+				return aurora::denseTypeId<Base, Derived>();
+			}
+	};
+
+	// Function bound to Derived<I>, with or without user data; computes the same as the virtual functions
+	template <std::size_t I>
+	struct Handler
+	{
+		int operator() (const Derived<I>& object) const
+		{
+			return object.payload + static_cast<int>(I);
+		}
+
+		int operator() (const Derived<I>& object, int data) const
+		{
+			return object.payload + static_cast<int>(I) + data;
+		}
+	};
+
+	// Function bound to the pair (Derived<I>, Derived<J>)
+	template <std::size_t I, std::size_t J>
+	struct PairHandler
+	{
+		int operator() (const Derived<I>& lhs, const Derived<J>& rhs) const
+		{
+			return lhs.payload * static_cast<int>(I) + rhs.payload * static_cast<int>(J);
+		}
+	};
+
+
+	// Classes Derived<0> to Derived<K-1>, which are registered in dispatchers, and Derived<K> to Derived<K+Misses-1>,
+	// which are not
+	template <std::size_t K, std::size_t Misses = 4>
+	struct Family
+	{
+		static const std::size_t size = K;
+		static const std::size_t misses = Misses;
+
+		typedef std::make_index_sequence<K> Registered;
+
+		// Creates an object of class Derived<index>, 0 <= index < K + Misses
+		static std::unique_ptr<Base> create(std::size_t index, int payload)
+		{
+			return create(index, payload, std::make_index_sequence<K + Misses>());
+		}
+
+		template <std::size_t... Is>
+		static std::unique_ptr<Base> create(std::size_t index, int payload, std::index_sequence<Is...>)
+		{
+			typedef std::unique_ptr<Base> (*Factory)(int);
+			static const Factory factories[] = { &createDerived<Is>... };
+
+			return factories[index](payload);
+		}
+
+		template <std::size_t I>
+		static std::unique_ptr<Base> createDerived(int payload)
+		{
+			return std::unique_ptr<Base>(new Derived<I>(payload));
+		}
+
+		// Binds Handler<I> for all registered classes
+		template <class Dispatcher>
+		static void bindAll(Dispatcher& dispatcher)
+		{
+			bindAll(dispatcher, Registered());
+		}
+
+		template <class Dispatcher, std::size_t... Is>
+		static void bindAll(Dispatcher& dispatcher, std::index_sequence<Is...>)
+		{
+			(dispatcher.bind(aurora::Type<Derived<Is>>(), Handler<Is>()), ...);
+		}
+
+		// Binds PairHandler<I, J> for all ordered pairs of registered classes
+		template <class Dispatcher>
+		static void bindAllPairs(Dispatcher& dispatcher)
+		{
+			bindRows(dispatcher, Registered());
+		}
+
+		template <class Dispatcher, std::size_t... Is>
+		static void bindRows(Dispatcher& dispatcher, std::index_sequence<Is...>)
+		{
+			(bindRow<Is>(dispatcher, Registered()), ...);
+		}
+
+		template <std::size_t I, class Dispatcher, std::size_t... Js>
+		static void bindRow(Dispatcher& dispatcher, std::index_sequence<Js...>)
+		{
+			(dispatcher.bind(aurora::Type<Derived<I>>(), aurora::Type<Derived<Js>>(), PairHandler<I, Js>()), ...);
+		}
+
+		// Alternative: chain of dynamic_casts over the registered classes, returns -1 if none matches
+		static int castChain(const Base& object)
+		{
+			return castChain(object, Registered());
+		}
+
+		template <std::size_t... Is>
+		static int castChain(const Base& object, std::index_sequence<Is...>)
+		{
+			int result = -1;
+			(tryCast<Is>(object, result) || ...);
+			return result;
+		}
+
+		template <std::size_t I>
+		static bool tryCast(const Base& object, int& result)
+		{
+			if (const Derived<I>* derived = dynamic_cast<const Derived<I>*>(&object))
+			{
+				result = Handler<I>()(*derived);
+				return true;
+			}
+
+			return false;
+		}
+
+		// Alternative: closed set of the registered classes in a std::variant
+		template <typename Sequence>
+		struct VariantOf;
+
+		template <std::size_t... Is>
+		struct VariantOf<std::index_sequence<Is...>>
+		{
+			typedef std::variant<Derived<Is>...> Type;
+
+			static Type create(std::size_t index, int payload)
+			{
+				typedef Type (*Factory)(int);
+				static const Factory factories[] = { &createAlternative<Is>... };
+
+				return factories[index](payload);
+			}
+
+			template <std::size_t I>
+			static Type createAlternative(int payload)
+			{
+				return Type(std::in_place_index<I>, payload);
+			}
+		};
+
+		typedef typename VariantOf<Registered>::Type Variant;
+
+		static Variant createVariant(std::size_t index, int payload)
+		{
+			return VariantOf<Registered>::create(index, payload);
+		}
+	};
+
+	// Objects of a family in random order. A fraction of them belongs to unregistered classes, the others follow a uniform
+	// or skewed distribution over the registered classes.
+	template <class F>
+	struct Workload
+	{
+		Workload(std::size_t length, bool skewed, unsigned int hitPercent, std::uint64_t seed = 1)
+		: types()
+		, storage()
+		, objects()
+		{
+			Random random(seed);
+			types = typeSequence(length, F::size, skewed, random);
+
+			for (std::size_t& type : types)
+			{
+				if (random.below(100) >= hitPercent)
+					type = F::size + random.below(F::misses);
+
+				storage.push_back(F::create(type, static_cast<int>(random.below(1000))));
+				objects.push_back(storage.back().get());
+			}
+		}
+
+		std::vector<std::size_t>				types;
+		std::vector<std::unique_ptr<Base>>		storage;
+		std::vector<const Base*>				objects;
+	};
+
+} // namespace bench
+
+#endif // AURORA_BENCH_HIERARCHY_HPP
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Test for MultiDispatcher: asymmetric and symmetric dispatch of three arguments, tryCall(), contains(), the fallback,
+// and the storage chosen for traits with dense keys. Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <string>
+#include <type_traits>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	struct Base
+	{
+		explicit Base(char name)
+		: name(name)
+		{
+		}
+
+		virtual ~Base()
+		{
+		}
+
+		virtual std::size_t typeId() const = 0;
+
+		char name;
+	};
+
+	template <typename T>
+	struct Derived : Base
+	{
+		explicit Derived(char name)
+		: Base(name)
+		{
+		}
+
+		virtual std::size_t typeId() const
+		{
+			return aurora::denseTypeId<Base, T>();
+		}
+	};
+
+	struct A : Derived<A> { A() : Derived('a') {} };
+	struct B : Derived<B> { B() : Derived('b') {} };
+	struct C : Derived<C> { C() : Derived('c') {} };
+
+	typedef aurora::MultiDispatcher<std::string(Base&, Base&, Base&), 3> Dispatcher;
+
+	// Records the classes and the order of the arguments received by a function
+	std::string sequence(const Base& first, const Base& second, const Base& third)
+	{
+		return std::string() + first.name + second.name + third.name;
+	}
+
+	// Asymmetric: only the registered order matches, other orders go to the fallback in their original order
+	void testAsymmetric()
+	{
+		Dispatcher dispatcher(false);
+		dispatcher.bind(aurora::Type<A>(), aurora::Type<B>(), aurora::Type<C>(), [] (A& a, B& b, C& c) { return sequence(a, b, c); });
+
+		A a;
+		B b;
+		C c;
+		check(dispatcher.call(a, b, c) == "abc", "asymmetric call in registered order");
+		check(dispatcher.contains(aurora::Type<A>(), aurora::Type<B>(), aurora::Type<C>()), "asymmetric contains() in registered order");
+		check(!dispatcher.contains(aurora::Type<C>(), aurora::Type<B>(), aurora::Type<A>()), "asymmetric contains() in other order");
+
+		aurora::Optional<std::string> hit = dispatcher.tryCall(a, b, c);
+		check(hit && *hit == "abc", "tryCall() of a registered combination");
+		check(!dispatcher.tryCall(c, b, a), "tryCall() of an unregistered combination");
+
+		bool thrown = false;
+		try
+		{
+			dispatcher.call(c, b, a);
+		}
+		catch (const aurora::FunctionCallException&)
+		{
+			thrown = true;
+		}
+
+		check(thrown, "call() without function and fallback throws");
+
+		dispatcher.fallback([] (Base& first, Base& second, Base& third) { return "fallback " + sequence(first, second, third); });
+		check(dispatcher.call(c, b, a) == "fallback cba", "fallback receives the original order");
+		check(!dispatcher.tryCall(c, b, a), "tryCall() doesn't invoke the fallback");
+	}
+
+	// Symmetric: every permutation of the arguments reaches the function, rearranged to its parameter order
+	void testSymmetric()
+	{
+		Dispatcher dispatcher(true);
+		dispatcher.bind(aurora::Type<A>(), aurora::Type<B>(), aurora::Type<C>(), [] (A& a, B& b, C& c) { return sequence(a, b, c); });
+		dispatcher.bind(aurora::Type<A>(), aurora::Type<A>(), aurora::Type<B>(), [] (A& a1, A& a2, B& b) { return sequence(a1, a2, b); });
+
+		A a;
+		B b;
+		C c;
+		check(dispatcher.call(a, b, c) == "abc", "symmetric (a, b, c)");
+		check(dispatcher.call(a, c, b) == "abc", "symmetric (a, c, b)");
+		check(dispatcher.call(b, a, c) == "abc", "symmetric (b, a, c)");
+		check(dispatcher.call(b, c, a) == "abc", "symmetric (b, c, a)");
+		check(dispatcher.call(c, a, b) == "abc", "symmetric (c, a, b)");
+		check(dispatcher.call(c, b, a) == "abc", "symmetric (c, b, a)");
+
+		A other;
+		other.name = 'x';
+		const std::string result = dispatcher.call(b, other, a);
+		check(result == "xab" || result == "axb", "symmetric with equal classes, got " + result);
+
+		check(dispatcher.contains(aurora::Type<C>(), aurora::Type<A>(), aurora::Type<B>()), "symmetric contains() in other order");
+		check(dispatcher.contains(aurora::Type<B>(), aurora::Type<A>(), aurora::Type<A>()), "symmetric contains() with equal classes");
+		check(!dispatcher.contains(aurora::Type<C>(), aurora::Type<C>(), aurora::Type<A>()), "symmetric contains() of an unregistered combination");
+
+		aurora::Optional<std::string> hit = dispatcher.tryCall(c, a, b);
+		check(hit && *hit == "abc", "symmetric tryCall()");
+		check(!dispatcher.tryCall(c, c, c), "symmetric tryCall() of an unregistered combination");
+
+		dispatcher.fallback([] (Base& first, Base& second, Base& third) { return "fallback " + sequence(first, second, third); });
+		check(dispatcher.call(c, b, c) == "fallback cbc", "symmetric fallback receives the original order");
+	}
+
+	// Dense keys: the traits' DenseStorage indexes single keys, so the composite keys are stored in a HashStorage
+	typedef aurora::DenseDispatchTraits<std::string(Base&, Base&, Base&), 3> DenseTraits;
+
+	enum class Color { Red, Green, Blue };
+
+	static_assert(std::is_same<aurora::detail::CompositeTraitsStorage<DenseTraits>::Type, aurora::HashStorage>::value,
+		"DenseStorage is replaced by HashStorage");
+	static_assert(std::is_same<aurora::detail::CompositeStorage<aurora::ArrayStorage<3>>::Type, aurora::HashStorage>::value,
+		"ArrayStorage is replaced by HashStorage");
+	static_assert(std::is_same<aurora::detail::CompositeStorage<aurora::FlatStorage>::Type, aurora::FlatStorage>::value,
+		"FlatStorage is kept");
+
+	void testDense()
+	{
+		aurora::MultiDispatcher<std::string(Base&, Base&, Base&), 3, DenseTraits> dispatcher(true);
+		dispatcher.bind(aurora::Type<A>(), aurora::Type<B>(), aurora::Type<C>(), [] (A& a, B& b, C& c) { return sequence(a, b, c); });
+
+		A a;
+		B b;
+		C c;
+		check(dispatcher.call(c, a, b) == "abc", "dense keys, symmetric");
+		check(dispatcher.contains(aurora::Type<B>(), aurora::Type<C>(), aurora::Type<A>()), "dense keys, contains()");
+		check(!dispatcher.tryCall(a, a, a), "dense keys, tryCall() of an unregistered combination");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testAsymmetric();
+	testSymmetric();
+	testDense();
+
+	return bench::testResult("MultiDispatcherTest: passed");
+}
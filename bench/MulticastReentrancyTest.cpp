@@ -0,0 +1,248 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Regression test for MulticastDispatcher: functions that bind and unbind functions of the dispatcher while it calls
+// them. Exits with status 1 on failure. Meant to be run under AddressSanitizer as well (-DAURORA_SANITIZER=address).
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	struct Event
+	{
+		virtual ~Event() {}
+	};
+
+	struct Collision : Event {};
+	struct Explosion : Event {};
+
+	typedef aurora::MulticastDispatcher<void(Event&, std::vector<int>&)> Dispatcher;
+
+	// A function unbinds itself and binds many others, which reallocates the slots
+	void testUnbindSelfAndBind()
+	{
+		Dispatcher dispatcher;
+		Dispatcher::Token self;
+		const std::size_t added = 64;
+
+		dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>& log) { log.push_back(0); });
+		self = dispatcher.bind(aurora::Type<Collision>(), [&] (Collision&, std::vector<int>& log)
+		{
+			log.push_back(1);
+			check(dispatcher.unbind(self), "unbind() of the running function");
+
+			for (std::size_t i = 0; i < added; ++i)
+				dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>& log) { log.push_back(2); });
+		});
+		dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>& log) { log.push_back(3); });
+
+		Collision collision;
+		std::vector<int> log;
+		check(dispatcher.call(collision, log) == 3u, "first call invokes the functions bound before it");
+		check(log == std::vector<int>({ 0, 1, 3 }), "first call invokes in registration order");
+
+		log.clear();
+		check(dispatcher.call(collision, log) == 2u + added, "second call invokes the functions bound by the first");
+		check(log.size() == 2u + added && log[0] == 0 && log[1] == 3 && log.back() == 2, "second call order");
+		check(!dispatcher.unbind(self), "unbound token is invalid");
+	}
+
+	// A function unbinds a later function of the same key, which must not be invoked anymore
+	void testUnbindLater()
+	{
+		Dispatcher dispatcher;
+		Dispatcher::Token later;
+
+		dispatcher.bind(aurora::Type<Collision>(), [&] (Collision&, std::vector<int>& log)
+		{
+			log.push_back(0);
+			dispatcher.unbind(later);
+		});
+		later = dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>& log) { log.push_back(1); });
+
+		Collision collision;
+		std::vector<int> log;
+		check(dispatcher.call(collision, log) == 1u && log == std::vector<int>({ 0 }), "unbound function is skipped");
+	}
+
+	// Nested calls, and functions bound and unbound again within the same call
+	void testNested()
+	{
+		Dispatcher dispatcher;
+		bool first = true;
+
+		dispatcher.bind(aurora::Type<Explosion>(), [] (Explosion&, std::vector<int>& log) { log.push_back(10); });
+		dispatcher.bind(aurora::Type<Collision>(), [&] (Collision&, std::vector<int>& log)
+		{
+			log.push_back(20);
+			if (!first)
+				return;
+
+			first = false;
+
+			Explosion explosion;
+			dispatcher.call(explosion, log);
+
+			// Bound for a new key during the call, visible to contains() but not called yet
+			Dispatcher::Token pending = dispatcher.bind(aurora::Type<Explosion>(), [] (Explosion&, std::vector<int>& log) { log.push_back(11); });
+			check(dispatcher.contains(aurora::Type<Explosion>()), "contains() sees pending functions");
+			check(dispatcher.unbind(pending), "unbind() of a pending function");
+
+			dispatcher.bind(aurora::Type<Event>(), [] (Event&, std::vector<int>& log) { log.push_back(30); });
+			check(dispatcher.contains(aurora::Type<Event>()), "contains() sees pending keys");
+
+			Collision collision;
+			dispatcher.call(collision, log);
+		});
+
+		Collision collision;
+		std::vector<int> log;
+		dispatcher.call(collision, log);
+		check(log == std::vector<int>({ 20, 10, 20 }), "nested calls");
+
+		log.clear();
+		Explosion explosion;
+		check(dispatcher.call(explosion, log) == 1u && log == std::vector<int>({ 10 }), "pending function unbound");
+
+		Event event;
+		check(dispatcher.call(event, log) == 1u, "pending key inserted");
+	}
+
+	// Many unbinds during a call trigger the compaction afterwards
+	void testCompaction()
+	{
+		Dispatcher dispatcher;
+		std::vector<Dispatcher::Token> tokens;
+
+		tokens.push_back(dispatcher.bind(aurora::Type<Collision>(), [&] (Collision&, std::vector<int>& log)
+		{
+			log.push_back(0);
+			for (std::size_t i = 1; i < tokens.size(); ++i)
+				dispatcher.unbind(tokens[i]);
+		}));
+
+		for (int i = 1; i < 16; ++i)
+			tokens.push_back(dispatcher.bind(aurora::Type<Collision>(), [i] (Collision&, std::vector<int>& log) { log.push_back(i); }));
+
+		Collision collision;
+		std::vector<int> log;
+		check(dispatcher.call(collision, log) == 1u, "all others unbound");
+
+		tokens.resize(1);
+		dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>& log) { log.push_back(99); });
+
+		log.clear();
+		check(dispatcher.call(collision, log) == 2u && log == std::vector<int>({ 0, 99 }), "slots after compaction");
+	}
+
+	// A function unbound during a call is destroyed by flush(), even if no compaction takes place
+	void testDestroyUnbound()
+	{
+		Dispatcher dispatcher;
+		std::shared_ptr<int> resource = std::make_shared<int>(0);
+		Dispatcher::Token owner;
+
+		dispatcher.bind(aurora::Type<Collision>(), [&] (Collision&, std::vector<int>&) { dispatcher.unbind(owner); });
+		owner = dispatcher.bind(aurora::Type<Collision>(), [resource] (Collision&, std::vector<int>&) {});
+		for (int i = 0; i < 4; ++i)
+			dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>&) {});
+
+		Collision collision;
+		std::vector<int> log;
+		dispatcher.call(collision, log);
+		dispatcher.flush();
+		check(resource.use_count() == 1, "unbound function destroyed by flush()");
+	}
+
+	// A function throws after binding and unbinding: the held back changes remain and the dispatcher stays usable
+	void testThrow()
+	{
+		Dispatcher dispatcher;
+		std::shared_ptr<int> resource = std::make_shared<int>(0);
+		Dispatcher::Token later;
+		bool first = true;
+
+		dispatcher.bind(aurora::Type<Collision>(), [&] (Collision&, std::vector<int>& log)
+		{
+			log.push_back(0);
+			if (!first)
+				return;
+
+			first = false;
+			dispatcher.unbind(later);
+			dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>& log) { log.push_back(2); });
+			throw 42;
+		});
+		later = dispatcher.bind(aurora::Type<Collision>(), [resource] (Collision&, std::vector<int>& log) { log.push_back(1); });
+
+		Collision collision;
+		std::vector<int> log;
+		bool thrown = false;
+		try
+		{
+			dispatcher.call(collision, log);
+		}
+		catch (int)
+		{
+			thrown = true;
+		}
+
+		check(thrown && log == std::vector<int>({ 0 }), "exception propagates out of call()");
+		check(dispatcher.contains(aurora::Type<Collision>()), "contains() after the exception");
+
+		log.clear();
+		check(dispatcher.call(collision, log) == 2u && log == std::vector<int>({ 0, 2 }), "held back changes seen by the next call");
+
+		dispatcher.bind(aurora::Type<Collision>(), [] (Collision&, std::vector<int>& log) { log.push_back(3); });
+		check(resource.use_count() == 1, "unbound function destroyed by the next bind()");
+
+		log.clear();
+		check(dispatcher.call(collision, log) == 3u && log == std::vector<int>({ 0, 2, 3 }), "bind() after the exception");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testUnbindSelfAndBind();
+	testUnbindLater();
+	testNested();
+	testCompaction();
+	testDestroyUnbound();
+	testThrow();
+
+	return bench::testResult("MulticastDispatcher reentrancy test passed");
+}
@@ -0,0 +1,202 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Compares DoubleDispatcher::callPairs() with one call() per pair, on the candidate pairs of a synthetic collision
+// broadphase. Objects of 4 or 32 classes are scattered in a square, and a sweep along the x axis reports all pairs whose
+// bounding boxes overlap, in the order a real broadphase would. Each function adds its result to a user argument.
+
+#include "Benchmark.hpp"
+#include "Hierarchy.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	typedef void PairSignature(const Base&, const Base&, int&);
+
+	// Adds the result of PairHandler<I, J> to the user argument
+	template <std::size_t I, std::size_t J>
+	struct Accumulator
+	{
+		void operator() (const Derived<I>& lhs, const Derived<J>& rhs, int& sum) const
+		{
+			sum += PairHandler<I, J>()(lhs, rhs);
+		}
+	};
+
+	template <std::size_t I, class Dispatcher, std::size_t... Js>
+	void bindRow(Dispatcher& dispatcher, bool symmetric, std::index_sequence<Js...>)
+	{
+		((!symmetric || I <= Js ? dispatcher.bind(aurora::Type<Derived<I>>(), aurora::Type<Derived<Js>>(), Accumulator<I, Js>()) : void()), ...);
+	}
+
+	template <class F, class Dispatcher, std::size_t... Is>
+	void bindRows(Dispatcher& dispatcher, bool symmetric, std::index_sequence<Is...>)
+	{
+		(bindRow<Is>(dispatcher, symmetric, typename F::Registered()), ...);
+	}
+
+	// Binds Accumulator<I, J> for all ordered pairs, or in symmetric mode for I <= J
+	template <class F, class Dispatcher>
+	void bindAccumulators(Dispatcher& dispatcher, bool symmetric)
+	{
+		bindRows<F>(dispatcher, symmetric, typename F::Registered());
+	}
+
+
+	// Objects with axis-aligned bounding boxes, and the pairs of overlapping boxes
+	template <class F>
+	struct Broadphase
+	{
+		struct Box
+		{
+			float			minX, minY, maxX, maxY;
+			const Base*		object;
+		};
+
+		Broadphase(std::size_t count, bool skewed)
+		: storage()
+		, pairs()
+		{
+			Random random(count);
+			const std::vector<std::size_t> types = typeSequence(count, F::size, skewed, random);
+
+			// Square world in which each object overlaps about 10 others on average
+			const float size = 1.f;
+			const float extent = size * 1.6f / static_cast<float>(std::sqrt(static_cast<double>(count)));
+
+			std::vector<Box> boxes;
+			for (std::size_t type : types)
+			{
+				storage.push_back(F::create(type, static_cast<int>(random.below(1000))));
+
+				const float x = static_cast<float>(random.below(1u << 20)) / static_cast<float>(1u << 20) * size;
+				const float y = static_cast<float>(random.below(1u << 20)) / static_cast<float>(1u << 20) * size;
+				boxes.push_back(Box{ x, y, x + extent, y + extent, storage.back().get() });
+			}
+
+			// Sweep and prune along x
+			std::sort(boxes.begin(), boxes.end(), [] (const Box& a, const Box& b) { return a.minX < b.minX; });
+			for (std::size_t i = 0; i < boxes.size(); ++i)
+			{
+				for (std::size_t j = i + 1; j < boxes.size() && boxes[j].minX <= boxes[i].maxX; ++j)
+				{
+					if (boxes[i].minY <= boxes[j].maxY && boxes[j].minY <= boxes[i].maxY)
+						pairs.emplace_back(boxes[i].object, boxes[j].object);
+				}
+			}
+		}
+
+		std::vector<std::unique_ptr<Base>>						storage;
+		std::vector<std::pair<const Base*, const Base*>>		pairs;
+	};
+
+	std::string parameters(std::size_t types, std::size_t objects, std::size_t pairs, bool skewed, bool symmetric)
+	{
+		return "types=" + std::to_string(types) + " objects=" + std::to_string(objects) + " pairs=" + std::to_string(pairs)
+			+ " distribution=" + (skewed ? "zipf" : "uniform") + " symmetric=" + (symmetric ? "1" : "0");
+	}
+
+	// Dispatches all pairs repeatedly, once with call() per pair and once with callPairs()
+	template <class Dispatcher>
+	void runDispatcher(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const Dispatcher& dispatcher, const std::vector<std::pair<const Base*, const Base*>>& pairs)
+	{
+		const std::size_t rounds = reporter.scale(1u << 22) / pairs.size() + 1;
+		const std::size_t operations = rounds * pairs.size();
+
+		reporter.run("pair_dispatch", implementation + "/call", params, operations, [&] ()
+		{
+			int sum = 0;
+			for (std::size_t r = 0; r < rounds; ++r)
+			{
+				for (const auto& pair : pairs)
+					dispatcher.call(*pair.first, *pair.second, sum);
+			}
+
+			keep(sum);
+		});
+
+		reporter.run("pair_dispatch", implementation + "/callPairs", params, operations, [&] ()
+		{
+			int sum = 0;
+			for (std::size_t r = 0; r < rounds; ++r)
+				dispatcher.callPairs(pairs.begin(), pairs.end(), sum);
+
+			keep(sum);
+		});
+	}
+
+	template <class F>
+	void runFamily(Reporter& reporter)
+	{
+		typedef aurora::RttiDispatchTraits<PairSignature, 2>		RttiTraits;
+		typedef aurora::DenseDispatchTraits<PairSignature, 2>		DenseTraits;
+
+		for (bool symmetric : { false, true })
+		{
+			aurora::DoubleDispatcher<PairSignature, RttiTraits, aurora::HashStorage> rttiHash(symmetric);
+			aurora::DoubleDispatcher<PairSignature, RttiTraits, aurora::FlatStorage> rttiFlat(symmetric);
+			aurora::DoubleDispatcher<PairSignature, DenseTraits, aurora::DenseStorage> dense(symmetric);
+
+			bindAccumulators<F>(rttiHash, symmetric);
+			bindAccumulators<F>(rttiFlat, symmetric);
+			bindAccumulators<F>(dense, symmetric);
+
+			for (std::size_t objects : { 1024u, 16384u })
+			{
+				for (bool skewed : { false, true })
+				{
+					const Broadphase<F> broadphase(objects, skewed);
+					const std::string params = parameters(F::size, objects, broadphase.pairs.size(), skewed, symmetric);
+
+					runDispatcher(reporter, "DoubleDispatcher/Rtti/HashStorage", params, rttiHash, broadphase.pairs);
+					runDispatcher(reporter, "DoubleDispatcher/Rtti/FlatStorage", params, rttiFlat, broadphase.pairs);
+					runDispatcher(reporter, "DoubleDispatcher/Dense/DenseStorage", params, dense, broadphase.pairs);
+				}
+			}
+		}
+	}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	Reporter reporter("pairs", argc, argv);
+
+	runFamily<Family<4>>(reporter);
+	runFamily<Family<32>>(reporter);
+}
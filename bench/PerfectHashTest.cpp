@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Regression test for the table of aurora::PerfectHashStorage: seal() must terminate and lookups must stay correct for
+// hashers that produce colliding or badly distributed hash values. Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Tools/Hash.hpp>
+
+#include <cstdint>
+#include <string>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	// All keys have the same hash value
+	struct ConstantHasher
+	{
+		std::size_t operator() (int) const
+		{
+			return 42u;
+		}
+	};
+
+	// Groups of keys share a hash value
+	struct ModuloHasher
+	{
+		std::size_t operator() (int key) const
+		{
+			return static_cast<std::size_t>(key % 7);
+		}
+	};
+
+	// Distinct hash values that differ only in the high bits
+	struct HighBitsHasher
+	{
+		std::size_t operator() (int key) const
+		{
+			return static_cast<std::size_t>(static_cast<std::uint64_t>(key) << 40);
+		}
+	};
+
+	template <typename Hash>
+	void testHasher(const std::string& name, int keyCount)
+	{
+		typedef aurora::PerfectHashStorage::Table<int, int, Hash> Table;
+
+		Table table;
+		for (int k = 0; k < keyCount; ++k)
+			table.insert(k, 3 * k);
+
+		table.seal();
+		check(table.size() == static_cast<std::size_t>(keyCount), name + ": size " + std::to_string(table.size()));
+
+		for (int k = 0; k < keyCount; ++k)
+		{
+			const int* value = table.find(k);
+			check(value && *value == 3 * k, name + ": key " + std::to_string(k) + " not found after seal()");
+		}
+
+		check(table.find(keyCount) == nullptr, name + ": unregistered key found");
+
+		// Modifying and sealing again must work as well
+		table.insert(keyCount, -1);
+		table.seal();
+		const int* value = table.find(keyCount);
+		check(value && *value == -1, name + ": key inserted after seal() not found");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testHasher<ConstantHasher>("ConstantHasher", 100);
+	testHasher<ModuloHasher>("ModuloHasher", 100);
+	testHasher<HighBitsHasher>("HighBitsHasher", 10000);
+	testHasher<aurora::Hasher>("Hasher", 1);
+
+	return bench::testResult("PerfectHashTest: passed");
+}
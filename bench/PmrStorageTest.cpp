@@ -0,0 +1,157 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Test for PmrStorage: the tables of the dispatchers allocate from the supplied memory resource, with HashStorage and
+// FlatStorage as base policy. Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	// Forwards to the heap and counts the allocations
+	class CountingResource : public std::pmr::memory_resource
+	{
+		public:
+			CountingResource()
+			: allocations(0u)
+			, deallocations(0u)
+			, bytes(0u)
+			{
+			}
+
+			std::size_t allocations;
+			std::size_t deallocations;
+			std::size_t bytes;		// currently allocated
+
+		private:
+			virtual void* do_allocate(std::size_t size, std::size_t alignment)
+			{
+				++allocations;
+				bytes += size;
+				return std::pmr::new_delete_resource()->allocate(size, alignment);
+			}
+
+			virtual void do_deallocate(void* pointer, std::size_t size, std::size_t alignment)
+			{
+				++deallocations;
+				bytes -= size;
+				std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+			}
+
+			virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept
+			{
+				return this == &other;
+			}
+	};
+
+	struct Base
+	{
+		virtual ~Base()
+		{
+		}
+	};
+
+	struct A : Base {};
+	struct B : Base {};
+	struct C : Base {};
+	struct DerivedA : A {};
+
+	template <class StoragePolicy>
+	void testSingle(const std::string& name)
+	{
+		typedef aurora::SingleDispatcher<int(Base&), aurora::RttiDispatchTraits<int(Base&), 1>, aurora::PmrStorage<StoragePolicy>> Dispatcher;
+
+		CountingResource resource;
+		CountingResource other;
+		std::pmr::memory_resource* previous = std::pmr::set_default_resource(&other);
+		{
+			Dispatcher dispatcher(true, &resource);
+			dispatcher.bind(aurora::Type<A>(), [] (A&) { return 1; });
+			dispatcher.bind(aurora::Type<B>(), [] (B&) { return 2; });
+			check(resource.allocations > 0u, name + ": bind() allocates from the resource");
+
+			// Resolving DerivedA stores the function of A in the resolver's containers
+			DerivedA derived;
+			const std::size_t beforeResolve = resource.allocations;
+			check(dispatcher.call(derived) == 1, name + ": call() of a derived class");
+			check(resource.allocations > beforeResolve, name + ": resolved bases are stored in the resource");
+
+			// The moved-to dispatcher keeps the resource
+			Dispatcher moved(std::move(dispatcher));
+			const std::size_t beforeBind = resource.allocations;
+			moved.bind(aurora::Type<C>(), [] (C&) { return 3; });
+			check(resource.allocations > beforeBind, name + ": moved dispatcher allocates from the resource");
+
+			C c;
+			check(moved.call(c) == 3, name + ": call() after move");
+		}
+		std::pmr::set_default_resource(previous);
+
+		check(other.allocations == 0u, name + ": no allocation from the default resource");
+		check(resource.bytes == 0u && resource.allocations == resource.deallocations, name + ": all memory returned to the resource");
+	}
+
+	template <class StoragePolicy>
+	void testDouble(const std::string& name)
+	{
+		typedef aurora::DoubleDispatcher<int(Base&, Base&), aurora::RttiDispatchTraits<int(Base&, Base&), 2>, aurora::PmrStorage<StoragePolicy>> Dispatcher;
+
+		CountingResource resource;
+		{
+			Dispatcher dispatcher(true, &resource);
+			dispatcher.bind(aurora::Type<A>(), aurora::Type<B>(), [] (A&, B&) { return 12; });
+			dispatcher.bind(aurora::Type<B>(), aurora::Type<C>(), [] (B&, C&) { return 23; });
+			check(resource.allocations > 0u, name + ": DoubleDispatcher::bind() allocates from the resource");
+
+			B b;
+			C c;
+			check(dispatcher.call(c, b) == 23, name + ": DoubleDispatcher::call()");
+		}
+
+		check(resource.bytes == 0u && resource.allocations == resource.deallocations, name + ": DoubleDispatcher returns all memory");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testSingle<aurora::HashStorage>("HashStorage");
+	testSingle<aurora::FlatStorage>("FlatStorage");
+	testDouble<aurora::HashStorage>("HashStorage");
+	testDouble<aurora::FlatStorage>("FlatStorage");
+
+	return bench::testResult("PmrStorageTest: passed");
+}
@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Test for StaticDispatcher: dispatch, duplicate classes, the fallback and an empty list of bindings.
+// Exits with status 1 on failure.
+
+#include "Test.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <string>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	struct Base
+	{
+		virtual ~Base()
+		{
+		}
+	};
+
+	struct A : Base {};
+	struct B : Base {};
+	struct C : Base {};
+
+	std::string firstA(A&)		{ return "first a"; }
+	std::string lastA(A&)		{ return "last a"; }
+	std::string functionB(B&)	{ return "b"; }
+
+	// A appears twice, the last binding wins
+	typedef aurora::Typelist<
+		AURORA_STATIC_BINDING(A, firstA),
+		AURORA_STATIC_BINDING(B, functionB),
+		AURORA_STATIC_BINDING(A, lastA)
+	> Bindings;
+
+	typedef aurora::StaticDispatcher<std::string(Base&), Bindings> Dispatcher;
+
+	void testBindings()
+	{
+		const Dispatcher dispatcher;
+
+		A a;
+		B b;
+		check(dispatcher.call(a) == "last a", "last binding of a duplicate class wins");
+		check(dispatcher.call(b) == "b", "call() of a bound class");
+		check(dispatcher.contains(aurora::Type<A>()), "contains() of a bound class");
+		check(!dispatcher.contains(aurora::Type<C>()), "contains() of an unbound class");
+
+		aurora::Optional<std::string> hit = dispatcher.tryCall(a);
+		check(hit && *hit == "last a", "tryCall() of a bound class");
+	}
+
+	void testFallback()
+	{
+		Dispatcher dispatcher;
+
+		C c;
+		bool thrown = false;
+		try
+		{
+			dispatcher.call(c);
+		}
+		catch (const aurora::FunctionCallException&)
+		{
+			thrown = true;
+		}
+
+		check(thrown, "call() of an unbound class without fallback throws");
+
+		dispatcher.fallback([] (Base&) { return std::string("fallback"); });
+		check(dispatcher.call(c) == "fallback", "call() of an unbound class invokes the fallback");
+		check(!dispatcher.tryCall(c), "tryCall() doesn't invoke the fallback");
+		check(!dispatcher.contains(aurora::Type<C>()), "fallback() doesn't modify the table");
+
+		A a;
+		check(dispatcher.call(a) == "last a", "fallback() doesn't hide bound classes");
+
+		dispatcher.fallback(nullptr);
+		thrown = false;
+		try
+		{
+			dispatcher.call(c);
+		}
+		catch (const aurora::FunctionCallException&)
+		{
+			thrown = true;
+		}
+
+		check(thrown, "call() throws again after the fallback is removed");
+	}
+
+	void testEmpty()
+	{
+		aurora::StaticDispatcher<std::string(Base&), aurora::Typelist<>> dispatcher;
+
+		A a;
+		check(!dispatcher.contains(aurora::Type<A>()), "empty dispatcher contains nothing");
+		check(!dispatcher.tryCall(a), "tryCall() of an empty dispatcher");
+
+		dispatcher.fallback([] (Base&) { return std::string("fallback"); });
+		check(dispatcher.call(a) == "fallback", "empty dispatcher invokes the fallback");
+	}
+
+} // namespace
+
+
+int main()
+{
+	testBindings();
+	testFallback();
+	testEmpty();
+
+	return bench::testResult("StaticDispatcherTest: passed");
+}
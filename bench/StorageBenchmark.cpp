@@ -0,0 +1,214 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Compares the storage policies of SingleDispatcher with each other and with a plain std::unordered_map from
+// std::type_index to std::function. Measures bind cost, call throughput and latency for 4, 32 and 512 classes, with
+// uniform and skewed type distributions and hit ratios of 100 and 90 percent.
+
+#include "Benchmark.hpp"
+#include "Hierarchy.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <functional>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	const std::size_t workloadLength = 4096;
+	const std::size_t mask = workloadLength - 1;
+
+	typedef aurora::RttiDispatchTraits<int(const Base&), 1>								RttiTraits;
+	typedef aurora::DenseDispatchTraits<int(const Base&), 1>							DenseTraits;
+	typedef std::unordered_map<std::type_index, std::function<int(const Base&)>>		Map;
+
+	template <class Storage>
+	using RttiDispatcher = aurora::SingleDispatcher<int(const Base&), RttiTraits, Storage>;
+
+	std::string parameters(std::size_t types, bool skewed, unsigned int hitPercent)
+	{
+		return "types=" + std::to_string(types) + " distribution=" + (skewed ? "zipf" : "uniform")
+			+ " hit=" + std::to_string(hitPercent);
+	}
+
+	// Baseline: functions that downcast their argument, registered in a map
+	template <class F, std::size_t... Is>
+	void bindMap(Map& map, std::index_sequence<Is...>)
+	{
+		((map[typeid(Derived<Is>)] = [] (const Base& object) { return Handler<Is>()(static_cast<const Derived<Is>&>(object)); }), ...);
+	}
+
+	int callMap(const Map& map, const Base& object)
+	{
+		auto itr = map.find(typeid(object));
+		return itr != map.end() ? itr->second(object) : 0;
+	}
+
+	// Prepares a dispatcher for calls: the perfect hash function is computed by seal(), and the adaptive table promotes
+	// the most frequent keys of the workload in optimize()
+	template <class Dispatcher>
+	void prepare(Dispatcher& dispatcher, const std::vector<const Base*>& objects)
+	{
+		for (const Base* object : objects)
+			keep(dispatcher.call(*object));
+
+		dispatcher.optimize();
+	}
+
+	template <typename Fn>
+	void runThroughput(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const std::vector<const Base*>& objects, Fn call)
+	{
+		const std::size_t operations = reporter.scale(1u << 22);
+		reporter.run("call_throughput", implementation, params, operations, [&] ()
+		{
+			int sum = 0;
+			for (std::size_t i = 0; i < operations; ++i)
+				sum += call(*objects[i & mask]);
+
+			keep(sum);
+		});
+	}
+
+	template <typename Fn>
+	void runLatency(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const std::vector<const Base*>& objects, Fn call)
+	{
+		const std::size_t operations = reporter.scale(1u << 20);
+		reporter.run("call_latency", implementation, params, operations, [&] ()
+		{
+			std::size_t index = 0;
+			for (std::size_t i = 0; i < operations; ++i)
+				index = (index + 1 + static_cast<std::size_t>(call(*objects[index]) & 1)) & mask;
+
+			keep(index);
+		});
+	}
+
+	// Constructs dispatchers and registers the functions for all classes
+	template <class F, typename Fn>
+	void runBind(Reporter& reporter, const std::string& implementation, Fn create)
+	{
+		const std::size_t rounds = reporter.scale(2048) / F::size + 1;
+		reporter.run("bind", implementation, "types=" + std::to_string(F::size), rounds * F::size, [&] ()
+		{
+			for (std::size_t i = 0; i < rounds; ++i)
+				keep(create());
+		});
+	}
+
+	template <class F, class Dispatcher>
+	bool createDispatcher()
+	{
+		Dispatcher dispatcher;
+		F::bindAll(dispatcher);
+		dispatcher.seal();
+		return dispatcher.contains(aurora::Type<Derived<0>>());
+	}
+
+	template <class F>
+	void runFamily(Reporter& reporter)
+	{
+		runBind<F>(reporter, "SingleDispatcher/Rtti/HashStorage", &createDispatcher<F, RttiDispatcher<aurora::HashStorage>>);
+		runBind<F>(reporter, "SingleDispatcher/Rtti/FlatStorage", &createDispatcher<F, RttiDispatcher<aurora::FlatStorage>>);
+		runBind<F>(reporter, "SingleDispatcher/Rtti/SmallStorage", &createDispatcher<F, RttiDispatcher<aurora::SmallStorage<>>>);
+		runBind<F>(reporter, "SingleDispatcher/Rtti/AdaptiveStorage", &createDispatcher<F, RttiDispatcher<aurora::AdaptiveStorage<>>>);
+		runBind<F>(reporter, "SingleDispatcher/Rtti/PerfectHashStorage", &createDispatcher<F, RttiDispatcher<aurora::PerfectHashStorage>>);
+		runBind<F>(reporter, "SingleDispatcher/Dense/DenseStorage", &createDispatcher<F, aurora::SingleDispatcher<int(const Base&), DenseTraits, aurora::DenseStorage>>);
+		runBind<F>(reporter, "std::unordered_map", [] () { Map map; bindMap<F>(map, typename F::Registered()); return map.size(); });
+
+		for (bool skewed : { false, true })
+		{
+			for (unsigned int hitPercent : { 100u, 90u })
+			{
+				const Workload<F> workload(workloadLength, skewed, hitPercent);
+				const std::vector<const Base*>& objects = workload.objects;
+				const std::string params = parameters(F::size, skewed, hitPercent);
+
+				// Fresh dispatchers per workload, so that the adaptive table learns this distribution
+				RttiDispatcher<aurora::HashStorage> hash;
+				RttiDispatcher<aurora::FlatStorage> flat;
+				RttiDispatcher<aurora::SmallStorage<>> small;
+				RttiDispatcher<aurora::AdaptiveStorage<>> adaptive;
+				RttiDispatcher<aurora::PerfectHashStorage> perfect;
+				aurora::SingleDispatcher<int(const Base&), DenseTraits, aurora::DenseStorage> dense;
+				Map map;
+
+				auto setUp = [&] (auto& dispatcher)
+				{
+					F::bindAll(dispatcher);
+					dispatcher.fallback(aurora::NoOp<int, 1>());
+					dispatcher.seal();
+					prepare(dispatcher, objects);
+				};
+
+				setUp(hash);
+				setUp(flat);
+				setUp(small);
+				setUp(adaptive);
+				setUp(perfect);
+				setUp(dense);
+				bindMap<F>(map, typename F::Registered());
+
+				runThroughput(reporter, "SingleDispatcher/Rtti/HashStorage", params, objects, [&] (const Base& b) { return hash.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Rtti/FlatStorage", params, objects, [&] (const Base& b) { return flat.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Rtti/SmallStorage", params, objects, [&] (const Base& b) { return small.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Rtti/AdaptiveStorage", params, objects, [&] (const Base& b) { return adaptive.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Rtti/PerfectHashStorage", params, objects, [&] (const Base& b) { return perfect.call(b); });
+				runThroughput(reporter, "SingleDispatcher/Dense/DenseStorage", params, objects, [&] (const Base& b) { return dense.call(b); });
+				runThroughput(reporter, "std::unordered_map", params, objects, [&] (const Base& b) { return callMap(map, b); });
+
+				if (hitPercent != 100u)
+					continue;
+
+				runLatency(reporter, "SingleDispatcher/Rtti/HashStorage", params, objects, [&] (const Base& b) { return hash.call(b); });
+				runLatency(reporter, "SingleDispatcher/Rtti/FlatStorage", params, objects, [&] (const Base& b) { return flat.call(b); });
+				runLatency(reporter, "SingleDispatcher/Rtti/SmallStorage", params, objects, [&] (const Base& b) { return small.call(b); });
+				runLatency(reporter, "SingleDispatcher/Rtti/AdaptiveStorage", params, objects, [&] (const Base& b) { return adaptive.call(b); });
+				runLatency(reporter, "SingleDispatcher/Rtti/PerfectHashStorage", params, objects, [&] (const Base& b) { return perfect.call(b); });
+				runLatency(reporter, "SingleDispatcher/Dense/DenseStorage", params, objects, [&] (const Base& b) { return dense.call(b); });
+				runLatency(reporter, "std::unordered_map", params, objects, [&] (const Base& b) { return callMap(map, b); });
+			}
+		}
+	}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	Reporter reporter("storage", argc, argv);
+
+	runFamily<Family<4>>(reporter);
+	runFamily<Family<32>>(reporter);
+	runFamily<Family<512>>(reporter);
+}
@@ -0,0 +1,276 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Compares SingleDispatcher with StringDispatchTraits (StringStorage) against a dispatcher with std::string keys and
+// against std::unordered_map<std::string, std::function>. Measures bind cost and call throughput for 16 and 256 keys of
+// 8 to 64 characters, with random or shared prefixes, hit ratios of 100 and 50 percent, and both std::string and
+// const char* arguments (the latter requiring a temporary std::string for the baselines).
+
+#include "Benchmark.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	const std::size_t workloadLength = 4096;
+	const std::size_t mask = workloadLength - 1;
+
+	// Dispatcher traits with std::string keys, which own their characters and can use any storage policy
+	template <typename S>
+	struct StdStringTraits : aurora::DispatchTraits<std::string>
+	{
+		static const std::string& keyFromBase(const std::string& string)
+		{
+			return string;
+		}
+
+		static std::string name(const std::string& key)
+		{
+			return key;
+		}
+	};
+
+	template <>
+	struct StdStringTraits<int(const char*)> : StdStringTraits<int(const std::string&)>
+	{
+		static std::string keyFromBase(const char* string)
+		{
+			return string;
+		}
+	};
+
+	// Keys of the given length. With shared prefixes, keys only differ in their last characters, like hierarchical names.
+	std::vector<std::string> makeKeys(std::size_t count, std::size_t length, bool sharedPrefix, Random& random)
+	{
+		std::vector<std::string> keys;
+		while (keys.size() < count)
+		{
+			std::string key(length, 'a');
+			const std::size_t first = sharedPrefix ? length - 4 : 0;
+			for (std::size_t i = first; i < length; ++i)
+				key[i] = static_cast<char>('a' + random.below(26));
+
+			bool duplicate = false;
+			for (const std::string& other : keys)
+				duplicate = duplicate || other == key;
+
+			if (!duplicate)
+				keys.push_back(key);
+		}
+
+		return keys;
+	}
+
+	struct Workload
+	{
+		Workload(std::size_t count, std::size_t length, bool sharedPrefix, unsigned int hitPercent)
+		: keys()
+		, strings()
+		, pointers()
+		{
+			// The last 16 keys are never bound, they are used for misses
+			Random random(count * 131 + length);
+			keys = makeKeys(count + 16, length, sharedPrefix, random);
+
+			for (std::size_t i = 0; i < workloadLength; ++i)
+			{
+				if (random.below(100) < hitPercent)
+					strings.push_back(keys[random.below(count)]);
+				else
+					strings.push_back(keys[count + random.below(16)]);
+			}
+
+			keys.resize(count);
+
+			for (const std::string& string : strings)
+				pointers.push_back(string.c_str());
+		}
+
+		std::vector<std::string>	keys;
+		std::vector<std::string>	strings;
+		std::vector<const char*>	pointers;
+	};
+
+	std::string parameters(std::size_t count, std::size_t length, bool sharedPrefix, unsigned int hitPercent, const char* argument)
+	{
+		return "keys=" + std::to_string(count) + " length=" + std::to_string(length) + " prefix=" + (sharedPrefix ? "shared" : "random")
+			+ " hit=" + std::to_string(hitPercent) + " argument=" + argument;
+	}
+
+	// Key of the unordered_map, without copying std::string arguments
+	const std::string& mapKey(const std::string& string)
+	{
+		return string;
+	}
+
+	std::string mapKey(const char* string)
+	{
+		return string;
+	}
+
+	template <class Dispatcher>
+	void bindAll(Dispatcher& dispatcher, const std::vector<std::string>& keys)
+	{
+		for (std::size_t i = 0; i < keys.size(); ++i)
+		{
+			const int value = static_cast<int>(i);
+			dispatcher.bind(keys[i], [value] (typename Dispatcher::Parameter) { return value; });
+		}
+
+		dispatcher.fallback(aurora::NoOp<int, 1>());
+	}
+
+	template <typename Map>
+	void bindAll(Map& map, const std::vector<std::string>& keys, int)
+	{
+		for (std::size_t i = 0; i < keys.size(); ++i)
+		{
+			const int value = static_cast<int>(i);
+			map[keys[i]] = [value] (const std::string&) { return value; };
+		}
+	}
+
+	template <typename T, typename Fn>
+	void runThroughput(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const std::vector<T>& arguments, Fn call)
+	{
+		const std::size_t operations = reporter.scale(1u << 21);
+		reporter.run("call_throughput", implementation, params, operations, [&] ()
+		{
+			int sum = 0;
+			for (std::size_t i = 0; i < operations; ++i)
+				sum += call(arguments[i & mask]);
+
+			keep(sum);
+		});
+	}
+
+	// Signature of the dispatchers, and the arguments of a workload passed to them
+	template <typename S>
+	struct Argument;
+
+	template <>
+	struct Argument<int(const std::string&)>
+	{
+		static const char* name() { return "string"; }
+		static const std::vector<std::string>& of(const Workload& workload) { return workload.strings; }
+	};
+
+	template <>
+	struct Argument<int(const char*)>
+	{
+		static const char* name() { return "pointer"; }
+		static const std::vector<const char*>& of(const Workload& workload) { return workload.pointers; }
+	};
+
+	template <typename S>
+	void runKeys(Reporter& reporter, std::size_t count, std::size_t length, bool sharedPrefix, bool measureBind)
+	{
+		typedef aurora::SingleDispatcher<S, aurora::StringDispatchTraits<S>>									StringDispatcher;
+		typedef aurora::SingleDispatcher<S, StdStringTraits<S>, aurora::HashStorage>							HashDispatcher;
+		typedef aurora::SingleDispatcher<S, StdStringTraits<S>, aurora::FlatStorage>							FlatDispatcher;
+		typedef std::unordered_map<std::string, std::function<int(const std::string&)>>						Map;
+		typedef typename aurora::FunctionParam<S, 0>::Type														Parameter;
+
+		const Workload keySet(count, length, sharedPrefix, 100u);
+		const std::vector<std::string>& keys = keySet.keys;
+
+		// Bind cost, independent of the argument type
+		if (measureBind)
+		{
+			const std::string params = parameters(count, length, sharedPrefix, 100u, Argument<S>::name());
+			const std::size_t rounds = reporter.scale(4096) / count + 1;
+
+			auto runBind = [&] (const std::string& implementation, auto create)
+			{
+				reporter.run("bind", implementation, params, rounds * count, [&] ()
+				{
+					for (std::size_t i = 0; i < rounds; ++i)
+						keep(create());
+				});
+			};
+
+			runBind("SingleDispatcher/String/StringStorage", [&] () { StringDispatcher d; bindAll(d, keys); return d.contains(keys[0]); });
+			runBind("SingleDispatcher/std::string/HashStorage", [&] () { HashDispatcher d; bindAll(d, keys); return d.contains(keys[0]); });
+			runBind("SingleDispatcher/std::string/FlatStorage", [&] () { FlatDispatcher d; bindAll(d, keys); return d.contains(keys[0]); });
+			runBind("std::unordered_map", [&] () { Map m; bindAll(m, keys, 0); return m.count(keys[0]); });
+		}
+
+		StringDispatcher string;
+		HashDispatcher hash;
+		FlatDispatcher flat;
+		Map map;
+
+		bindAll(string, keys);
+		bindAll(hash, keys);
+		bindAll(flat, keys);
+		bindAll(map, keys, 0);
+
+		for (unsigned int hitPercent : { 100u, 50u })
+		{
+			const Workload workload(count, length, sharedPrefix, hitPercent);
+			const auto& arguments = Argument<S>::of(workload);
+			const std::string params = parameters(count, length, sharedPrefix, hitPercent, Argument<S>::name());
+
+			runThroughput(reporter, "SingleDispatcher/String/StringStorage", params, arguments, [&] (Parameter s) { return string.call(s); });
+			runThroughput(reporter, "SingleDispatcher/std::string/HashStorage", params, arguments, [&] (Parameter s) { return hash.call(s); });
+			runThroughput(reporter, "SingleDispatcher/std::string/FlatStorage", params, arguments, [&] (Parameter s) { return flat.call(s); });
+			runThroughput(reporter, "std::unordered_map", params, arguments, [&] (Parameter s)
+			{
+				const auto& key = mapKey(s);
+				auto itr = map.find(key);
+				return itr != map.end() ? itr->second(key) : 0;
+			});
+		}
+	}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	Reporter reporter("string", argc, argv);
+
+	for (std::size_t count : { 16u, 256u })
+	{
+		for (std::size_t length : { 8u, 16u, 32u, 64u })
+		{
+			for (bool sharedPrefix : { false, true })
+			{
+				runKeys<int(const std::string&)>(reporter, count, length, sharedPrefix, true);
+				runKeys<int(const char*)>(reporter, count, length, sharedPrefix, false);
+			}
+		}
+	}
+}
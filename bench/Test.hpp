@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Minimal test harness: records failed checks and turns them into the exit status of the test.
+
+#ifndef AURORA_BENCH_TEST_HPP
+#define AURORA_BENCH_TEST_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+
+namespace bench
+{
+
+	// Whether any check() has failed so far
+	inline std::atomic<bool>& testFailed()
+	{
+		static std::atomic<bool> failed(false);
+		return failed;
+	}
+
+	// Reports a failure if condition is false. May be invoked by several threads at once.
+	inline void check(bool condition, const std::string& message)
+	{
+		static std::mutex mutex;
+
+		if (!condition)
+		{
+			testFailed() = true;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			std::cerr << "FAILED: " << message << std::endl;
+		}
+	}
+
+	// Returns the exit status for main(): EXIT_FAILURE if any check() has failed, otherwise prints summary and returns EXIT_SUCCESS
+	inline int testResult(const std::string& summary)
+	{
+		if (testFailed())
+			return EXIT_FAILURE;
+
+		std::cout << summary << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+} // namespace bench
+
+#endif // AURORA_BENCH_TEST_HPP
@@ -0,0 +1,190 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Compares SingleDispatcher and DoubleDispatcher with VariantDispatchTraits against std::visit on the same variants, and
+// against dispatchers with RttiDispatchTraits on an equivalent class hierarchy. Measures call throughput and latency for
+// 4, 8 and 32 alternatives, with uniform and skewed type distributions.
+
+#include "Benchmark.hpp"
+#include "Hierarchy.hpp"
+
+#include <Aurora/Dispatch.hpp>
+
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+
+namespace
+{
+
+	using namespace bench;
+
+	const std::size_t workloadLength = 4096;
+	const std::size_t mask = workloadLength - 1;
+
+	std::string parameters(std::size_t types, bool skewed)
+	{
+		return "types=" + std::to_string(types) + " distribution=" + (skewed ? "zipf" : "uniform");
+	}
+
+	// Variants holding the same alternatives and payloads as the objects of a workload
+	template <class F>
+	std::vector<typename F::Variant> variantsOf(const Workload<F>& workload)
+	{
+		std::vector<typename F::Variant> variants;
+		for (std::size_t i = 0; i < workload.types.size(); ++i)
+			variants.push_back(F::createVariant(workload.types[i], workload.objects[i]->payload));
+
+		return variants;
+	}
+
+	// Throughput: independent calls over the elements
+	template <typename T, typename Fn>
+	void runThroughput(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const std::vector<T>& elements, Fn call)
+	{
+		const std::size_t operations = reporter.scale(1u << 22);
+		reporter.run("call_throughput", implementation, params, operations, [&] ()
+		{
+			int sum = 0;
+			for (std::size_t i = 0; i < operations; ++i)
+				sum += call(elements[i & mask]);
+
+			keep(sum);
+		});
+	}
+
+	// Latency: the next element depends on the result of the previous call, so calls cannot overlap
+	template <typename T, typename Fn>
+	void runLatency(Reporter& reporter, const std::string& implementation, const std::string& params,
+		const std::vector<T>& elements, Fn call)
+	{
+		const std::size_t operations = reporter.scale(1u << 20);
+		reporter.run("call_latency", implementation, params, operations, [&] ()
+		{
+			std::size_t index = 0;
+			for (std::size_t i = 0; i < operations; ++i)
+				index = (index + 1 + static_cast<std::size_t>(call(elements[index]) & 1)) & mask;
+
+			keep(index);
+		});
+	}
+
+	template <class F>
+	void runFamily(Reporter& reporter)
+	{
+		typedef typename F::Variant Variant;
+
+		aurora::SingleDispatcher<int(const Variant&), aurora::VariantDispatchTraits<Variant>> variant;
+		aurora::SingleDispatcher<int(const Base&), aurora::RttiDispatchTraits<int(const Base&), 1>, aurora::HashStorage> rttiHash;
+		aurora::SingleDispatcher<int(const Base&), aurora::RttiDispatchTraits<int(const Base&), 1>, aurora::FlatStorage> rttiFlat;
+
+		F::bindAll(variant);
+		F::bindAll(rttiHash);
+		F::bindAll(rttiFlat);
+
+		auto visitor = [] (const auto& object)
+		{
+			return Handler<std::decay_t<decltype(object)>::index>()(object);
+		};
+
+		for (bool skewed : { false, true })
+		{
+			const Workload<F> workload(workloadLength, skewed, 100u);
+			const std::vector<Variant> variants = variantsOf(workload);
+			const std::string params = parameters(F::size, skewed);
+
+			runThroughput(reporter, "SingleDispatcher/Variant/ArrayStorage", params, variants, [&] (const Variant& v) { return variant.call(v); });
+			runThroughput(reporter, "std::visit", params, variants, [&] (const Variant& v) { return std::visit(visitor, v); });
+			runThroughput(reporter, "SingleDispatcher/Rtti/HashStorage", params, workload.objects, [&] (const Base* b) { return rttiHash.call(*b); });
+			runThroughput(reporter, "SingleDispatcher/Rtti/FlatStorage", params, workload.objects, [&] (const Base* b) { return rttiFlat.call(*b); });
+
+			runLatency(reporter, "SingleDispatcher/Variant/ArrayStorage", params, variants, [&] (const Variant& v) { return variant.call(v); });
+			runLatency(reporter, "std::visit", params, variants, [&] (const Variant& v) { return std::visit(visitor, v); });
+			runLatency(reporter, "SingleDispatcher/Rtti/HashStorage", params, workload.objects, [&] (const Base* b) { return rttiHash.call(*b); });
+			runLatency(reporter, "SingleDispatcher/Rtti/FlatStorage", params, workload.objects, [&] (const Base* b) { return rttiFlat.call(*b); });
+		}
+	}
+
+	// DoubleDispatcher with all ordered pairs registered
+	template <class F>
+	void runPairs(Reporter& reporter)
+	{
+		typedef typename F::Variant Variant;
+
+		aurora::DoubleDispatcher<int(const Variant&, const Variant&), aurora::VariantDispatchTraits<Variant>> variant(false);
+		aurora::DoubleDispatcher<int(const Base&, const Base&), aurora::RttiDispatchTraits<int(const Base&, const Base&), 2>> rtti(false);
+
+		F::bindAllPairs(variant);
+		F::bindAllPairs(rtti);
+
+		auto visitor = [] (const auto& a, const auto& b)
+		{
+			return PairHandler<std::decay_t<decltype(a)>::index, std::decay_t<decltype(b)>::index>()(a, b);
+		};
+
+		for (bool skewed : { false, true })
+		{
+			const Workload<F> first(workloadLength, skewed, 100u, 1);
+			const Workload<F> second(workloadLength, skewed, 100u, 2);
+			const std::vector<Variant> lhs = variantsOf(first);
+			const std::vector<Variant> rhs = variantsOf(second);
+			const std::string params = parameters(F::size, skewed);
+			const std::size_t operations = reporter.scale(1u << 21);
+
+			auto runPairThroughput = [&] (const std::string& implementation, auto call)
+			{
+				reporter.run("pair_throughput", implementation, params, operations, [&] ()
+				{
+					int sum = 0;
+					for (std::size_t i = 0; i < operations; ++i)
+						sum += call(i & mask, (i * 7) & mask);
+
+					keep(sum);
+				});
+			};
+
+			runPairThroughput("DoubleDispatcher/Variant/ArrayStorage", [&] (std::size_t i, std::size_t j) { return variant.call(lhs[i], rhs[j]); });
+			runPairThroughput("std::visit", [&] (std::size_t i, std::size_t j) { return std::visit(visitor, lhs[i], rhs[j]); });
+			runPairThroughput("DoubleDispatcher/Rtti/HashStorage", [&] (std::size_t i, std::size_t j) { return rtti.call(*first.objects[i], *second.objects[j]); });
+		}
+	}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+	Reporter reporter("variant", argc, argv);
+
+	runFamily<Family<4>>(reporter);
+	runFamily<Family<8>>(reporter);
+	runFamily<Family<32>>(reporter);
+
+	runPairs<Family<4>>(reporter);
+	runPairs<Family<8>>(reporter);
+}
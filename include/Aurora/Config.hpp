@@ -52,29 +52,37 @@
 // Output useful error message if MSVC, Clang or g++ compilers do not support C++11
 // Cascaded because symbols are not 100% reliable, clang sometimes defines g++ macros
 #if defined(_MSC_VER)
-	#if _MSC_VER < 1600
-		#error At least Visual Studio 2010 is required.
+	#if _MSC_VER < 1900
+		#error At least Visual Studio 2015 is required.
 	#endif
 #elif defined(__clang__)
-	#if 100*__clang_major__ + __clang_minor__ < 301
-		#error At least Clang 3.1 is required.
+	#if 100*__clang_major__ + __clang_minor__ < 303
+		#error At least Clang 3.3 is required.
 	#endif
 #elif defined(__GNUC__)
-	#if 100*__GNUC__ + __GNUC_MINOR__ < 406
-		#error At least g++ 4.6 is required.
+	#if 100*__GNUC__ + __GNUC_MINOR__ < 408
+		#error At least g++ 4.8 is required.
 	#endif
 #endif
 
 
-// Find out whether variadic templates are supported (VC++, gcc, clang)
-#if defined(_MSC_VER) && _MSC_VER >= 1800
-	#define AURORA_HAS_VARIADIC_TEMPLATES
-#elif defined(__clang__)
-	#if __has_feature(cxx_variadic_templates)
-		#define AURORA_HAS_VARIADIC_TEMPLATES
-	#endif
-#elif defined(__GNUG__) && (defined(__VARIADIC_TEMPLATES) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 4 && defined(__GXX_EXPERIMENTAL_CXX0X__)))
-	#define AURORA_HAS_VARIADIC_TEMPLATES
+// All supported compilers implement variadic templates; the macro is kept for code that still checks it
+#define AURORA_HAS_VARIADIC_TEMPLATES
+
+
+// Find out which SIMD instruction sets can be used (SSE2 is part of every x86-64 target)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define AURORA_HAS_SSE2
+#endif
+
+#if defined(__AVX2__)
+	#define AURORA_HAS_AVX2
+#endif
+
+
+// Find out whether C++17 is available, in particular its library additions such as std::string_view
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+	#define AURORA_HAS_CXX17
 #endif
 
 #endif // AURORA_CONFIG_HPP
@@ -29,8 +29,16 @@
 #ifndef AURORA_MODULE_DISPATCH_HPP
 #define AURORA_MODULE_DISPATCH_HPP
 
+#include <Aurora/Dispatch/AsyncDispatch.hpp>
+#include <Aurora/Dispatch/ConcurrentDispatcher.hpp>
+#include <Aurora/Dispatch/DispatchQueue.hpp>
+#include <Aurora/Dispatch/DispatchStatistics.hpp>
+#include <Aurora/Dispatch/DispatchStorage.hpp>
 #include <Aurora/Dispatch/DispatchTraits.hpp>
 #include <Aurora/Dispatch/DoubleDispatcher.hpp>
+#include <Aurora/Dispatch/MulticastDispatcher.hpp>
+#include <Aurora/Dispatch/MultiDispatcher.hpp>
 #include <Aurora/Dispatch/SingleDispatcher.hpp>
+#include <Aurora/Dispatch/StaticDispatcher.hpp>
 
 #endif // AURORA_MODULE_DISPATCH_HPP
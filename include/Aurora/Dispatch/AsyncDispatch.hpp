@@ -0,0 +1,294 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file
+/// @brief Function aurora::callAsync() and class aurora::AsyncPolicy
+
+#ifndef AURORA_ASYNCDISPATCH_HPP
+#define AURORA_ASYNCDISPATCH_HPP
+
+#include <Aurora/Dispatch/SingleDispatcher.hpp>
+#include <Aurora/Dispatch/ConcurrentDispatcher.hpp>
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Tools/WorkerPool.hpp>
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Meta/Variadic.hpp>
+#include <Aurora/Config.hpp>
+
+#include <functional>
+#include <future>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Determines where aurora::callAsync() executes a function
+///
+enum class AsyncMode
+{
+	Pool,	///< The function is executed by a thread of aurora::WorkerPool::global() (default)
+	Inline,	///< The function is executed immediately by the calling thread, suited for cheap functions
+};
+
+/// @}
+
+
+namespace detail
+{
+
+	// Type in which an asynchronous call keeps the user argument for parameter P: lvalue references are kept, the
+	// referenced object must then outlive the call. Other arguments are copied or moved into the task.
+	template <typename P>
+	struct AsyncValue
+	{
+		typedef typename std::conditional<std::is_lvalue_reference<P>::value, P, typename std::decay<P>::type>::type Type;
+	};
+
+	template <typename Signature, typename Indices>
+	struct AsyncValues;
+
+	template <typename Signature, std::size_t... Is>
+	struct AsyncValues<Signature, IndexSequence<Is...>>
+	{
+		typedef std::tuple<typename AsyncValue<typename FunctionParam<Signature, Is + 1>::Type>::Type...> Type;
+	};
+
+	// Function object executed by the worker thread: invokes the resolved function with the dispatched object and the
+	// stored user arguments
+	template <typename Signature>
+	class AsyncTask
+	{
+		private:
+			typedef typename FunctionResult<Signature>::Type										Result;
+			typedef typename FunctionParam<Signature, 0>::Type										Parameter;
+			typedef typename std::remove_pointer<typename std::remove_reference<Parameter>::type>::type* Object;
+			typedef MakeIndexSequence<FunctionArity<Signature>::value - 1u>						Indices;
+			typedef typename AsyncValues<Signature, Indices>::Type									Values;
+
+		public:
+			template <typename... Args>
+			AsyncTask(std::function<Signature> function, Object object, Args&&... args)
+			: mFunction(std::move(function))
+			, mObject(object)
+			, mValues(std::forward<Args>(args)...)
+			{
+			}
+
+			Result operator() ()
+			{
+				return invoke(Indices());
+			}
+
+		private:
+			// Values are moved into parameters taken by value or rvalue reference, references are passed on
+			template <std::size_t... Is>
+			Result invoke(IndexSequence<Is...>)
+			{
+				return mFunction(toParameter<Parameter>(mObject), std::forward<typename FunctionParam<Signature, Is + 1>::Type>(std::get<Is>(mValues))...);
+			}
+
+		private:
+			std::function<Signature>	mFunction;
+			Object						mObject;
+			Values						mValues;
+	};
+
+	template <typename Function>
+	struct ResolvedSignature;
+
+	template <typename Signature>
+	struct ResolvedSignature<std::function<Signature>>
+	{
+		typedef Signature Type;
+	};
+
+	// Policy of callAsync() without aurora::AsyncPolicy
+	struct PoolPolicy
+	{
+		template <typename Parameter>
+		AsyncMode mode(Parameter&&) const
+		{
+			return AsyncMode::Pool;
+		}
+	};
+
+	template <class Dispatcher, class Policy, typename Arg, typename... Args>
+	std::future<typename Dispatcher::Result> callAsync(const Dispatcher& dispatcher, const Policy& policy, Arg&& arg, Args&&... args)
+	{
+		typedef typename ResolvedSignature<decltype(dispatcher.resolve(std::declval<Arg>()))>::Type	Signature;
+		typedef typename FunctionResult<Signature>::Type											Result;
+		typedef typename FunctionParam<Signature, 0>::Type											Parameter;
+
+		static_assert(sizeof...(Args) + 1u == FunctionArity<Signature>::value, "callAsync() expects the arguments specified by Signature.");
+
+		// The object is captured by address, Parameter may be a reference
+		Parameter parameter = std::forward<Arg>(arg);
+		AsyncTask<Signature> task(dispatcher.resolve(parameter), &deref(parameter), std::forward<Args>(args)...);
+
+		if (policy.mode(parameter) == AsyncMode::Inline)
+		{
+			std::packaged_task<Result()> inlineTask(std::move(task));
+			std::future<Result> future = inlineTask.get_future();
+
+			inlineTask();
+			return future;
+		}
+
+		return WorkerPool::global().submit(std::move(task));
+	}
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Assigns an aurora::AsyncMode to specific keys, which callAsync() uses to decide where a function is executed
+/// @details Heavy functions should be executed by the pool, while the overhead of a thread switch is not worth it for
+///  cheap ones. The mode refers to the exact key of the dispatched object; when the dispatcher resolves base classes,
+///  objects of derived classes use the mode of their own key, not that of their base. The policy is independent of the
+///  dispatcher and can be shared by several dispatchers with the same traits.
+/// @tparam Traits Traits class of the dispatcher, such as <tt>Dispatcher::KeyTraits</tt>.
+/// @tparam Storage Storage policy of the table that maps keys to modes. Defaults to the storage of @a Traits.
+/// @code
+/// aurora::AsyncPolicy<Dispatcher::KeyTraits> policy;
+/// policy.mode(aurora::Type<Circle>(), aurora::AsyncMode::Inline);
+///
+/// std::future<int> area = aurora::callAsync(policy, dispatcher, shape);
+/// @endcode
+template <typename Traits, typename Storage = typename detail::TraitsStorage<Traits>::Type>
+class AsyncPolicy
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Static assertions
+
+	// Make sure that non-owning string keys are copied by the table
+	static_assert(detail::OwnsKeys<typename Traits::Key, Storage>::value,
+		"aurora::StringKey keys require aurora::StringStorage, which copies the characters.");
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Constructor
+		/// @param defaultMode Mode of the keys for which mode() has not been called.
+		explicit AsyncPolicy(AsyncMode defaultMode = AsyncMode::Pool)
+		: mModes()
+		, mDefaultMode(defaultMode)
+		{
+		}
+
+		/// @brief Sets the mode of a specific key
+		/// @param identifier Value that identifies the object, as in the dispatcher's bind().
+		/// @param mode Whether the function is executed by the pool or the calling thread.
+		template <typename Id>
+		void mode(const Id& identifier, AsyncMode mode)
+		{
+			mModes.insert(Traits::keyFromId(identifier), mode);
+		}
+
+		/// @brief Returns the mode for the key of @c arg
+		///
+		template <typename Parameter>
+		AsyncMode mode(Parameter&& arg) const
+		{
+			// Look up the mode only if any has been set
+			if (mModes.size() == 0u)
+				return mDefaultMode;
+
+			const AsyncMode* mode = mModes.find(Traits::keyFromBase(arg));
+			return mode ? *mode : mDefaultMode;
+		}
+
+		/// @brief Declares that no more modes will be set, see the storage policy.
+		///
+		void seal()
+		{
+			mModes.seal();
+		}
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		typename Storage::template Table<typename Traits::Key, AsyncMode, Hasher>	mModes;
+		AsyncMode																	mDefaultMode;
+};
+
+/// @brief Dispatches the key of an object and executes the corresponding function asynchronously
+/// @details The function is looked up on the calling thread using the dispatcher's resolve() method. It is then
+///  executed by a thread of aurora::WorkerPool::global(), and callAsync() returns immediately. The function object is
+///  copied, so the dispatcher may be modified in the meantime. If no function is registered, the fallback function is
+///  executed asynchronously instead.
+///  @n@n The object referred to by the first argument must stay alive until the function has finished, i.e. the future is
+///  ready. User arguments for parameters of lvalue reference type are passed by reference, so the referenced objects must
+///  stay alive as well; all other user arguments are copied or moved into the task, and moved into the function. Move-only
+///  types can therefore be passed as rvalues.
+///  @n@n Calls are recorded by the dispatcher's statistics when the function is executed, misses when callAsync() is invoked.
+///  The dispatcher may be an aurora::SingleDispatcher, or an aurora::ConcurrentDispatcher wrapping one, in which case
+///  callAsync() can be invoked concurrently with modifications.
+/// @code
+/// aurora::SingleDispatcher<int(Shape&)> dispatcher;
+/// std::future<int> area = aurora::callAsync(dispatcher, shape);
+/// @endcode
+/// @param dispatcher Dispatcher that determines the function.
+/// @param args Object to dispatch, as a reference or pointer, followed by one argument for each further parameter of the
+///  dispatcher's signature.
+/// @return Future that receives the return value of the function, or the exception thrown by it.
+/// @throw FunctionCallException when no corresponding function is found and no fallback has been registered.
+///  In this case, the exception is thrown by callAsync() and not stored in the future.
+template <class Dispatcher, typename... Args>
+std::future<typename Dispatcher::Result> callAsync(const Dispatcher& dispatcher, Args&&... args)
+{
+	return detail::callAsync(dispatcher, detail::PoolPolicy(), std::forward<Args>(args)...);
+}
+
+/// @brief Dispatches the key of an object and executes the corresponding function according to a policy
+/// @details Like callAsync(const Dispatcher&, Args&&...), but functions whose key has aurora::AsyncMode::Inline in
+///  @c policy are executed immediately by the calling thread; the returned future is then already ready.
+/// @param policy Modes of the keys.
+/// @param dispatcher Dispatcher that determines the function.
+/// @param args Object to dispatch, followed by the user arguments.
+template <typename Traits, typename Storage, class Dispatcher, typename... Args>
+std::future<typename Dispatcher::Result> callAsync(const AsyncPolicy<Traits, Storage>& policy, const Dispatcher& dispatcher, Args&&... args)
+{
+	return detail::callAsync(dispatcher, policy, std::forward<Args>(args)...);
+}
+
+/// @}
+
+} // namespace aurora
+
+#endif // AURORA_ASYNCDISPATCH_HPP
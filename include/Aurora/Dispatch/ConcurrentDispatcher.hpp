@@ -0,0 +1,177 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class template aurora::ConcurrentDispatcher
+
+#ifndef AURORA_CONCURRENTDISPATCHER_HPP
+#define AURORA_CONCURRENTDISPATCHER_HPP
+
+#include <Aurora/Dispatch/DispatchStatistics.hpp>
+#include <Aurora/Dispatch/Detail/Epoch.hpp>
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Adapter that allows dispatchers to be modified while other threads invoke them.
+/// @details A dispatcher such as aurora::SingleDispatcher or aurora::DoubleDispatcher may be used by multiple threads
+///  concurrently only as long as nobody registers functions. ConcurrentDispatcher lifts this restriction without locking
+///  in call(): the dispatcher is treated as an immutable snapshot, and modifications create a modified copy, which is
+///  atomically published to subsequent calls. Old snapshots are retired and deleted on the writer side once no thread
+///  can access them anymore (epoch-based reclamation): by the next modification, by collect(), or by the destructor.
+///  @n@n call() is wait-free, apart from the first call in each thread, which registers the thread; readers only announce
+///  and clear their epoch and never delete snapshots. Modifications copy the whole dispatcher and are serialized by a
+///  mutex, so this adapter is meant for dispatchers that are read much more often than they are modified.
+/// @tparam Dispatcher The underlying dispatcher, e.g. <tt>aurora::SingleDispatcher<void(Base&)></tt>.
+/// @code
+/// aurora::ConcurrentDispatcher<aurora::SingleDispatcher<void(Base&)>> dispatcher;
+/// dispatcher.bind(aurora::Type<Derived>(), &func);
+///
+/// // Any thread, even during bind()
+/// dispatcher.call(object);
+/// @endcode
+template <class Dispatcher>
+class ConcurrentDispatcher : private NonCopyable
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public types
+	public:
+		/// @brief Function return type
+		///
+		typedef typename Dispatcher::Result						Result;
+
+		/// @brief Return type of tryCall()
+		///
+		typedef typename Dispatcher::TryResult					TryResult;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Constructor
+		/// @param args Arguments forwarded to the dispatcher's constructor.
+		template <typename... Args>
+		explicit					ConcurrentDispatcher(Args&&... args);
+
+		/// @brief Destructor
+		/// @details No thread may be calling the dispatcher during destruction.
+									~ConcurrentDispatcher();
+
+		/// @brief Registers a function, see the underlying dispatcher's bind() method.
+		/// @details Publishes a new snapshot of the dispatcher. Calls that have started before may still use the old one.
+		template <typename... Args>
+		void						bind(Args&&... args);
+
+		/// @brief Registers a fallback function, see the underlying dispatcher's fallback() method.
+		///
+		template <typename Fn>
+		void						fallback(Fn function);
+
+		/// @brief Declares that no more functions will be registered, see the underlying dispatcher's seal() method.
+		///
+		void						seal();
+
+		/// @brief Reorganizes the table according to the calls so far, see the underlying dispatcher's optimize() method.
+		/// @details Publishes a new snapshot of the dispatcher.
+		void						optimize();
+
+		/// @brief Dispatches the arguments and invokes the corresponding function, see the underlying dispatcher's call() method.
+		/// @details Can be invoked concurrently with any other method, except the destructor.
+		template <typename... Args>
+		Result						call(Args&&... args) const;
+
+		/// @brief Invokes the corresponding function if registered, see the underlying dispatcher's tryCall() method.
+		/// @details Can be invoked concurrently with any other method, except the destructor.
+		template <typename... Args>
+		TryResult					tryCall(Args&&... args) const;
+
+		/// @brief Checks whether a function is registered, see the underlying dispatcher's contains() method.
+		/// @details Can be invoked concurrently with any other method, except the destructor.
+		template <typename... Ids>
+		bool						contains(const Ids&... identifiers) const;
+
+		/// @brief Returns a copy of the function for @c arg, see the underlying dispatcher's resolve() method.
+		/// @details Can be invoked concurrently with any other method, except the destructor. The returned function does
+		///  not refer to the snapshot, so it stays valid after modifications. Only available if the underlying
+		///  dispatcher has resolve(), the second template parameter only defers the check.
+		template <typename Arg, class D = Dispatcher>
+		auto						resolve(Arg&& arg) const -> decltype(std::declval<const D&>().resolve(std::forward<Arg>(arg)));
+
+		/// @brief Returns the recorded statistics, see the underlying dispatcher's statistics() method.
+		/// @details Statistics are shared between all snapshots of the dispatcher.
+		DispatchReport				statistics() const;
+
+		/// @brief Deletes retired snapshots that no thread accesses anymore.
+		/// @details Modifications already do this, so collect() is only needed to free memory when the dispatcher is no
+		///  longer modified, while readers may have kept old snapshots alive during the last modification. Waits for
+		///  modifications in progress, but never for readers.
+		void						collect();
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		typedef std::pair<std::size_t, std::unique_ptr<Dispatcher>>	RetiredDispatcher;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		// Copies the current dispatcher, applies modification to the copy, publishes it and retires the current one
+		template <typename Fn>
+		void						modify(Fn modification);
+
+		// Deletes retired dispatchers that are no longer accessed by any thread; requires the modification mutex
+		void						reclaim();
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		std::atomic<Dispatcher*>				mCurrent;
+		std::vector<RetiredDispatcher>			mRetired;
+		mutable std::mutex						mModifyMutex;
+};
+
+/// @}
+
+} // namespace aurora
+
+#include <Aurora/Dispatch/Detail/ConcurrentDispatcher.inl>
+
+#endif // AURORA_CONCURRENTDISPATCHER_HPP
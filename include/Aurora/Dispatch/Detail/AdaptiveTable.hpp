@@ -0,0 +1,251 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Table for dispatchers that checks the most frequently used keys first
+
+#ifndef AURORA_ADAPTIVETABLE_HPP
+#define AURORA_ADAPTIVETABLE_HPP
+
+#include <Aurora/Tools/Optional.hpp>
+#include <Aurora/Config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Wraps a table of the storage policy Base. Lookups are sampled, i.e. every few lookups in a thread increment the hit
+	// counter of the found entry. optimize() copies the keys with the most hits to a front array of size N, which is
+	// searched linearly before the main table. The front array references the main table's entries and is rebuilt
+	// whenever these may have moved.
+	template <typename Key, typename Value, typename Hash, typename Base, std::size_t N>
+	class AdaptiveTable
+	{
+		private:
+			// Value with a hit counter that is incremented during (const) lookups
+			struct Entry
+			{
+				explicit Entry(Value value)
+				: value(std::move(value))
+				, hits(0u)
+				{
+				}
+
+				Entry(const Entry& origin)
+				: value(origin.value)
+				, hits(origin.hits.load(std::memory_order_relaxed))
+				{
+				}
+
+				Entry(Entry&& source)
+				: value(std::move(source.value))
+				, hits(source.hits.load(std::memory_order_relaxed))
+				{
+				}
+
+				Entry& operator= (const Entry& origin)
+				{
+					value = origin.value;
+					hits.store(origin.hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					return *this;
+				}
+
+				Entry& operator= (Entry&& source)
+				{
+					value = std::move(source.value);
+					hits.store(source.hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					return *this;
+				}
+
+				Value								value;
+				mutable std::atomic<std::uint32_t>	hits;
+			};
+
+			typedef typename Base::template Table<Key, Entry, Hash> MainTable;
+
+			// On average, one of sampleRate lookups per thread is counted
+			static const std::uint32_t sampleRate = 8u;
+
+		public:
+			AdaptiveTable()
+			: mMain()
+			, mKeys()
+			, mFrontKeys()
+			, mFrontEntries()
+			, mFrontSize(0u)
+			{
+			}
+
+			AdaptiveTable(const AdaptiveTable& origin)
+			: mMain(origin.mMain)
+			, mKeys(origin.mKeys)
+			, mFrontKeys()
+			, mFrontEntries()
+			, mFrontSize(origin.mFrontSize)
+			{
+				std::copy(origin.mFrontKeys, origin.mFrontKeys + N, mFrontKeys);
+				refreshFront();
+			}
+
+			AdaptiveTable(AdaptiveTable&& source)
+			: mMain(std::move(source.mMain))
+			, mKeys(std::move(source.mKeys))
+			, mFrontKeys()
+			, mFrontEntries()
+			, mFrontSize(source.mFrontSize)
+			{
+				std::copy(source.mFrontKeys, source.mFrontKeys + N, mFrontKeys);
+				refreshFront();
+				source.mFrontSize = 0u;
+			}
+
+			AdaptiveTable& operator= (AdaptiveTable origin)
+			{
+				mMain = std::move(origin.mMain);
+				mKeys = std::move(origin.mKeys);
+				std::copy(origin.mFrontKeys, origin.mFrontKeys + N, mFrontKeys);
+				mFrontSize = origin.mFrontSize;
+				refreshFront();
+
+				return *this;
+			}
+
+			Value* find(const Key& key)
+			{
+				return const_cast<Value*>(static_cast<const AdaptiveTable&>(*this).find(key));
+			}
+
+			const Value* find(const Key& key) const
+			{
+				for (std::size_t i = 0u; i < mFrontSize; ++i)
+				{
+					if (*mFrontKeys[i] == key)
+						return sample(*mFrontEntries[i]);
+				}
+
+				if (const Entry* entry = mMain.find(key))
+					return sample(*entry);
+
+				return nullptr;
+			}
+
+			void insert(const Key& key, Value value)
+			{
+				if (!mMain.find(key))
+					mKeys.push_back(key);
+
+				mMain.insert(key, Entry(std::move(value)));
+				refreshFront();
+			}
+
+			std::size_t size() const
+			{
+				return mMain.size();
+			}
+
+			void seal()
+			{
+				mMain.seal();
+				refreshFront();
+			}
+
+			// Promotes the N most frequently hit keys to the front array, and halves all counters, so that the next
+			// optimization favors recent hits
+			void optimize()
+			{
+				std::vector<std::pair<std::uint32_t, std::size_t>> ranking;
+				ranking.reserve(mKeys.size());
+
+				for (std::size_t i = 0u; i < mKeys.size(); ++i)
+				{
+					const Entry* entry = mMain.find(mKeys[i]);
+					const std::uint32_t hits = entry->hits.load(std::memory_order_relaxed);
+
+					if (hits != 0u)
+						ranking.push_back(std::make_pair(hits, i));
+
+					entry->hits.store(hits / 2u, std::memory_order_relaxed);
+				}
+
+				const std::size_t size = std::min(N, ranking.size());
+				std::partial_sort(ranking.begin(), ranking.begin() + size, ranking.end(),
+					[] (const std::pair<std::uint32_t, std::size_t>& lhs, const std::pair<std::uint32_t, std::size_t>& rhs)
+				{
+					return lhs.first > rhs.first;
+				});
+
+				for (std::size_t i = 0u; i < size; ++i)
+					mFrontKeys[i] = mKeys[ranking[i].second];
+
+				mFrontSize = size;
+				refreshFront();
+			}
+
+		private:
+			static const Value* sample(const Entry& entry)
+			{
+				// Random intervals (xorshift), so that periodic lookup patterns don't always sample the same keys
+				static thread_local std::uint32_t random = 0x9e3779b9u;
+				static thread_local std::uint32_t countdown = sampleRate;
+
+				if (--countdown == 0u)
+				{
+					random ^= random << 13u;
+					random ^= random >> 17u;
+					random ^= random << 5u;
+					countdown = 1u + random % (2u * sampleRate - 1u);
+
+					entry.hits.fetch_add(1u, std::memory_order_relaxed);
+				}
+
+				return &entry.value;
+			}
+
+			// Looks up the entries of the front keys again, after the main table may have moved them
+			void refreshFront()
+			{
+				for (std::size_t i = 0u; i < mFrontSize; ++i)
+					mFrontEntries[i] = mMain.find(*mFrontKeys[i]);
+			}
+
+		private:
+			MainTable					mMain;
+			std::vector<Key>			mKeys;
+			Optional<Key>				mFrontKeys[N];
+			const Entry*				mFrontEntries[N];
+			std::size_t					mFrontSize;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_ADAPTIVETABLE_HPP
@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Memory arena that allocates objects in chunks and releases them all at once
+
+#ifndef AURORA_ARENA_HPP
+#define AURORA_ARENA_HPP
+
+#include <Aurora/Tools/NonCopyable.hpp>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Bump allocator. reset() keeps the chunks for reuse, so memory consumption is bounded by the largest amount allocated
+	// between two resets.
+	class Arena : private NonCopyable
+	{
+		public:
+			Arena()
+			: mChunks()
+			, mCurrent(0u)
+			, mOffset(0u)
+			{
+			}
+
+			Arena(Arena&& source)
+			: mChunks(std::move(source.mChunks))
+			, mCurrent(source.mCurrent)
+			, mOffset(source.mOffset)
+			{
+				source.mCurrent = 0u;
+				source.mOffset = 0u;
+			}
+
+			Arena& operator= (Arena&& source)
+			{
+				mChunks = std::move(source.mChunks);
+				mCurrent = source.mCurrent;
+				mOffset = source.mOffset;
+				source.mCurrent = 0u;
+				source.mOffset = 0u;
+
+				return *this;
+			}
+
+			void* allocate(std::size_t size, std::size_t alignment)
+			{
+				// Try current chunk, then the following (reused) chunks, then allocate a new one
+				for (; mCurrent < mChunks.size(); ++mCurrent, mOffset = 0u)
+				{
+					if (void* memory = allocateFrom(mChunks[mCurrent], size, alignment))
+						return memory;
+				}
+
+				std::size_t capacity = size + alignment;
+				if (capacity < ChunkSize)
+					capacity = ChunkSize;
+
+				Chunk chunk = { std::unique_ptr<char[]>(new char[capacity]), capacity };
+				mChunks.push_back(std::move(chunk));
+				mOffset = 0u;
+
+				return allocateFrom(mChunks.back(), size, alignment);
+			}
+
+			void reset()
+			{
+				mCurrent = 0u;
+				mOffset = 0u;
+			}
+
+		private:
+			static const std::size_t ChunkSize = 64u * 1024u;
+
+			struct Chunk
+			{
+				std::unique_ptr<char[]>		memory;
+				std::size_t					size;
+			};
+
+		private:
+			void* allocateFrom(const Chunk& chunk, std::size_t size, std::size_t alignment)
+			{
+				const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(chunk.memory.get());
+				const std::uintptr_t aligned = (begin + mOffset + alignment - 1u) / alignment * alignment;
+
+				if (aligned + size > begin + chunk.size)
+					return nullptr;
+
+				mOffset = aligned + size - begin;
+				return reinterpret_cast<void*>(aligned);
+			}
+
+		private:
+			std::vector<Chunk>				mChunks;
+			std::size_t						mCurrent;
+			std::size_t						mOffset;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_ARENA_HPP
@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Table for dispatchers with keys of bounded range: values are stored in a fixed-size array indexed by the key
+
+#ifndef AURORA_ARRAYTABLE_HPP
+#define AURORA_ARRAYTABLE_HPP
+
+#include <Aurora/Tools/Optional.hpp>
+#include <Aurora/Tools/Exceptions.hpp>
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cassert>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Maps integral keys (or enumerators) in [0, Size) to values. Keys out of range throw on insertion, lookups only check
+	// them in debug mode.
+	template <typename Key, typename Value, typename Hash, std::size_t Size>
+	class ArrayTable
+	{
+		static_assert(std::is_integral<Key>::value || std::is_enum<Key>::value,
+			"ArrayStorage requires integral or enum keys.");
+
+		public:
+			ArrayTable()
+			: mValues()
+			, mSize(0u)
+			{
+			}
+
+			Value* find(const Key& key)
+			{
+				return const_cast<Value*>(static_cast<const ArrayTable&>(*this).find(key));
+			}
+
+			const Value* find(const Key& key) const
+			{
+				const std::size_t index = static_cast<std::size_t>(key);
+				assert(index < Size);
+
+				if (mValues[index])
+					return &*mValues[index];
+				else
+					return nullptr;
+			}
+
+			void insert(const Key& key, Value value)
+			{
+				const std::size_t index = static_cast<std::size_t>(key);
+				checkRange(index);
+
+				if (!mValues[index])
+					++mSize;
+
+				mValues[index] = std::move(value);
+			}
+
+			std::size_t size() const
+			{
+				return mSize;
+			}
+
+			void seal()
+			{
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			// Registration is rare, so out-of-range keys are rejected also in release mode
+			static void checkRange(std::size_t index)
+			{
+				if (index >= Size)
+					throw FunctionCallException("ArrayStorage - key exceeds the size of the array");
+			}
+
+		private:
+			std::array<Optional<Value>, Size>	mValues;
+			std::size_t							mSize;
+	};
+
+
+	// Specialization for key pairs (double dispatch): fixed matrix of 32-bit indices into a separate value array
+	template <typename Key1, typename Key2, typename Value, typename Hash, std::size_t Size>
+	class ArrayTable<std::pair<Key1, Key2>, Value, Hash, Size>
+	{
+		static_assert((std::is_integral<Key1>::value || std::is_enum<Key1>::value)
+			&& (std::is_integral<Key2>::value || std::is_enum<Key2>::value),
+			"ArrayStorage requires integral or enum keys.");
+
+		public:
+			ArrayTable()
+			: mCells()
+			, mValues()
+			{
+				mCells.fill(0u);
+			}
+
+			Value* find(const std::pair<Key1, Key2>& key)
+			{
+				return const_cast<Value*>(static_cast<const ArrayTable&>(*this).find(key));
+			}
+
+			const Value* find(const std::pair<Key1, Key2>& key) const
+			{
+				// Cell value 0 denotes an empty cell, otherwise index + 1 into mValues
+				if (std::uint32_t cell = mCells[cellIndex(key)])
+					return &mValues[cell - 1u];
+				else
+					return nullptr;
+			}
+
+			void insert(const std::pair<Key1, Key2>& key, Value value)
+			{
+				checkRange(static_cast<std::size_t>(key.first));
+				checkRange(static_cast<std::size_t>(key.second));
+
+				std::uint32_t& cell = mCells[cellIndex(key)];
+				if (cell)
+				{
+					mValues[cell - 1u] = std::move(value);
+				}
+				else
+				{
+					mValues.push_back(std::move(value));
+					cell = static_cast<std::uint32_t>(mValues.size());
+				}
+			}
+
+			std::size_t size() const
+			{
+				return mValues.size();
+			}
+
+			void seal()
+			{
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			// Registration is rare, so out-of-range keys are rejected also in release mode
+			static void checkRange(std::size_t index)
+			{
+				if (index >= Size)
+					throw FunctionCallException("ArrayStorage - key exceeds the size of the array");
+			}
+
+			static std::size_t cellIndex(const std::pair<Key1, Key2>& key)
+			{
+				const std::size_t row = static_cast<std::size_t>(key.first);
+				const std::size_t column = static_cast<std::size_t>(key.second);
+				assert(row < Size && column < Size);
+
+				return row * Size + column;
+			}
+
+		private:
+			std::array<std::uint32_t, Size * Size>	mCells;
+			std::vector<Value>						mValues;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_ARRAYTABLE_HPP
@@ -0,0 +1,396 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Resolution of base classes for aurora::SingleDispatcher
+
+#ifndef AURORA_BASERESOLVER_HPP
+#define AURORA_BASERESOLVER_HPP
+
+#include <Aurora/Dispatch/DispatchTraits.hpp>
+#include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Tests whether an object derives from a registered class. throwPointer and catchesPointer determine whether registered
+	// classes derive from each other; they use exceptions and are therefore only invoked in bind().
+	template <typename Key, typename Parameter>
+	struct BaseProbe
+	{
+		Key			key;
+		bool		(*matches)(Parameter arg);
+		void		(*throwPointer)();
+		bool		(*catchesPointer)(void (*thrower)());
+	};
+
+	template <typename T, typename Parameter>
+	bool probeMatches(Parameter arg)
+	{
+		return dynamic_cast<const volatile T*>(&deref(arg)) != nullptr;
+	}
+
+	template <typename T>
+	void probeThrowPointer()
+	{
+		throw static_cast<T*>(nullptr);
+	}
+
+	// A thrown U* is caught by catch (T*) if and only if T is an unambiguous public base of U (or U itself)
+	template <typename T>
+	bool probeCatchesPointer(void (*thrower)())
+	{
+		try
+		{
+			thrower();
+		}
+		catch (T*)
+		{
+			return true;
+		}
+		catch (...)
+		{
+		}
+
+		return false;
+	}
+
+	// Probes are only available for aurora::Type<T> identifiers and polymorphic classes
+	template <typename Key, typename Parameter, typename Allocator, typename Id, bool Polymorphic>
+	void addBaseProbe(std::vector<BaseProbe<Key, Parameter>, Allocator>&, const Key&, const Id&, std::integral_constant<bool, Polymorphic>)
+	{
+	}
+
+	template <typename Key, typename Parameter, typename Allocator, typename T>
+	void addBaseProbe(std::vector<BaseProbe<Key, Parameter>, Allocator>& probes, const Key& key, const Type<T>&, std::true_type /*polymorphic*/)
+	{
+		typedef BaseProbe<Key, Parameter> Probe;
+
+		// Re-registered keys keep their probe
+		for (const Probe& probe : probes)
+		{
+			if (probe.key == key)
+				return;
+		}
+
+		// Keep the probes ordered such that derived classes precede their bases, by inserting before the first base of T.
+		// All classes deriving from T are located before that base already. The first probe matching an object is then
+		// one of its nearest registered bases.
+		auto position = std::find_if(probes.begin(), probes.end(), [] (const Probe& other)
+		{
+			return other.catchesPointer(&probeThrowPointer<T>);
+		});
+
+		Probe probe = { key, &probeMatches<T, Parameter>, &probeThrowPointer<T>, &probeCatchesPointer<T> };
+		probes.insert(position, probe);
+	}
+
+
+	// Deleter of objects created by allocateUnique()
+	template <typename T, typename Allocator>
+	class AllocatorDeleter
+	{
+		public:
+			AllocatorDeleter()
+			: mAllocator()
+			{
+			}
+
+			explicit AllocatorDeleter(const Allocator& allocator)
+			: mAllocator(allocator)
+			{
+			}
+
+			void operator() (T* pointer)
+			{
+				std::allocator_traits<Allocator>::destroy(mAllocator, pointer);
+				std::allocator_traits<Allocator>::deallocate(mAllocator, pointer, 1u);
+			}
+
+			const Allocator& allocator() const
+			{
+				return mAllocator;
+			}
+
+		private:
+			Allocator	mAllocator;
+	};
+
+	// Like std::make_unique(), but allocates the object through allocator, which must have value type T
+	template <typename T, typename Allocator, typename... Args>
+	std::unique_ptr<T, AllocatorDeleter<T, Allocator>> allocateUnique(const Allocator& allocator, Args&&... args)
+	{
+		typedef std::allocator_traits<Allocator> AllocTraits;
+
+		Allocator copy(allocator);
+		T* pointer = AllocTraits::allocate(copy, 1u);
+
+		try
+		{
+			AllocTraits::construct(copy, pointer, std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			AllocTraits::deallocate(copy, pointer, 1u);
+			throw;
+		}
+
+		return std::unique_ptr<T, AllocatorDeleter<T, Allocator>>(pointer, AllocatorDeleter<T, Allocator>(copy));
+	}
+
+
+	// State of a dispatcher that resolves base classes: the probes of the registered classes, and the memoized result of
+	// each key that has been resolved. Only allocated by dispatchers that resolve base classes.
+	//
+	// Resolved keys are stored in an insert-only hash table with linear probing, whose slots point to nodes. Readers look up
+	// the published slot array without locking; a miss takes the mutex, resolves the key and publishes its node with a
+	// release store. When the table grows, the node pointers are inserted into a twice as large array, which is then
+	// published. Readers may still probe older arrays, so they are kept until clear(), which must not be called concurrently
+	// with lookups -- together they use less than twice the memory of the current array, and no entry is ever copied.
+	template <typename Key, typename Parameter, typename Function, typename Hash, typename Allocator>
+	class BaseResolver
+	{
+		public:
+			explicit BaseResolver(const Allocator& allocator)
+			: mProbes(ProbeAllocator(allocator))
+			, mNodes(NodeAllocator(allocator))
+			, mArrays(ArrayAllocator(allocator))
+			, mCurrent(nullptr)
+			, mMutex()
+			{
+			}
+
+			~BaseResolver()
+			{
+				clear();
+			}
+
+			// Copies the probes, but not the resolved keys
+			BaseResolver(const BaseResolver& origin, const Allocator& allocator)
+			: mProbes(origin.mProbes, ProbeAllocator(allocator))
+			, mNodes(NodeAllocator(allocator))
+			, mArrays(ArrayAllocator(allocator))
+			, mCurrent(nullptr)
+			, mMutex()
+			{
+			}
+
+			// Adds a probe for the class of identifier, if it is a polymorphic aurora::Type<T>
+			template <typename Id>
+			void addProbe(const Key& key, const Id& identifier)
+			{
+				typedef typename std::remove_pointer<typename std::remove_reference<Parameter>::type>::type Base;
+				addBaseProbe(mProbes, key, identifier, std::is_polymorphic<Base>());
+			}
+
+			// Returns the function of the nearest registered base class of arg, or nullptr. lookup(key) returns the function
+			// registered for a key.
+			template <typename Lookup>
+			const Function* resolve(const Key& key, Parameter arg, Lookup lookup) const
+			{
+				const std::size_t hash = Hash()(key);
+
+				// Fast path: look up the published array without locking
+				if (const Node* node = find(key, hash))
+					return node->function;
+
+				// Without probes, nothing can be resolved. Not memoizing such keys also keeps non-owning keys out of the table.
+				if (mProbes.empty())
+					return nullptr;
+
+				std::lock_guard<std::mutex> lock(mMutex);
+
+				// Another thread may have resolved the key in the meantime
+				if (const Node* node = find(key, hash))
+					return node->function;
+
+				// Derived classes precede their bases, so the first registered class of which arg is an instance is the nearest base
+				const Function* function = nullptr;
+				for (const Probe& probe : mProbes)
+				{
+					if (probe.matches(arg))
+					{
+						function = lookup(probe.key);
+						break;
+					}
+				}
+
+				insert(key, hash, function);
+				return function;
+			}
+
+			// Discards all resolved keys, must not be called concurrently with resolve()
+			void clear()
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+
+				mCurrent.store(nullptr, std::memory_order_relaxed);
+				mNodes.clear();
+
+				SlotAllocator allocator(mArrays.get_allocator());
+				for (SlotArray& array : mArrays)
+				{
+					for (std::size_t i = 0u; i < array.size; ++i)
+						SlotTraits::destroy(allocator, array.slots + i);
+
+					SlotTraits::deallocate(allocator, array.slots, array.size);
+				}
+
+				mArrays.clear();
+			}
+
+		private:
+			typedef BaseProbe<Key, Parameter> Probe;
+
+			struct Node
+			{
+				Node(const Key& key, std::size_t hash, const Function* function)
+				: key(key)
+				, hash(hash)
+				, function(function)
+				{
+				}
+
+				Key					key;
+				std::size_t			hash;
+				const Function*		function;
+			};
+
+			struct Slot
+			{
+				Slot()
+				: node(nullptr)
+				{
+				}
+
+				std::atomic<const Node*>	node;
+			};
+
+			// Allocated through SlotAllocator directly: containers would pass polymorphic allocators on to their elements
+			struct SlotArray
+			{
+				Slot*			slots;
+				std::size_t		size;
+			};
+
+			typedef std::allocator_traits<Allocator>								AllocTraits;
+			typedef typename AllocTraits::template rebind_alloc<Probe>				ProbeAllocator;
+			typedef typename AllocTraits::template rebind_alloc<Node>				NodeAllocator;
+			typedef typename AllocTraits::template rebind_alloc<Slot>				SlotAllocator;
+			typedef std::allocator_traits<SlotAllocator>							SlotTraits;
+			typedef typename AllocTraits::template rebind_alloc<SlotArray>			ArrayAllocator;
+
+		private:
+			static std::size_t homeIndex(std::size_t hash, std::size_t mask)
+			{
+				return static_cast<std::size_t>(mixBits(hash)) & mask;
+			}
+
+			const Node* find(const Key& key, std::size_t hash) const
+			{
+				const SlotArray* slots = mCurrent.load(std::memory_order_acquire);
+				if (!slots)
+					return nullptr;
+
+				// Load factor is at most 1/2, so there is always an empty slot that terminates the loop
+				const std::size_t mask = slots->size - 1u;
+				for (std::size_t i = homeIndex(hash, mask); ; i = (i + 1u) & mask)
+				{
+					const Node* node = slots->slots[i].node.load(std::memory_order_acquire);
+
+					if (!node)
+						return nullptr;
+
+					if (node->hash == hash && node->key == key)
+						return node;
+				}
+			}
+
+			// Requires the mutex
+			void insert(const Key& key, std::size_t hash, const Function* function) const
+			{
+				SlotArray* current = mCurrent.load(std::memory_order_relaxed);
+				if (!current || 2u * (mNodes.size() + 1u) > current->size)
+					current = grow(current);
+
+				// The deque never relocates its elements
+				mNodes.emplace_back(key, hash, function);
+				place(*current, &mNodes.back());
+			}
+
+			// Requires the mutex; publishes and returns a new array with all nodes
+			SlotArray* grow(const SlotArray* current) const
+			{
+				SlotArray next = { nullptr, current ? 2u * current->size : 16u };
+
+				SlotAllocator allocator(mArrays.get_allocator());
+				next.slots = SlotTraits::allocate(allocator, next.size);
+				for (std::size_t i = 0u; i < next.size; ++i)
+					SlotTraits::construct(allocator, next.slots + i);
+
+				mArrays.push_back(next);
+				SlotArray& array = mArrays.back();
+				for (const Node& node : mNodes)
+					place(array, &node);
+
+				mCurrent.store(&array, std::memory_order_release);
+				return &array;
+			}
+
+			static void place(const SlotArray& slots, const Node* node)
+			{
+				const std::size_t mask = slots.size - 1u;
+
+				std::size_t i = homeIndex(node->hash, mask);
+				while (slots.slots[i].node.load(std::memory_order_relaxed))
+					i = (i + 1u) & mask;
+
+				slots.slots[i].node.store(node, std::memory_order_release);
+			}
+
+		private:
+			std::vector<Probe, ProbeAllocator>				mProbes;
+			mutable std::deque<Node, NodeAllocator>			mNodes;
+			mutable std::deque<SlotArray, ArrayAllocator>	mArrays;
+			mutable std::atomic<SlotArray*>					mCurrent;
+			mutable std::mutex								mMutex;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_BASERESOLVER_HPP
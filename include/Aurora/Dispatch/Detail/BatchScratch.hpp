@@ -0,0 +1,211 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Reusable buffers for the batched calls of SingleDispatcher and DoubleDispatcher
+
+#ifndef AURORA_BATCHSCRATCH_HPP
+#define AURORA_BATCHSCRATCH_HPP
+
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Config.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Groups the elements of a batch by function and sorts them with a stable counting sort. The buffers keep their
+	// capacity between batches, so a thread allocates only while its batches grow.
+	class BatchScratch
+	{
+		public:
+			BatchScratch()
+			: mGroupOf()
+			, mFlags()
+			, mElements()
+			, mGroups()
+			, mSlots()
+			, mEnds()
+			, mOrder()
+			, mBusy(false)
+			{
+			}
+
+			// Prepares the buffers for a batch with the given number of elements
+			void reset(std::size_t size)
+			{
+				mGroupOf.resize(size);
+				mFlags.resize(size);
+				mElements.resize(size);
+				mGroups.clear();
+
+				if (!mSlots.empty())
+					std::fill(mSlots.begin(), mSlots.end(), 0u);
+			}
+
+			// Returns the group index of function (which may be nullptr), creating a new group if necessary
+			std::size_t group(const void* function)
+			{
+				// Open addressing with linear probing; slots store group index + 1, 0 denotes an empty slot
+				if (2u * (mGroups.size() + 1u) > mSlots.size())
+					rehash();
+
+				const std::size_t mask = mSlots.size() - 1u;
+				for (std::size_t slot = hash(function) & mask; ; slot = (slot + 1u) & mask)
+				{
+					if (mSlots[slot] == 0u)
+					{
+						mGroups.push_back(function);
+						mSlots[slot] = mGroups.size();
+						return mGroups.size() - 1u;
+					}
+
+					if (mGroups[mSlots[slot] - 1u] == function)
+						return mSlots[slot] - 1u;
+				}
+			}
+
+			// Stores the element at index i (its address, its group and a user-defined flag)
+			void assign(std::size_t i, const void* element, std::size_t group, bool flag)
+			{
+				mElements[i] = element;
+				mGroupOf[i] = group;
+				mFlags[i] = flag;
+			}
+
+			// Sorts the element indices by group, keeping the relative order within each group
+			void sort()
+			{
+				mEnds.assign(mGroups.size() + 1u, 0u);
+				for (std::size_t group : mGroupOf)
+					++mEnds[group + 1u];
+
+				for (std::size_t group = 1u; group < mEnds.size(); ++group)
+					mEnds[group] += mEnds[group - 1u];
+
+				mOrder.resize(mGroupOf.size());
+				for (std::size_t i = 0u; i < mGroupOf.size(); ++i)
+					mOrder[mEnds[mGroupOf[i]]++] = i;
+
+				// Now, mEnds[group] is the end of group (and the begin of group + 1)
+			}
+
+			// Calls visitor(function, element, flag) for all elements, group by group. Must be called after sort().
+			template <typename Visitor>
+			void forEach(Visitor visitor) const
+			{
+				std::size_t begin = 0u;
+				for (std::size_t group = 0u; group < mGroups.size(); ++group)
+				{
+					for (; begin < mEnds[group]; ++begin)
+					{
+						const std::size_t i = mOrder[begin];
+						visitor(mGroups[group], mElements[i], mFlags[i] != 0u);
+					}
+				}
+			}
+
+		private:
+			static std::size_t hash(const void* pointer)
+			{
+				std::uint64_t value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(pointer)) * goldenRatio64;
+				return static_cast<std::size_t>(value >> 32u);
+			}
+
+			void rehash()
+			{
+				mSlots.assign(mSlots.empty() ? 16u : 2u * mSlots.size(), 0u);
+
+				const std::size_t mask = mSlots.size() - 1u;
+				for (std::size_t group = 0u; group < mGroups.size(); ++group)
+				{
+					std::size_t slot = hash(mGroups[group]) & mask;
+					while (mSlots[slot] != 0u)
+						slot = (slot + 1u) & mask;
+
+					mSlots[slot] = group + 1u;
+				}
+			}
+
+		private:
+			std::vector<std::size_t>		mGroupOf;
+			std::vector<unsigned char>		mFlags;
+			std::vector<const void*>		mElements;
+			std::vector<const void*>		mGroups;
+			std::vector<std::size_t>		mSlots;
+			std::vector<std::size_t>		mEnds;
+			std::vector<std::size_t>		mOrder;
+			bool							mBusy;
+
+		friend class BatchScratchLease;
+	};
+
+	// Provides the calling thread's scratch buffers for the duration of a batch. If they are already in use by an
+	// enclosing batch (a dispatched function started another one), separate buffers are used.
+	class BatchScratchLease : private NonCopyable
+	{
+		public:
+			BatchScratchLease()
+			: mShared(threadScratch())
+			, mOwn()
+			, mScratch(mShared.mBusy ? &mOwn : &mShared)
+			{
+				mScratch->mBusy = true;
+			}
+
+			~BatchScratchLease()
+			{
+				mScratch->mBusy = false;
+			}
+
+			BatchScratch* operator-> () const
+			{
+				return mScratch;
+			}
+
+		private:
+			static BatchScratch& threadScratch()
+			{
+				static thread_local BatchScratch scratch;
+				return scratch;
+			}
+
+		private:
+			BatchScratch&					mShared;
+			BatchScratch					mOwn;
+			BatchScratch*					mScratch;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_BATCHSCRATCH_HPP
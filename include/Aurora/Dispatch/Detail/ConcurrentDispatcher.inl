@@ -0,0 +1,158 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace aurora
+{
+
+template <class Dispatcher>
+template <typename... Args>
+ConcurrentDispatcher<Dispatcher>::ConcurrentDispatcher(Args&&... args)
+: mCurrent(new Dispatcher(std::forward<Args>(args)...))
+, mRetired()
+, mModifyMutex()
+{
+}
+
+template <class Dispatcher>
+ConcurrentDispatcher<Dispatcher>::~ConcurrentDispatcher()
+{
+	delete mCurrent.load();
+}
+
+template <class Dispatcher>
+template <typename... Args>
+void ConcurrentDispatcher<Dispatcher>::bind(Args&&... args)
+{
+	modify([&] (Dispatcher& dispatcher)
+	{
+		dispatcher.bind(std::forward<Args>(args)...);
+	});
+}
+
+template <class Dispatcher>
+template <typename Fn>
+void ConcurrentDispatcher<Dispatcher>::fallback(Fn function)
+{
+	modify([&function] (Dispatcher& dispatcher)
+	{
+		dispatcher.fallback(std::move(function));
+	});
+}
+
+template <class Dispatcher>
+void ConcurrentDispatcher<Dispatcher>::seal()
+{
+	modify([] (Dispatcher& dispatcher)
+	{
+		dispatcher.seal();
+	});
+}
+
+template <class Dispatcher>
+void ConcurrentDispatcher<Dispatcher>::optimize()
+{
+	modify([] (Dispatcher& dispatcher)
+	{
+		dispatcher.optimize();
+	});
+}
+
+template <class Dispatcher>
+template <typename... Args>
+typename ConcurrentDispatcher<Dispatcher>::Result ConcurrentDispatcher<Dispatcher>::call(Args&&... args) const
+{
+	// The snapshot is not deleted before the guard is destroyed
+	detail::EpochGuard guard;
+	return mCurrent.load()->call(std::forward<Args>(args)...);
+}
+
+template <class Dispatcher>
+template <typename... Args>
+typename ConcurrentDispatcher<Dispatcher>::TryResult ConcurrentDispatcher<Dispatcher>::tryCall(Args&&... args) const
+{
+	detail::EpochGuard guard;
+	return mCurrent.load()->tryCall(std::forward<Args>(args)...);
+}
+
+template <class Dispatcher>
+template <typename... Ids>
+bool ConcurrentDispatcher<Dispatcher>::contains(const Ids&... identifiers) const
+{
+	detail::EpochGuard guard;
+	return mCurrent.load()->contains(identifiers...);
+}
+
+template <class Dispatcher>
+template <typename Arg, class D>
+auto ConcurrentDispatcher<Dispatcher>::resolve(Arg&& arg) const -> decltype(std::declval<const D&>().resolve(std::forward<Arg>(arg)))
+{
+	detail::EpochGuard guard;
+	return mCurrent.load()->resolve(std::forward<Arg>(arg));
+}
+
+template <class Dispatcher>
+DispatchReport ConcurrentDispatcher<Dispatcher>::statistics() const
+{
+	detail::EpochGuard guard;
+	return mCurrent.load()->statistics();
+}
+
+template <class Dispatcher>
+template <typename Fn>
+void ConcurrentDispatcher<Dispatcher>::modify(Fn modification)
+{
+	std::lock_guard<std::mutex> lock(mModifyMutex);
+
+	Dispatcher* current = mCurrent.load();
+	std::unique_ptr<Dispatcher> next(current->clone());
+	modification(*next);
+
+	mCurrent.store(next.release());
+	mRetired.push_back(RetiredDispatcher(detail::advanceEpoch(), std::unique_ptr<Dispatcher>(current)));
+
+	reclaim();
+}
+
+template <class Dispatcher>
+void ConcurrentDispatcher<Dispatcher>::collect()
+{
+	std::lock_guard<std::mutex> lock(mModifyMutex);
+	reclaim();
+}
+
+template <class Dispatcher>
+void ConcurrentDispatcher<Dispatcher>::reclaim()
+{
+	const std::size_t oldest = detail::oldestEpoch();
+
+	auto itr = std::remove_if(mRetired.begin(), mRetired.end(), [oldest] (const RetiredDispatcher& retired)
+	{
+		return retired.first <= oldest;
+	});
+
+	mRetired.erase(itr, mRetired.end());
+}
+
+} // namespace aurora
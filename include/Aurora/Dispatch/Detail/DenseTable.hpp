@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Table for dispatchers with small integral keys: values are stored in an array indexed by the key
+
+#ifndef AURORA_DENSETABLE_HPP
+#define AURORA_DENSETABLE_HPP
+
+#include <Aurora/Tools/Optional.hpp>
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Maps integral keys (or enumerators) to values. Memory consumption is proportional to the largest key.
+	template <typename Key, typename Value, typename Hash>
+	class DenseTable
+	{
+		static_assert(std::is_integral<Key>::value || std::is_enum<Key>::value,
+			"DenseStorage requires integral or enum keys.");
+
+		public:
+			DenseTable()
+			: mValues()
+			, mSize(0u)
+			{
+			}
+
+			Value* find(const Key& key)
+			{
+				return const_cast<Value*>(static_cast<const DenseTable&>(*this).find(key));
+			}
+
+			const Value* find(const Key& key) const
+			{
+				const std::size_t index = static_cast<std::size_t>(key);
+
+				if (index < mValues.size() && mValues[index])
+					return &*mValues[index];
+				else
+					return nullptr;
+			}
+
+			void insert(const Key& key, Value value)
+			{
+				const std::size_t index = static_cast<std::size_t>(key);
+
+				if (index >= mValues.size())
+					mValues.resize(index + 1u);
+
+				if (!mValues[index])
+					++mSize;
+
+				mValues[index] = std::move(value);
+			}
+
+			std::size_t size() const
+			{
+				return mSize;
+			}
+
+			void seal()
+			{
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			std::vector<Optional<Value>>	mValues;
+			std::size_t						mSize;
+	};
+
+
+	// Specialization for key pairs (double dispatch): square matrix of cells indexed by both keys. Cells contain 32-bit
+	// indices into a separate value array, so that the matrix stays compact (16 KB for 64 keys) and fits into the cache.
+	template <typename Key1, typename Key2, typename Value, typename Hash>
+	class DenseTable<std::pair<Key1, Key2>, Value, Hash>
+	{
+		static_assert((std::is_integral<Key1>::value || std::is_enum<Key1>::value)
+			&& (std::is_integral<Key2>::value || std::is_enum<Key2>::value),
+			"DenseStorage requires integral or enum keys.");
+
+		public:
+			DenseTable()
+			: mCells()
+			, mValues()
+			, mDimension(0u)
+			{
+			}
+
+			Value* find(const std::pair<Key1, Key2>& key)
+			{
+				return const_cast<Value*>(static_cast<const DenseTable&>(*this).find(key));
+			}
+
+			const Value* find(const std::pair<Key1, Key2>& key) const
+			{
+				const std::size_t row = static_cast<std::size_t>(key.first);
+				const std::size_t column = static_cast<std::size_t>(key.second);
+
+				// Cell value 0 denotes an empty cell, otherwise index + 1 into mValues
+				if (row < mDimension && column < mDimension)
+				{
+					if (std::uint32_t cell = mCells[row * mDimension + column])
+						return &mValues[cell - 1u];
+				}
+
+				return nullptr;
+			}
+
+			void insert(const std::pair<Key1, Key2>& key, Value value)
+			{
+				const std::size_t row = static_cast<std::size_t>(key.first);
+				const std::size_t column = static_cast<std::size_t>(key.second);
+
+				const std::size_t required = std::max(row, column) + 1u;
+				if (required > mDimension)
+					resize(required);
+
+				std::uint32_t& cell = mCells[row * mDimension + column];
+				if (cell)
+				{
+					mValues[cell - 1u] = std::move(value);
+				}
+				else
+				{
+					mValues.push_back(std::move(value));
+					cell = static_cast<std::uint32_t>(mValues.size());
+				}
+			}
+
+			std::size_t size() const
+			{
+				return mValues.size();
+			}
+
+			void seal()
+			{
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			void resize(std::size_t dimension)
+			{
+				std::vector<std::uint32_t> cells(dimension * dimension, 0u);
+
+				for (std::size_t row = 0u; row < mDimension; ++row)
+				{
+					for (std::size_t column = 0u; column < mDimension; ++column)
+						cells[row * dimension + column] = mCells[row * mDimension + column];
+				}
+
+				mCells.swap(cells);
+				mDimension = dimension;
+			}
+
+		private:
+			std::vector<std::uint32_t>		mCells;
+			std::vector<Value>				mValues;
+			std::size_t						mDimension;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_DENSETABLE_HPP
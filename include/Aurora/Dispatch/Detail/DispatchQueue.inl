@@ -0,0 +1,228 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace aurora
+{
+
+template <class Dispatcher, std::size_t N>
+DispatchQueue<Dispatcher, N>::DispatchQueue(const Dispatcher& dispatcher)
+: mDispatcher(&dispatcher)
+, mBuffers()
+, mRecords()
+, mScratch()
+{
+}
+
+template <class Dispatcher, std::size_t N>
+DispatchQueue<Dispatcher, N>::~DispatchQueue()
+{
+	mBuffers.forEach([] (Buffer& buffer)
+	{
+		buffer.active.clear();
+		buffer.drained.clear();
+	});
+}
+
+template <class Dispatcher, std::size_t N>
+template <typename... Objects>
+void DispatchQueue<Dispatcher, N>::post(Objects&&... objects)
+{
+	static_assert(sizeof...(Objects) == N, "post() expects N objects.");
+
+	Buffer& buffer = mBuffers.local();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+
+	// Keys are computed from the stored copies, so they are the ones the dispatcher sees in drain()
+	Record record = { {}, { store(buffer.active, std::forward<Objects>(objects))... } };
+
+	for (std::size_t i = 0; i < N; ++i)
+		record.keys[i] = sortKey(record.objects[i]);
+
+	buffer.active.records.push_back(record);
+}
+
+template <class Dispatcher, std::size_t N>
+template <typename... Args>
+std::size_t DispatchQueue<Dispatcher, N>::drain(Args&&... args)
+{
+	return drainImpl([this, &args...] (const Record& record)
+	{
+		invoke(record, Indices(), args...);
+	});
+}
+
+template <class Dispatcher, std::size_t N>
+template <typename T>
+typename DispatchQueue<Dispatcher, N>::Object* DispatchQueue<Dispatcher, N>::store(Batch& batch, T&& object)
+{
+	typedef typename std::decay<T>::type Type;
+
+	// A polymorphic object passed as a base class would be sliced
+	assert(!std::is_polymorphic<Type>::value || typeid(object) == typeid(Type));
+
+	void* memory = batch.arena.allocate(sizeof(Type), std::alignment_of<Type>::value);
+	Type* stored = new (memory) Type(std::forward<T>(object));
+
+	if (!std::is_trivially_destructible<Type>::value)
+	{
+		Destructor destructor = { stored, &DispatchQueue::destroy<Type> };
+		batch.destructors.push_back(destructor);
+	}
+
+	return stored;
+}
+
+template <class Dispatcher, std::size_t N>
+template <typename T>
+void DispatchQueue<Dispatcher, N>::destroy(void* object)
+{
+	static_cast<T*>(object)->~T();
+}
+
+template <class Dispatcher, std::size_t N>
+std::uint64_t DispatchQueue<Dispatcher, N>::sortKey(Object* object)
+{
+	typedef typename Traits::Key Key;
+
+	return sortKey(Traits::keyFromBase(detail::toParameter<Parameter>(object)),
+		std::integral_constant<bool, std::is_integral<Key>::value || std::is_enum<Key>::value>());
+}
+
+template <class Dispatcher, std::size_t N>
+template <typename Key>
+std::uint64_t DispatchQueue<Dispatcher, N>::sortKey(const Key& key, std::true_type)
+{
+	// Distinct keys never share a value, and small keys such as dense IDs only need few radix sort passes
+	return static_cast<std::uint64_t>(key);
+}
+
+template <class Dispatcher, std::size_t N>
+template <typename Key>
+std::uint64_t DispatchQueue<Dispatcher, N>::sortKey(const Key& key, std::false_type)
+{
+	// 32 bits save half of the radix sort passes
+	const std::uint64_t hash = Hasher()(key);
+	return (hash ^ (hash >> 32)) & 0xffffffffu;
+}
+
+template <class Dispatcher, std::size_t N>
+template <typename Invoker>
+std::size_t DispatchQueue<Dispatcher, N>::drainImpl(Invoker invoker)
+{
+	// Take the posted objects of all threads; producers continue with the empty batches
+	mRecords.clear();
+	mBuffers.forEach([this] (Buffer& buffer)
+	{
+		{
+			std::lock_guard<std::mutex> lock(buffer.mutex);
+			std::swap(buffer.active, buffer.drained);
+		}
+
+		mRecords.insert(mRecords.end(), buffer.drained.records.begin(), buffer.drained.records.end());
+	});
+
+	auto clearDrained = [this] ()
+	{
+		mBuffers.forEach([] (Buffer& buffer)
+		{
+			buffer.drained.clear();
+		});
+	};
+
+	sortRecords();
+
+	try
+	{
+		for (const Record& record : mRecords)
+			invoker(record);
+	}
+	catch (...)
+	{
+		clearDrained();
+		throw;
+	}
+
+	clearDrained();
+	return mRecords.size();
+}
+
+template <class Dispatcher, std::size_t N>
+void DispatchQueue<Dispatcher, N>::sortRecords()
+{
+	mScratch.resize(mRecords.size());
+
+	// Least significant key first, i.e. the last object's
+	for (std::size_t i = N; i-- > 0u; )
+	{
+		std::uint64_t usedBits = 0u;
+		for (const Record& record : mRecords)
+			usedBits |= record.keys[i];
+
+		for (unsigned int shift = 0u; shift < 64u; shift += 8u)
+		{
+			// All keys have the same digit (zero), the pass would not change the order
+			if (((usedBits >> shift) & 0xffu) == 0u)
+				continue;
+
+			std::size_t offsets[256] = {};
+			for (const Record& record : mRecords)
+				++offsets[(record.keys[i] >> shift) & 0xffu];
+
+			std::size_t sum = 0u;
+			for (std::size_t& offset : offsets)
+			{
+				std::size_t count = offset;
+				offset = sum;
+				sum += count;
+			}
+
+			for (const Record& record : mRecords)
+				mScratch[offsets[(record.keys[i] >> shift) & 0xffu]++] = record;
+
+			mRecords.swap(mScratch);
+		}
+	}
+}
+
+template <class Dispatcher, std::size_t N>
+template <std::size_t... Is, typename... Extra>
+void DispatchQueue<Dispatcher, N>::invoke(const Record& record, detail::IndexSequence<Is...>, Extra&&... extra) const
+{
+	mDispatcher->call(detail::toParameter<Parameter>(record.objects[Is])..., std::forward<Extra>(extra)...);
+}
+
+template <class Dispatcher, std::size_t N>
+void DispatchQueue<Dispatcher, N>::Batch::clear()
+{
+	// Destroy in reverse order of construction
+	for (auto itr = destructors.rbegin(); itr != destructors.rend(); ++itr)
+		itr->destroy(itr->object);
+
+	destructors.clear();
+	records.clear();
+	arena.reset();
+}
+
+} // namespace aurora
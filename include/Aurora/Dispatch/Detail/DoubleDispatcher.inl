@@ -26,131 +26,319 @@
 namespace aurora
 {
 
-template <typename Signature, typename Traits>
-DoubleDispatcher<Signature, Traits>::DoubleDispatcher(bool symmetric)
-: mMap()
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>::DoubleDispatcher(bool symmetric)
+: mTable()
 , mFallback()
 , mSymmetric(symmetric)
+, mSealed(false)
+, mStatistics()
 {
 }
 
-template <typename Signature, typename Traits>
-DoubleDispatcher<Signature, Traits>::DoubleDispatcher(DoubleDispatcher&& source)
-: mMap(std::move(source.mMap))
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Allocator>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>::DoubleDispatcher(bool symmetric, const Allocator& allocator)
+: mTable(allocator)
+, mFallback()
+, mSymmetric(symmetric)
+, mSealed(false)
+, mStatistics()
+{
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>::DoubleDispatcher(DoubleDispatcher&& source)
+: mTable(std::move(source.mTable))
 , mFallback(std::move(source.mFallback))
 , mSymmetric(std::move(source.mSymmetric))
+, mSealed(source.mSealed)
+, mStatistics(source.mStatistics)
 {
 }
 
-template <typename Signature, typename Traits>
-DoubleDispatcher<Signature, Traits>& DoubleDispatcher<Signature, Traits>::operator= (DoubleDispatcher&& source)
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>::DoubleDispatcher(const DoubleDispatcher& origin, detail::CloneTag)
+: mTable(origin.mTable)
+, mFallback(origin.mFallback)
+, mSymmetric(origin.mSymmetric)
+, mSealed(origin.mSealed)
+, mStatistics(origin.mStatistics)
 {
-	mMap = std::move(source.mMap);
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>& DoubleDispatcher<Signature, Traits, Storage, Statistics>::operator= (DoubleDispatcher&& source)
+{
+	mTable = std::move(source.mTable);
 	mFallback = std::move(source.mFallback);
 	mSymmetric = std::move(source.mSymmetric);
+	mSealed = source.mSealed;
+	mStatistics = source.mStatistics;
 
 	return *this;
 }
 
-template <typename Signature, typename Traits>
-DoubleDispatcher<Signature, Traits>::~DoubleDispatcher()
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>::~DoubleDispatcher()
 {
 }
 
-template <typename Signature, typename Traits>
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>* DoubleDispatcher<Signature, Traits, Storage, Statistics>::clone() const
+{
+	return new DoubleDispatcher(*this, detail::CloneTag());
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
 template <typename Id1, typename Id2, typename Fn>
-void DoubleDispatcher<Signature, Traits>::bind(const Id1& identifier1, const Id2& identifier2, Fn function)
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::bind(const Id1& identifier1, const Id2& identifier2, Fn function)
 {
+	if (mSealed)
+		throw FunctionCallException("DoubleDispatcher::bind() - dispatcher has been sealed");
+
 	SingleKey key1 = Traits::keyFromId(identifier1);
 	SingleKey key2 = Traits::keyFromId(identifier2);
 
-	mMap[makeKey(key1, key2)] = Traits::template trampoline2<Id1, Id2>(function);
+	bool swapped;
+	Key key = makeKey(key1, key2, swapped);
+
+	mTable.insert(key, Entry(Traits::template trampoline2<Id1, Id2>(function), swapped));
 }
 
-template <typename Signature, typename Traits>
-typename DoubleDispatcher<Signature, Traits>::Result DoubleDispatcher<Signature, Traits>::call(Parameter arg1, Parameter arg2) const
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename... Args>
+typename DoubleDispatcher<Signature, Traits, Storage, Statistics>::Result DoubleDispatcher<Signature, Traits, Storage, Statistics>::call(
+	Parameter arg1, Parameter arg2, Args&&... args) const
 {
+	static_assert(sizeof...(Args) + 2u == FunctionArity<Signature>::value, "call() expects the arguments specified by Signature.");
+
 	SingleKey key1 = Traits::keyFromBase(arg1);
 	SingleKey key2 = Traits::keyFromBase(arg2);
 
 	// If no corresponding class (or base class) has been found: Invoke fallback if available, otherwise throw exception
-	Key key = makeKey(key1, key2);
-	auto itr = mMap.find(key);
-	if (itr == mMap.end())
+	bool swapped;
+	Key key = makeKey(key1, key2, swapped);
+
+	const Entry* entry = mTable.find(key);
+	if (!entry)
 	{
+		mStatistics.miss(key);
+
 		if (mFallback)
-			return mFallback(arg1, arg2);
+			return mFallback(arg1, arg2, std::forward<Args>(args)...);
 		else
 			throw FunctionCallException(std::string("DoubleDispatcher::call() - function with parameters \"") + Traits::name(key1)
 				+ "\" and \"" + Traits::name(key2) + "\" not registered");
 	}
 
 	// Call function (swap-flag equal for stored entry and passed arguments means the order was the same; otherwise swap arguments)
-	if (itr->first.swapped == key.swapped)
-		return itr->second(arg1, arg2);
+	auto measurement = mStatistics.measure(key);
+	if (entry->swapped == swapped)
+		return entry->function(arg1, arg2, std::forward<Args>(args)...);
 	else
-		return itr->second(arg2, arg1);
+		return entry->function(arg2, arg1, std::forward<Args>(args)...);
 }
 
-template <typename Signature, typename Traits>
-typename DoubleDispatcher<Signature, Traits>::Result DoubleDispatcher<Signature, Traits>::call(Parameter arg1, Parameter arg2, UserData data) const
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename... Args>
+typename DoubleDispatcher<Signature, Traits, Storage, Statistics>::TryResult DoubleDispatcher<Signature, Traits, Storage, Statistics>::tryCall(
+	Parameter arg1, Parameter arg2, Args&&... args) const
 {
-	SingleKey key1 = Traits::keyFromBase(arg1);
-	SingleKey key2 = Traits::keyFromBase(arg2);
+	static_assert(sizeof...(Args) + 2u == FunctionArity<Signature>::value, "tryCall() expects the arguments specified by Signature.");
 
-	// If no corresponding class (or base class) has been found: Invoke fallback if available, otherwise throw exception
-	Key key = makeKey(key1, key2);
-	auto itr = mMap.find(key);
-	if (itr == mMap.end())
+	bool swapped;
+	Key key = makeKey(Traits::keyFromBase(arg1), Traits::keyFromBase(arg2), swapped);
+
+	const Entry* entry = mTable.find(key);
+	if (!entry)
 	{
-		if (mFallback)
-			return mFallback(arg1, arg2, data);
-		else
-			throw FunctionCallException(std::string("DoubleDispatcher::call() - function with parameters \"") + Traits::name(key1)
-			+ "\" and \"" + Traits::name(key2) + "\" not registered");
+		mStatistics.miss(key);
+		return detail::TryCall<Result>::miss();
 	}
 
-	// Call function (swap-flag equal for stored entry and passed arguments means the order was the same; otherwise swap arguments)
-	if (itr->first.swapped == key.swapped)
-		return itr->second(arg1, arg2, data);
+	auto measurement = mStatistics.measure(key);
+	if (entry->swapped == swapped)
+		return detail::TryCall<Result>::invoke(entry->function, arg1, arg2, std::forward<Args>(args)...);
 	else
-		return itr->second(arg2, arg1, data);
+		return detail::TryCall<Result>::invoke(entry->function, arg2, arg1, std::forward<Args>(args)...);
 }
 
-template <typename Signature, typename Traits>
-void DoubleDispatcher<Signature, Traits>::fallback(std::function<Signature> function)
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Id1, typename Id2>
+bool DoubleDispatcher<Signature, Traits, Storage, Statistics>::contains(const Id1& identifier1, const Id2& identifier2) const
+{
+	bool swapped;
+	return mTable.find(makeKey(Traits::keyFromId(identifier1), Traits::keyFromId(identifier2), swapped)) != nullptr;
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Itr, typename... Args>
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::callPairs(Itr first, Itr last, Args&&... args) const
+{
+	static_assert(sizeof...(Args) + 2u == FunctionArity<Signature>::value, "callPairs() expects the arguments specified by Signature.");
+
+	dispatchPairs(first, last, [this, &args...] (const BaseFunction* function, Parameter arg1, Parameter arg2)
+	{
+		if (function)
+			(*function)(arg1, arg2, args...);
+		else
+			mFallback(arg1, arg2, args...);
+	});
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DispatchReport DoubleDispatcher<Signature, Traits, Storage, Statistics>::statistics() const
+{
+	return mStatistics.report([] (const Key& key) -> std::string
+	{
+		return std::string(Traits::name(key.first)) + ", " + Traits::name(key.second);
+	});
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::seal()
+{
+	mTable.seal();
+	mSealed = true;
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::optimize()
+{
+	mTable.optimize();
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::fallback(std::function<Signature> function)
 {
 	mFallback = std::move(function);
 }
 
-template <typename Signature, typename Traits>
-typename DoubleDispatcher<Signature, Traits>::Key DoubleDispatcher<Signature, Traits>::makeKey(SingleKey key1, SingleKey key2) const
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+typename DoubleDispatcher<Signature, Traits, Storage, Statistics>::Key DoubleDispatcher<Signature, Traits, Storage, Statistics>::makeKey(
+	SingleKey key1, SingleKey key2, bool& swapped) const
 {
-	// When symmetric, (key1,key2) and (key2,key1) are the same -> sort so that we always have (key1,key2)
-	if (mSymmetric && hashValue(key2) < hashValue(key1))
-		return Key(key2, key1, true);
+	// When symmetric, (key1,key2) and (key2,key1) are the same -> sort so that we always have (key1,key2).
+	// Dense and enum keys are compared directly, so a symmetric pair always uses the cell (min,max) of the matrix.
+	typedef std::integral_constant<bool, std::is_integral<SingleKey>::value || std::is_enum<SingleKey>::value> ByValue;
+	swapped = mSymmetric && keyLess(key2, key1, ByValue());
+
+	if (swapped)
+		return Key(key2, key1);
 	else
-		return Key(key1, key2, false);
+		return Key(key1, key2);
 }
 
-template <typename Signature, typename Traits>
-DoubleDispatcher<Signature, Traits>::Key::Key(const SingleKey& key1, const SingleKey& key2, bool swapped)
-: keyPair(key1, key2)
-, swapped(swapped)
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+bool DoubleDispatcher<Signature, Traits, Storage, Statistics>::keyLess(const SingleKey& lhs, const SingleKey& rhs,
+	std::true_type /*byValue*/)
 {
+	return lhs < rhs;
 }
 
-template <typename Signature, typename Traits>
-bool DoubleDispatcher<Signature, Traits>::Key::operator== (const Key& rhs) const
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+bool DoubleDispatcher<Signature, Traits, Storage, Statistics>::keyLess(const SingleKey& lhs, const SingleKey& rhs,
+	std::false_type /*byValue*/)
 {
-	// Member 'swapped' not relevant for key lookup
-	return keyPair == rhs.keyPair;
+	return hashValue(lhs) < hashValue(rhs);
 }
 
-template <typename Signature, typename Traits>
-std::size_t DoubleDispatcher<Signature, Traits>::Hasher::operator() (const Key& k) const
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Itr, typename Invoker>
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::dispatchPairs(Itr first, Itr last, Invoker invoker) const
+{
+	typedef typename std::remove_reference<typename std::iterator_traits<Itr>::reference>::type Element;
+
+	if (first == last)
+		return;
+
+	detail::BatchScratchLease scratch;
+	scratch->reset(static_cast<std::size_t>(std::distance(first, last)));
+
+	// Assign a group to each distinct entry, and flag the pairs whose arguments must be swapped.
+	// Runs of equal keys need only one lookup. Keys need not be default-constructible, so the last ones start as the first.
+	bool haveLast = false;
+	SingleKey lastKey1 = Traits::keyFromBase(detail::toParameter<Parameter>((*first).first));
+	SingleKey lastKey2 = Traits::keyFromBase(detail::toParameter<Parameter>((*first).second));
+	std::size_t lastGroup = 0u;
+	bool lastReversed = false;
+
+	std::size_t i = 0u;
+	for (Itr itr = first; itr != last; ++itr, ++i)
+	{
+		Element& element = *itr;
+		SingleKey key1 = Traits::keyFromBase(detail::toParameter<Parameter>(element.first));
+		SingleKey key2 = Traits::keyFromBase(detail::toParameter<Parameter>(element.second));
+
+		if (!haveLast || !(lastKey1 == key1 && lastKey2 == key2))
+		{
+			bool swapped;
+			const Entry* entry = mTable.find(makeKey(key1, key2, swapped));
+
+			// Throw before any function is invoked, leaving no partially processed range
+			if (!entry && !mFallback)
+				throw FunctionCallException(std::string("DoubleDispatcher::callPairs() - function with parameters \"") + Traits::name(key1)
+					+ "\" and \"" + Traits::name(key2) + "\" not registered");
+
+			haveLast = true;
+			lastKey1 = key1;
+			lastKey2 = key2;
+			lastGroup = scratch->group(entry);
+			lastReversed = entry && entry->swapped != swapped;
+		}
+
+		scratch->assign(i, std::addressof(element), lastGroup, lastReversed);
+	}
+
+	scratch->sort();
+	scratch->forEach([this, &invoker] (const void* entry, const void* element, bool reversed)
+	{
+		Element& pair = *static_cast<Element*>(const_cast<void*>(element));
+		invokePaired(static_cast<const Entry*>(entry), detail::toParameter<Parameter>(pair.first), detail::toParameter<Parameter>(pair.second),
+			reversed, invoker, std::integral_constant<bool, !std::is_same<Statistics, NoDispatchStatistics>::value>());
+	});
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Invoker>
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::invokePaired(const Entry* entry, Parameter arg1, Parameter arg2, bool reversed,
+	Invoker& invoker, std::true_type /*record*/) const
+{
+	// The keys are not stored during sorting, so they are computed again
+	bool swapped;
+	Key key = makeKey(Traits::keyFromBase(arg1), Traits::keyFromBase(arg2), swapped);
+
+	if (entry)
+	{
+		auto measurement = mStatistics.measure(key);
+		invokePaired(entry, arg1, arg2, reversed, invoker, std::false_type());
+	}
+	else
+	{
+		mStatistics.miss(key);
+		invokePaired(entry, arg1, arg2, reversed, invoker, std::false_type());
+	}
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Invoker>
+void DoubleDispatcher<Signature, Traits, Storage, Statistics>::invokePaired(const Entry* entry, Parameter arg1, Parameter arg2, bool reversed,
+	Invoker& invoker, std::false_type /*record*/) const
+{
+	const BaseFunction* function = entry ? &entry->function : nullptr;
+
+	if (reversed)
+		invoker(function, arg2, arg1);
+	else
+		invoker(function, arg1, arg2);
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DoubleDispatcher<Signature, Traits, Storage, Statistics>::Entry::Entry(BaseFunction function, bool swapped)
+: function(std::move(function))
+, swapped(swapped)
 {
-	return PairHasher()(k.keyPair);
 }
 
 } // namespace aurora
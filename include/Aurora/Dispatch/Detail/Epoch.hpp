@@ -0,0 +1,168 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Epoch-based reclamation of objects that are shared with concurrent readers
+
+#ifndef AURORA_EPOCH_HPP
+#define AURORA_EPOCH_HPP
+
+#include <Aurora/Config.hpp>
+
+#include <atomic>
+#include <cstddef>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Readers announce the global epoch in a per-thread record while they access a shared object. A writer that has
+	// replaced a shared object tags the old one with a new epoch, and deletes it once every announced epoch is at least
+	// as new -- no reader can have obtained the old object after its replacement was published.
+	struct EpochRecord
+	{
+		EpochRecord()
+		: epoch(0u)
+		, used(true)
+		, nesting(0u)
+		, next(nullptr)
+		{
+		}
+
+		std::atomic<std::size_t>	epoch;		// 0 if the thread is not reading
+		std::atomic<bool>			used;		// false if the thread has terminated
+		std::size_t					nesting;	// only accessed by the owning thread
+		EpochRecord*				next;
+	};
+
+	inline std::atomic<std::size_t>& globalEpoch()
+	{
+		static std::atomic<std::size_t> epoch(1u);
+		return epoch;
+	}
+
+	// Records are never deleted, but reused by new threads; their number is the maximal number of concurrent threads
+	inline std::atomic<EpochRecord*>& epochRecords()
+	{
+		static std::atomic<EpochRecord*> head(nullptr);
+		return head;
+	}
+
+	// Owns the record of the current thread during the thread's lifetime
+	class EpochThread
+	{
+		public:
+			EpochThread()
+			: record(acquire())
+			{
+			}
+
+			~EpochThread()
+			{
+				record->epoch.store(0u);
+				record->used.store(false, std::memory_order_release);
+			}
+
+			EpochRecord* const record;
+
+		private:
+			static EpochRecord* acquire()
+			{
+				std::atomic<EpochRecord*>& head = epochRecords();
+
+				for (EpochRecord* r = head.load(std::memory_order_acquire); r; r = r->next)
+				{
+					bool expected = false;
+					if (!r->used.load(std::memory_order_relaxed) && r->used.compare_exchange_strong(expected, true))
+						return r;
+				}
+
+				EpochRecord* r = new EpochRecord();
+				r->next = head.load(std::memory_order_relaxed);
+				while (!head.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed))
+					;
+
+				return r;
+			}
+	};
+
+	inline EpochRecord& localEpochRecord()
+	{
+		static thread_local EpochThread thread;
+		return *thread.record;
+	}
+
+	// Marks the scope in which the current thread accesses shared objects; may be nested
+	class EpochGuard
+	{
+		public:
+			EpochGuard()
+			: mRecord(localEpochRecord())
+			{
+				if (mRecord.nesting++ == 0u)
+					mRecord.epoch.store(globalEpoch().load());
+			}
+
+			~EpochGuard()
+			{
+				if (--mRecord.nesting == 0u)
+					mRecord.epoch.store(0u, std::memory_order_release);
+			}
+
+		private:
+			EpochGuard(const EpochGuard&);
+			EpochGuard& operator= (const EpochGuard&);
+
+		private:
+			EpochRecord&	mRecord;
+	};
+
+	// Starts a new epoch, to be called after a replacement has been published. Returns the epoch, with which the
+	// replaced object is tagged.
+	inline std::size_t advanceEpoch()
+	{
+		return globalEpoch().fetch_add(1u) + 1u;
+	}
+
+	// Returns the oldest epoch announced by a reader. Objects tagged with this or an older epoch can be deleted.
+	inline std::size_t oldestEpoch()
+	{
+		std::size_t oldest = globalEpoch().load();
+
+		for (EpochRecord* r = epochRecords().load(std::memory_order_acquire); r; r = r->next)
+		{
+			const std::size_t epoch = r->epoch.load();
+			if (epoch != 0u && epoch < oldest)
+				oldest = epoch;
+		}
+
+		return oldest;
+	}
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_EPOCH_HPP
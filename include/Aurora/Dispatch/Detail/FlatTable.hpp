@@ -0,0 +1,230 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Open-addressing table for dispatchers: keys and values are stored inline in one contiguous array
+
+#ifndef AURORA_FLATTABLE_HPP
+#define AURORA_FLATTABLE_HPP
+
+#include <Aurora/Tools/Optional.hpp>
+#include <Aurora/Tools/Hash.hpp>
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <climits>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Hash table with linear probing. Every slot holds the cached hash value, the key and the value, so a successful
+	// lookup touches only the slots between the home position and the match, which are adjacent in memory.
+	// There is no erase operation, entries are only inserted or overwritten (this is all dispatchers need).
+	// The slot array is allocated through Allocator (rebound to the slot type); copies keep the allocator of the origin.
+	template <typename Key, typename Value, typename Hash, typename Allocator = std::allocator<char>>
+	class FlatTable
+	{
+		public:
+			FlatTable()
+			: mSlots()
+			, mSize(0u)
+			, mShift(0u)
+			{
+			}
+
+			explicit FlatTable(const Allocator& allocator)
+			: mSlots(SlotAllocator(allocator))
+			, mSize(0u)
+			, mShift(0u)
+			{
+			}
+
+			FlatTable(const FlatTable& origin)
+			: mSlots(origin.mSlots, origin.mSlots.get_allocator())
+			, mSize(origin.mSize)
+			, mShift(origin.mShift)
+			{
+			}
+
+			// The source is left as an empty table
+			FlatTable(FlatTable&& source)
+			: mSlots(std::move(source.mSlots))
+			, mSize(source.mSize)
+			, mShift(source.mShift)
+			{
+				source.clear();
+			}
+
+			FlatTable& operator= (const FlatTable& origin)
+			{
+				mSlots = origin.mSlots;
+				mSize = origin.mSize;
+				mShift = origin.mShift;
+				return *this;
+			}
+
+			FlatTable& operator= (FlatTable&& source)
+			{
+				if (this != &source)
+				{
+					mSlots = std::move(source.mSlots);
+					mSize = source.mSize;
+					mShift = source.mShift;
+					source.clear();
+				}
+
+				return *this;
+			}
+
+			Value* find(const Key& key)
+			{
+				return const_cast<Value*>(static_cast<const FlatTable&>(*this).find(key));
+			}
+
+			const Value* find(const Key& key) const
+			{
+				if (mSlots.empty())
+					return nullptr;
+
+				const std::size_t hash = Hash()(key);
+				const std::size_t mask = mSlots.size() - 1u;
+
+				// Load factor is at most 1/2, so there is always an empty slot that terminates the loop
+				for (std::size_t i = homeIndex(hash); ; i = (i + 1u) & mask)
+				{
+					const Slot& slot = mSlots[i];
+
+					if (!slot.entry)
+						return nullptr;
+
+					if (slot.hash == hash && slot.entry->first == key)
+						return &slot.entry->second;
+				}
+			}
+
+			void insert(const Key& key, Value value)
+			{
+				if (Value* existing = find(key))
+				{
+					*existing = std::move(value);
+					return;
+				}
+
+				if (2u * (mSize + 1u) > mSlots.size())
+					grow();
+
+				place(Hash()(key), Entry(key, std::move(value)));
+				++mSize;
+			}
+
+			std::size_t size() const
+			{
+				return mSize;
+			}
+
+			void seal()
+			{
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			typedef std::pair<Key, Value> Entry;
+
+			struct Slot
+			{
+				Slot()
+				: hash(0u)
+				, entry()
+				{
+				}
+
+				std::size_t			hash;
+				Optional<Entry>		entry;
+			};
+
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>	SlotAllocator;
+			typedef std::vector<Slot, SlotAllocator>										SlotVector;
+
+		private:
+			// Fibonacci hashing: spreads the bits of weak hash functions (e.g. identity for integers, aligned pointers)
+			std::size_t homeIndex(std::size_t hash) const
+			{
+				return (hash * static_cast<std::size_t>(goldenRatio64)) >> mShift;
+			}
+
+			void place(std::size_t hash, Entry entry)
+			{
+				const std::size_t mask = mSlots.size() - 1u;
+
+				std::size_t i = homeIndex(hash);
+				while (mSlots[i].entry)
+					i = (i + 1u) & mask;
+
+				mSlots[i].hash = hash;
+				mSlots[i].entry = std::move(entry);
+			}
+
+			void grow()
+			{
+				SlotVector old(mSlots.empty() ? 8u : 2u * mSlots.size(), Slot(), mSlots.get_allocator());
+				old.swap(mSlots);
+
+				// Number of bits to shift, such that homeIndex() yields log2(capacity) bits
+				std::size_t bits = 0u;
+				while ((std::size_t(1u) << bits) < mSlots.size())
+					++bits;
+				mShift = sizeof(std::size_t) * CHAR_BIT - bits;
+
+				for (Slot& slot : old)
+				{
+					if (slot.entry)
+						place(slot.hash, std::move(*slot.entry));
+				}
+			}
+
+			// Resets to the state of a default-constructed table, keeping the allocator
+			void clear()
+			{
+				mSlots.clear();
+				mSize = 0u;
+				mShift = 0u;
+			}
+
+		private:
+			SlotVector			mSlots;
+			std::size_t			mSize;
+			std::size_t			mShift;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_FLATTABLE_HPP
@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Default table for dispatchers, based on std::unordered_map
+
+#ifndef AURORA_HASHTABLE_HPP
+#define AURORA_HASHTABLE_HPP
+
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <utility>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Maps keys to values using a node-based hash map. Nodes and buckets are allocated through Allocator (rebound to the
+	// map's value type); copies keep the allocator of the origin.
+	template <typename Key, typename Value, typename Hash, typename Allocator = std::allocator<char>>
+	class HashTable
+	{
+		private:
+			typedef std::pair<const Key, Value>														Element;
+			typedef std::unordered_map<Key, Value, Hash, std::equal_to<Key>,
+				typename std::allocator_traits<Allocator>::template rebind_alloc<Element>>			Map;
+
+		public:
+			HashTable()
+			: mMap()
+			{
+			}
+
+			explicit HashTable(const Allocator& allocator)
+			: mMap(0u, Hash(), std::equal_to<Key>(), typename Map::allocator_type(allocator))
+			{
+			}
+
+			HashTable(const HashTable& origin)
+			: mMap(origin.mMap, origin.mMap.get_allocator())
+			{
+			}
+
+			HashTable(HashTable&& source)
+			: mMap(std::move(source.mMap))
+			{
+			}
+
+			HashTable& operator= (const HashTable& origin)
+			{
+				mMap = origin.mMap;
+				return *this;
+			}
+
+			HashTable& operator= (HashTable&& source)
+			{
+				mMap = std::move(source.mMap);
+				return *this;
+			}
+
+			Value* find(const Key& key)
+			{
+				auto itr = mMap.find(key);
+				return itr != mMap.end() ? &itr->second : nullptr;
+			}
+
+			const Value* find(const Key& key) const
+			{
+				auto itr = mMap.find(key);
+				return itr != mMap.end() ? &itr->second : nullptr;
+			}
+
+			void insert(const Key& key, Value value)
+			{
+				auto itr = mMap.find(key);
+				if (itr != mMap.end())
+					itr->second = std::move(value);
+				else
+					mMap.insert(std::make_pair(key, std::move(value)));
+			}
+
+			std::size_t size() const
+			{
+				return mMap.size();
+			}
+
+			void seal()
+			{
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			Map		mMap;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_HASHTABLE_HPP
@@ -0,0 +1,294 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace aurora
+{
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+MultiDispatcher<Signature, N, Traits, Storage, Statistics>::MultiDispatcher(bool symmetric)
+: mTable()
+, mFallback()
+, mSymmetric(symmetric)
+, mSealed(false)
+, mStatistics()
+{
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename Allocator>
+MultiDispatcher<Signature, N, Traits, Storage, Statistics>::MultiDispatcher(bool symmetric, const Allocator& allocator)
+: mTable(allocator)
+, mFallback()
+, mSymmetric(symmetric)
+, mSealed(false)
+, mStatistics()
+{
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+MultiDispatcher<Signature, N, Traits, Storage, Statistics>::MultiDispatcher(MultiDispatcher&& source)
+: mTable(std::move(source.mTable))
+, mFallback(std::move(source.mFallback))
+, mSymmetric(source.mSymmetric)
+, mSealed(source.mSealed)
+, mStatistics(source.mStatistics)
+{
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+MultiDispatcher<Signature, N, Traits, Storage, Statistics>& MultiDispatcher<Signature, N, Traits, Storage, Statistics>::operator= (MultiDispatcher&& source)
+{
+	mTable = std::move(source.mTable);
+	mFallback = std::move(source.mFallback);
+	mSymmetric = source.mSymmetric;
+	mSealed = source.mSealed;
+	mStatistics = source.mStatistics;
+
+	return *this;
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+MultiDispatcher<Signature, N, Traits, Storage, Statistics>::~MultiDispatcher()
+{
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename... Args>
+void MultiDispatcher<Signature, N, Traits, Storage, Statistics>::bind(Args&&... args)
+{
+	static_assert(sizeof...(Args) == N + 1, "bind() expects N identifiers, followed by the function.");
+	bindImpl(std::forward_as_tuple(std::forward<Args>(args)...), Indices());
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename... Args>
+typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::Result MultiDispatcher<Signature, N, Traits, Storage, Statistics>::call(Args&&... args) const
+{
+	static_assert(sizeof...(Args) == FunctionArity<Signature>::value, "call() expects the arguments specified by Signature.");
+	return callImpl(std::forward_as_tuple(std::forward<Args>(args)...), Indices(), detail::MakeIndexSequence<sizeof...(Args) - N>());
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename... Args>
+typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::TryResult MultiDispatcher<Signature, N, Traits, Storage, Statistics>::tryCall(
+	Args&&... args) const
+{
+	static_assert(sizeof...(Args) == FunctionArity<Signature>::value, "tryCall() expects the arguments specified by Signature.");
+	return tryCallImpl(std::forward_as_tuple(std::forward<Args>(args)...), Indices(), detail::MakeIndexSequence<sizeof...(Args) - N>());
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename... Ids>
+bool MultiDispatcher<Signature, N, Traits, Storage, Statistics>::contains(const Ids&... identifiers) const
+{
+	static_assert(sizeof...(Ids) == N, "contains() expects N identifiers.");
+
+	Key keys = {{ Traits::keyFromId(identifiers)... }};
+	Permutation order;
+
+	return mTable.find(makeKey(keys, order, Indices())) != nullptr;
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+DispatchReport MultiDispatcher<Signature, N, Traits, Storage, Statistics>::statistics() const
+{
+	return mStatistics.report([] (const Key& key) -> std::string
+	{
+		std::string name;
+		for (std::size_t i = 0u; i < N; ++i)
+		{
+			if (i != 0u)
+				name += ", ";
+
+			name += Traits::name(key[i]);
+		}
+
+		return name;
+	});
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+void MultiDispatcher<Signature, N, Traits, Storage, Statistics>::seal()
+{
+	mTable.seal();
+	mSealed = true;
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+void MultiDispatcher<Signature, N, Traits, Storage, Statistics>::optimize()
+{
+	mTable.optimize();
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+void MultiDispatcher<Signature, N, Traits, Storage, Statistics>::fallback(std::function<Signature> function)
+{
+	mFallback = std::move(function);
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename Tuple, std::size_t... Is>
+void MultiDispatcher<Signature, N, Traits, Storage, Statistics>::bindImpl(Tuple args, detail::IndexSequence<Is...>)
+{
+	if (mSealed)
+		throw FunctionCallException("MultiDispatcher::bind() - dispatcher has been sealed");
+
+	Key keys = {{ Traits::keyFromId(std::get<Is>(args))... }};
+
+	Permutation order;
+	Key key = makeKey(keys, order, Indices());
+
+	mTable.insert(key, Entry(Traits::template trampolineN<typename std::decay<typename std::tuple_element<Is, Tuple>::type>::type...>(
+		std::get<N>(args)), order));
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename Tuple, std::size_t... Is, std::size_t... Js>
+typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::Result MultiDispatcher<Signature, N, Traits, Storage, Statistics>::callImpl(
+	Tuple args, detail::IndexSequence<Is...>, detail::IndexSequence<Js...>) const
+{
+	Objects objects = {{ &detail::deref(std::get<Is>(args))... }};
+	Permutation order;
+	Permutation arguments;
+	Key key = keyOf(objects, order, Indices());
+
+	// If no corresponding classes have been found: Invoke fallback if available, otherwise throw exception.
+	// std::get() on the rvalue tuple keeps rvalue references, so user arguments are forwarded without copies.
+	const Entry* entry = find(key, order, arguments);
+	if (!entry)
+	{
+		mStatistics.miss(key);
+
+		if (mFallback)
+			return mFallback(std::get<Is>(args)..., std::get<N + Js>(std::move(args))...);
+		else
+			throw missingError(objects);
+	}
+
+	auto measurement = mStatistics.measure(key);
+	return invoke(entry->function, objects, arguments, Indices(), std::get<N + Js>(std::move(args))...);
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <typename Tuple, std::size_t... Is, std::size_t... Js>
+typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::TryResult MultiDispatcher<Signature, N, Traits, Storage, Statistics>::tryCallImpl(
+	Tuple args, detail::IndexSequence<Is...>, detail::IndexSequence<Js...>) const
+{
+	Objects objects = {{ &detail::deref(std::get<Is>(args))... }};
+	Permutation order;
+	Permutation arguments;
+	Key key = keyOf(objects, order, Indices());
+
+	const Entry* entry = find(key, order, arguments);
+	if (!entry)
+	{
+		mStatistics.miss(key);
+		return detail::TryCall<Result>::miss();
+	}
+
+	auto measurement = mStatistics.measure(key);
+	return detail::TryCall<Result>::invoke(entry->function, detail::toParameter<Parameter>(objects[arguments[Is]])...,
+		std::get<N + Js>(std::move(args))...);
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <std::size_t... Is>
+typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::Key MultiDispatcher<Signature, N, Traits, Storage, Statistics>::keyOf(
+	const Objects& objects, Permutation& order, detail::IndexSequence<Is...>) const
+{
+	Key keys = {{ Traits::keyFromBase(detail::toParameter<Parameter>(objects[Is]))... }};
+	return makeKey(keys, order, Indices());
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+const typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::Entry* MultiDispatcher<Signature, N, Traits, Storage, Statistics>::find(
+	const Key& key, const Permutation& order, Permutation& arguments) const
+{
+	const Entry* entry = mTable.find(key);
+
+	// The registered function expects the i-th sorted key at parameter entry->order[i]
+	if (entry)
+	{
+		for (std::size_t i = 0u; i < N; ++i)
+			arguments[entry->order[i]] = order[i];
+	}
+
+	return entry;
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <std::size_t... Is, typename... Extra>
+typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::Result MultiDispatcher<Signature, N, Traits, Storage, Statistics>::invoke(
+	const BaseFunction& function, const Objects& objects, const Permutation& arguments, detail::IndexSequence<Is...>, Extra&&... extra)
+{
+	return function(detail::toParameter<Parameter>(objects[arguments[Is]])..., std::forward<Extra>(extra)...);
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+template <std::size_t... Is>
+typename MultiDispatcher<Signature, N, Traits, Storage, Statistics>::Key MultiDispatcher<Signature, N, Traits, Storage, Statistics>::makeKey(
+	const Key& keys, Permutation& order, detail::IndexSequence<Is...>) const
+{
+	for (std::size_t i = 0u; i < N; ++i)
+		order[i] = i;
+
+	// When symmetric, all permutations of the keys are the same -> sort by hash value (stable insertion sort, N is small)
+	if (mSymmetric)
+	{
+		std::size_t hashes[N] = { hashValue(keys[Is])... };
+
+		for (std::size_t i = 1u; i < N; ++i)
+		{
+			for (std::size_t j = i; j > 0u && hashes[order[j]] < hashes[order[j - 1u]]; --j)
+				std::swap(order[j], order[j - 1u]);
+		}
+	}
+
+	Key key = {{ keys[order[Is]]... }};
+	return key;
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+FunctionCallException MultiDispatcher<Signature, N, Traits, Storage, Statistics>::missingError(const Objects& objects)
+{
+	std::string names;
+	for (std::size_t i = 0u; i < N; ++i)
+	{
+		names += (i == 0u) ? "\"" : ", \"";
+		names += Traits::name(Traits::keyFromBase(detail::toParameter<Parameter>(objects[i])));
+		names += "\"";
+	}
+
+	return FunctionCallException("MultiDispatcher::call() - function with parameters " + names + " not registered");
+}
+
+template <typename Signature, std::size_t N, class Traits, class Storage, class Statistics>
+MultiDispatcher<Signature, N, Traits, Storage, Statistics>::Entry::Entry(BaseFunction function, const Permutation& order)
+: function(std::move(function))
+, order(order)
+{
+}
+
+} // namespace aurora
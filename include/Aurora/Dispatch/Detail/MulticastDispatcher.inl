@@ -0,0 +1,356 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace aurora
+{
+
+template <typename Signature, class Traits, class Storage>
+MulticastDispatcher<Signature, Traits, Storage>::Token::Token()
+: mIndex(0u)
+, mGeneration(0u)
+{
+}
+
+template <typename Signature, class Traits, class Storage>
+MulticastDispatcher<Signature, Traits, Storage>::Token::Token(std::uint32_t index, std::uint32_t generation)
+: mIndex(index)
+, mGeneration(generation)
+{
+}
+
+template <typename Signature, class Traits, class Storage>
+MulticastDispatcher<Signature, Traits, Storage>::MulticastDispatcher()
+: mGroups()
+, mKeys()
+, mSlots()
+, mHandles()
+, mFreeHandles()
+, mPendingSlots()
+, mUnboundSlots()
+, mEmptySlots(0u)
+, mCallDepth(0u)
+{
+}
+
+template <typename Signature, class Traits, class Storage>
+MulticastDispatcher<Signature, Traits, Storage>::MulticastDispatcher(MulticastDispatcher&& source)
+: mGroups(std::move(source.mGroups))
+, mKeys(std::move(source.mKeys))
+, mSlots(std::move(source.mSlots))
+, mHandles(std::move(source.mHandles))
+, mFreeHandles(std::move(source.mFreeHandles))
+, mPendingSlots(std::move(source.mPendingSlots))
+, mUnboundSlots(std::move(source.mUnboundSlots))
+, mEmptySlots(source.mEmptySlots)
+, mCallDepth(0u)
+{
+	assert(source.mCallDepth == 0u);
+}
+
+template <typename Signature, class Traits, class Storage>
+MulticastDispatcher<Signature, Traits, Storage>& MulticastDispatcher<Signature, Traits, Storage>::operator= (MulticastDispatcher&& source)
+{
+	mGroups = std::move(source.mGroups);
+	mKeys = std::move(source.mKeys);
+	mSlots = std::move(source.mSlots);
+	mHandles = std::move(source.mHandles);
+	assert(mCallDepth == 0u && source.mCallDepth == 0u);
+
+	mFreeHandles = std::move(source.mFreeHandles);
+	mPendingSlots = std::move(source.mPendingSlots);
+	mUnboundSlots = std::move(source.mUnboundSlots);
+	mEmptySlots = source.mEmptySlots;
+
+	return *this;
+}
+
+template <typename Signature, class Traits, class Storage>
+MulticastDispatcher<Signature, Traits, Storage>::~MulticastDispatcher()
+{
+}
+
+template <typename Signature, class Traits, class Storage>
+template <typename Id, typename Fn>
+typename MulticastDispatcher<Signature, Traits, Storage>::Token MulticastDispatcher<Signature, Traits, Storage>::bind(const Id& identifier, Fn function)
+{
+	Key key = Traits::keyFromId(identifier);
+	std::uint32_t handle = acquireHandle();
+	Slot slot(Traits::template trampoline1<Id>(function), handle);
+
+	// During a call, the slots must not move; hold the function back until the next applyPending()
+	if (mCallDepth != 0u)
+	{
+		mHandles[handle].slot = pendingSlot;
+
+		PendingSlot pending = { key, std::move(slot) };
+		mPendingSlots.push_back(std::move(pending));
+	}
+	else
+	{
+		// Functions held back during calls precede this one
+		applyPending();
+		insert(key, std::move(slot));
+	}
+
+	return Token(handle, mHandles[handle].generation);
+}
+
+template <typename Signature, class Traits, class Storage>
+bool MulticastDispatcher<Signature, Traits, Storage>::unbind(Token token)
+{
+	if (token.mIndex >= mHandles.size() || mHandles[token.mIndex].generation != token.mGeneration)
+		return false;
+
+	// Changes held back during calls refer to the current slot positions
+	const bool calling = mCallDepth != 0u;
+	if (!calling)
+		applyPending();
+
+	Handle& handle = mHandles[token.mIndex];
+
+	if (handle.slot == pendingSlot)
+	{
+		// Function bound during the current call, not inserted yet. It may be running, so only mark it as removed.
+		auto pending = std::find_if(mPendingSlots.begin(), mPendingSlots.end(), [&] (const PendingSlot& p)
+		{
+			return p.slot.handle == token.mIndex;
+		});
+
+		pending->slot.handle = removedHandle;
+	}
+	else
+	{
+		// Leave an empty slot, so that call() skips it and no other slot has to move. During a call, the function may
+		// be running (e.g. unbinding itself), so it is only destroyed by applyPending().
+		Slot& slot = mSlots[handle.slot];
+		slot.handle = removedHandle;
+		if (calling)
+			mUnboundSlots.push_back(handle.slot);
+		else
+			slot.function = BaseFunction();
+
+		++mEmptySlots;
+	}
+
+	++handle.generation;
+	mFreeHandles.push_back(token.mIndex);
+
+	// Compact when at least half of the slots are empty
+	if (!calling && mEmptySlots * 2u >= mSlots.size())
+		compact();
+
+	return true;
+}
+
+template <typename Signature, class Traits, class Storage>
+template <typename... Args>
+std::size_t MulticastDispatcher<Signature, Traits, Storage>::call(Parameter arg, Args&&... args) const
+{
+	static_assert(sizeof...(Args) + 1u == FunctionArity<Signature>::value, "call() expects the arguments specified by Signature.");
+
+	// The invoked functions may bind and unbind. While the call depth is non-zero, slots are neither inserted nor
+	// removed, but the containers are indexed anew in every iteration anyway. Functions held back by earlier calls
+	// follow the stored ones; those bound during this call are not invoked.
+	const Key key = Traits::keyFromBase(arg);
+	const Group* group = mGroups.find(key);
+	const std::uint32_t begin = group ? group->begin : 0u;
+	const std::uint32_t end = group ? begin + group->count : 0u;
+	const std::size_t pendingEnd = mPendingSlots.size();
+	std::size_t invoked = 0u;
+
+	++mCallDepth;
+	try
+	{
+		for (std::uint32_t i = begin; i < end; ++i)
+		{
+			const Slot& slot = mSlots[i];
+			if (slot.handle != removedHandle)
+			{
+				slot.function(arg, args...);
+				++invoked;
+			}
+		}
+
+		for (std::size_t i = 0u; i < pendingEnd; ++i)
+		{
+			const PendingSlot& pending = mPendingSlots[i];
+			if (pending.slot.handle != removedHandle && pending.key == key)
+			{
+				pending.slot.function(arg, args...);
+				++invoked;
+			}
+		}
+	}
+	catch (...)
+	{
+		// Held back changes are applied by the next bind(), unbind() or flush()
+		--mCallDepth;
+		throw;
+	}
+
+	--mCallDepth;
+	return invoked;
+}
+
+template <typename Signature, class Traits, class Storage>
+void MulticastDispatcher<Signature, Traits, Storage>::flush()
+{
+	assert(mCallDepth == 0u);
+	applyPending();
+}
+
+template <typename Signature, class Traits, class Storage>
+template <typename Id>
+bool MulticastDispatcher<Signature, Traits, Storage>::contains(const Id& identifier) const
+{
+	const Key key = Traits::keyFromId(identifier);
+	for (const PendingSlot& pending : mPendingSlots)
+	{
+		if (pending.slot.handle != removedHandle && pending.key == key)
+			return true;
+	}
+
+	const Group* group = mGroups.find(key);
+	if (!group)
+		return false;
+
+	for (std::uint32_t i = group->begin; i < group->begin + group->count; ++i)
+	{
+		if (mSlots[i].handle != removedHandle)
+			return true;
+	}
+
+	return false;
+}
+
+template <typename Signature, class Traits, class Storage>
+std::uint32_t MulticastDispatcher<Signature, Traits, Storage>::acquireHandle()
+{
+	if (mFreeHandles.empty())
+	{
+		// Generations start at 1, so that default-constructed tokens never match
+		Handle handle = { 0u, 1u };
+		mHandles.push_back(handle);
+		return static_cast<std::uint32_t>(mHandles.size() - 1u);
+	}
+	else
+	{
+		std::uint32_t handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+		return handle;
+	}
+}
+
+template <typename Signature, class Traits, class Storage>
+void MulticastDispatcher<Signature, Traits, Storage>::insert(const Key& key, Slot slot)
+{
+	// New key: append group at the end of the slot array
+	Group* group = mGroups.find(key);
+	if (!group)
+	{
+		Group newGroup = { static_cast<std::uint32_t>(mSlots.size()), 0u, static_cast<std::uint32_t>(mKeys.size()) };
+		mGroups.insert(key, newGroup);
+		mKeys.push_back(key);
+
+		group = mGroups.find(key);
+	}
+
+	// Insert slot behind the last function of the key, shift the following groups
+	const std::uint32_t position = group->begin + group->count;
+	mSlots.insert(mSlots.begin() + position, std::move(slot));
+	++group->count;
+
+	for (std::size_t i = group->index + 1u; i < mKeys.size(); ++i)
+		++mGroups.find(mKeys[i])->begin;
+
+	// Empty slots are skipped, their handles may have been reused already
+	for (std::size_t i = position; i < mSlots.size(); ++i)
+	{
+		if (mSlots[i].handle != removedHandle)
+			mHandles[mSlots[i].handle].slot = static_cast<std::uint32_t>(i);
+	}
+}
+
+template <typename Signature, class Traits, class Storage>
+void MulticastDispatcher<Signature, Traits, Storage>::compact()
+{
+	// Groups are contiguous and ordered like mKeys, so slots only move towards the front
+	std::uint32_t target = 0u;
+	for (const Key& key : mKeys)
+	{
+		Group* group = mGroups.find(key);
+		const std::uint32_t begin = group->begin;
+		const std::uint32_t end = begin + group->count;
+
+		group->begin = target;
+		for (std::uint32_t source = begin; source < end; ++source)
+		{
+			if (mSlots[source].handle != removedHandle)
+			{
+				if (source != target)
+					mSlots[target] = std::move(mSlots[source]);
+
+				mHandles[mSlots[target].handle].slot = target;
+				++target;
+			}
+		}
+
+		group->count = target - group->begin;
+	}
+
+	mSlots.erase(mSlots.begin() + target, mSlots.end());
+	mEmptySlots = 0u;
+}
+
+template <typename Signature, class Traits, class Storage>
+void MulticastDispatcher<Signature, Traits, Storage>::applyPending()
+{
+	// Destroy functions unbound during the call before insert() moves their slots
+	for (std::uint32_t index : mUnboundSlots)
+		mSlots[index].function = BaseFunction();
+
+	mUnboundSlots.clear();
+
+	// Insert in the order of the bind() calls
+	for (PendingSlot& pending : mPendingSlots)
+	{
+		if (pending.slot.handle != removedHandle)
+			insert(pending.key, std::move(pending.slot));
+	}
+
+	mPendingSlots.clear();
+
+	if (mEmptySlots != 0u && mEmptySlots * 2u >= mSlots.size())
+		compact();
+}
+
+template <typename Signature, class Traits, class Storage>
+MulticastDispatcher<Signature, Traits, Storage>::Slot::Slot(BaseFunction function, std::uint32_t handle)
+: function(std::move(function))
+, handle(handle)
+{
+}
+
+} // namespace aurora
@@ -0,0 +1,169 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Storage of one object per thread, which can be enumerated by other threads
+
+#ifndef AURORA_PERTHREAD_HPP
+#define AURORA_PERTHREAD_HPP
+
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Config.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Each thread that calls local() receives its own default-constructed T. The instances are kept alive until the
+	// PerThread object is destroyed, even if their threads terminate before, so forEach() visits all of them.
+	template <typename T>
+	class PerThread : private NonCopyable
+	{
+		private:
+			// Per thread: the instances of all PerThread<T> objects the thread has accessed, by ID. The entries don't own
+			// the instances, so entries of destroyed PerThread objects expire and are pruned.
+			struct ThreadRegistry
+			{
+				ThreadRegistry()
+				: lastId(0u)
+				, last(nullptr)
+				, instances()
+				, pruneSize(8u)
+				{
+				}
+
+				std::size_t											lastId;
+				T*													last;
+				std::unordered_map<std::size_t, std::weak_ptr<T>>	instances;
+				std::size_t											pruneSize;
+			};
+
+		public:
+			PerThread()
+			: mId(nextId())
+			, mInstances()
+			, mMutex()
+			{
+			}
+
+			T& local()
+			{
+				// Fast path: the same PerThread object as in the previous call of this thread
+				ThreadRegistry& registry = threadRegistry();
+				if (registry.lastId == mId)
+					return *registry.last;
+
+				T* instance = find(registry);
+				registry.lastId = mId;
+				registry.last = instance;
+
+				return *instance;
+			}
+
+			template <typename Fn>
+			void forEach(Fn function)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+
+				for (const std::shared_ptr<T>& instance : mInstances)
+					function(*instance);
+			}
+
+			template <typename Fn>
+			void forEach(Fn function) const
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+
+				for (const std::shared_ptr<T>& instance : mInstances)
+					function(static_cast<const T&>(*instance));
+			}
+
+		private:
+			// Returns the thread's instance, creating it on first access
+			T* find(ThreadRegistry& registry)
+			{
+				auto itr = registry.instances.find(mId);
+				if (itr != registry.instances.end())
+					return itr->second.lock().get();
+
+				std::shared_ptr<T> instance = std::make_shared<T>();
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					mInstances.push_back(instance);
+				}
+
+				registry.instances.insert(std::make_pair(mId, std::weak_ptr<T>(instance)));
+				prune(registry);
+
+				return instance.get();
+			}
+
+			// Removes the entries of destroyed PerThread objects, whenever the registry has doubled its size
+			static void prune(ThreadRegistry& registry)
+			{
+				if (registry.instances.size() < registry.pruneSize)
+					return;
+
+				for (auto itr = registry.instances.begin(); itr != registry.instances.end(); )
+				{
+					if (itr->second.expired())
+						itr = registry.instances.erase(itr);
+					else
+						++itr;
+				}
+
+				registry.pruneSize = 2u * registry.instances.size() + 8u;
+			}
+
+			static ThreadRegistry& threadRegistry()
+			{
+				static thread_local ThreadRegistry registry;
+				return registry;
+			}
+
+			// IDs start at 1 and are never reused, so thread-local entries of destroyed PerThread objects are never accessed again
+			static std::size_t nextId()
+			{
+				static std::atomic<std::size_t> counter(1u);
+				return counter++;
+			}
+
+		private:
+			std::size_t							mId;
+			std::vector<std::shared_ptr<T>>		mInstances;
+			mutable std::mutex					mMutex;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_PERTHREAD_HPP
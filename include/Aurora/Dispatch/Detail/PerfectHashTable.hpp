@@ -0,0 +1,256 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Table for dispatchers that are fully populated before use: a minimal perfect hash function is computed on seal()
+
+#ifndef AURORA_PERFECTHASHTABLE_HPP
+#define AURORA_PERFECTHASHTABLE_HPP
+
+#include <Aurora/Tools/Hash.hpp>
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Minimal perfect hashing using the "hash, displace" scheme: keys are distributed into buckets by a first hash, and each
+	// bucket receives a displacement value, chosen such that a second hash (which depends on the displacement) maps all keys
+	// of all buckets to distinct slots. Since there are exactly as many slots as keys, the hash function is minimal.
+	//
+	// Before seal() is called or after a subsequent insert(), lookups scan linearly through the entries.
+	template <typename Key, typename Value, typename Hash>
+	class PerfectHashTable
+	{
+		public:
+			PerfectHashTable()
+			: mEntries()
+			, mDisplacements()
+			, mSeed(0u)
+			, mSealed(false)
+			{
+			}
+
+			Value* find(const Key& key)
+			{
+				return const_cast<Value*>(static_cast<const PerfectHashTable&>(*this).find(key));
+			}
+
+			const Value* find(const Key& key) const
+			{
+				const std::size_t hash = Hash()(key);
+
+				if (mSealed)
+				{
+					const Entry& entry = mEntries[slot(hash, mDisplacements[bucket(hash)])];
+					return entry.hash == hash && entry.key == key ? &entry.value : nullptr;
+				}
+
+				for (const Entry& entry : mEntries)
+				{
+					if (entry.hash == hash && entry.key == key)
+						return &entry.value;
+				}
+
+				return nullptr;
+			}
+
+			void insert(const Key& key, Value value)
+			{
+				if (Value* existing = find(key))
+				{
+					*existing = std::move(value);
+				}
+				else
+				{
+					mEntries.push_back(Entry(Hash()(key), key, std::move(value)));
+					mSealed = false;
+				}
+			}
+
+			std::size_t size() const
+			{
+				return mEntries.size();
+			}
+
+			void seal()
+			{
+				mSealed = false;
+				if (mEntries.empty() || hasDuplicateHashes())
+					return;
+
+				// If some bucket finds no displacement, start over with other hash functions; if none works, stay linear
+				std::vector<std::size_t> entryOfSlot;
+				for (std::uint32_t seed = 0u; seed < maxSeeds; ++seed)
+				{
+					mSeed = mixBits(seed);
+					if (assignSlots(entryOfSlot))
+					{
+						// Reorder entries, so that each one is stored at its slot
+						std::vector<Entry> entries;
+						entries.reserve(mEntries.size());
+
+						for (std::size_t entry : entryOfSlot)
+							entries.push_back(std::move(mEntries[entry]));
+
+						mEntries.swap(entries);
+						mSealed = true;
+						return;
+					}
+				}
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			// Number of hash functions that seal() tries before it gives up
+			static const std::uint32_t maxSeeds = 8u;
+
+			struct Entry
+			{
+				Entry(std::size_t hash, const Key& key, Value value)
+				: hash(hash)
+				, key(key)
+				, value(std::move(value))
+				{
+				}
+
+				std::size_t		hash;
+				Key				key;
+				Value			value;
+			};
+
+		private:
+			// Maps 32 random bits to [0, n) without division
+			static std::size_t reduce(std::uint64_t bits, std::size_t n)
+			{
+				return static_cast<std::size_t>(((bits & 0xffffffffull) * n) >> 32);
+			}
+
+			std::size_t bucket(std::size_t hash) const
+			{
+				return reduce(mixBits(hash + mSeed) >> 32, mDisplacements.size());
+			}
+
+			std::size_t slot(std::size_t hash, std::uint32_t displacement) const
+			{
+				return reduce(mixBits(hash + mSeed + goldenRatio64 * (displacement + 1u)), mEntries.size());
+			}
+
+			// Keys with equal hash values cannot be separated by any displacement
+			bool hasDuplicateHashes() const
+			{
+				std::vector<std::size_t> hashes;
+				hashes.reserve(mEntries.size());
+
+				for (const Entry& entry : mEntries)
+					hashes.push_back(entry.hash);
+
+				std::sort(hashes.begin(), hashes.end());
+				return std::adjacent_find(hashes.begin(), hashes.end()) != hashes.end();
+			}
+
+			// Chooses the displacements of all buckets for the current seed; entryOfSlot receives the entry index of each slot.
+			// Returns false if a bucket finds no displacement within a bounded number of attempts.
+			bool assignSlots(std::vector<std::size_t>& entryOfSlot)
+			{
+				// Assign keys to buckets, about 2 keys per bucket
+				const std::size_t size = mEntries.size();
+				std::vector<std::vector<std::size_t>> buckets(std::max<std::size_t>(size / 2u, 1u));
+				mDisplacements.assign(buckets.size(), 0u);
+
+				for (std::size_t i = 0u; i < size; ++i)
+					buckets[bucket(mEntries[i].hash)].push_back(i);
+
+				// Process large buckets first, while there are still many free slots
+				std::vector<std::size_t> order(buckets.size());
+				for (std::size_t b = 0u; b < order.size(); ++b)
+					order[b] = b;
+
+				std::stable_sort(order.begin(), order.end(), [&buckets] (std::size_t lhs, std::size_t rhs)
+				{
+					return buckets[lhs].size() > buckets[rhs].size();
+				});
+
+				// The last buckets may have a single free slot, which a random displacement hits with probability 1/size
+				const std::uint64_t maxDisplacements = std::min<std::uint64_t>(16u * static_cast<std::uint64_t>(size) + 64u, 0xffffffffull);
+
+				// Find displacement for each bucket, so that its keys land in distinct free slots
+				entryOfSlot.assign(size, size);
+				std::vector<std::size_t> slots;
+
+				for (std::size_t b : order)
+				{
+					const std::vector<std::size_t>& members = buckets[b];
+					if (members.empty())
+						break;
+
+					std::uint32_t displacement = 0u;
+					for (;; ++displacement)
+					{
+						if (displacement == maxDisplacements)
+							return false;
+
+						slots.clear();
+						for (std::size_t i : members)
+						{
+							const std::size_t s = slot(mEntries[i].hash, displacement);
+							if (entryOfSlot[s] != size || std::find(slots.begin(), slots.end(), s) != slots.end())
+								break;
+
+							slots.push_back(s);
+						}
+
+						if (slots.size() == members.size())
+							break;
+					}
+
+					for (std::size_t k = 0u; k < members.size(); ++k)
+						entryOfSlot[slots[k]] = members[k];
+
+					mDisplacements[b] = displacement;
+				}
+
+				return true;
+			}
+
+		private:
+			std::vector<Entry>				mEntries;
+			std::vector<std::uint32_t>		mDisplacements;
+			std::uint64_t					mSeed;
+			bool							mSealed;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_PERFECTHASHTABLE_HPP
@@ -26,83 +26,409 @@
 namespace aurora
 {
 
-template <typename Signature, typename Traits>
-SingleDispatcher<Signature, Traits>::SingleDispatcher()
-: mMap()
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+SingleDispatcher<Signature, Traits, Storage, Statistics>::SingleDispatcher(bool resolveBases)
+: mTable()
 , mFallback()
+, mGeneration(detail::nextDispatchGeneration())
+, mSealed(false)
+, mResolver(resolveBases ? detail::allocateUnique<BaseResolver>(ResolverAllocator(), ContainerAllocator()) : ResolverPtr())
+, mStatistics()
 {
 }
 
-template <typename Signature, typename Traits>
-SingleDispatcher<Signature, Traits>::SingleDispatcher(SingleDispatcher&& source)
-: mMap(std::move(source.mMap))
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Allocator>
+SingleDispatcher<Signature, Traits, Storage, Statistics>::SingleDispatcher(bool resolveBases, const Allocator& allocator)
+: mTable(allocator)
+, mFallback()
+, mGeneration(detail::nextDispatchGeneration())
+, mSealed(false)
+, mResolver(resolveBases ? detail::allocateUnique<BaseResolver>(ResolverAllocator(allocator), ContainerAllocator(allocator)) : ResolverPtr())
+, mStatistics()
+{
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+SingleDispatcher<Signature, Traits, Storage, Statistics>::SingleDispatcher(SingleDispatcher&& source)
+: mTable(std::move(source.mTable))
 , mFallback(std::move(source.mFallback))
+, mGeneration(detail::nextDispatchGeneration())
+, mSealed(source.mSealed)
+, mResolver(std::move(source.mResolver))
+, mStatistics(source.mStatistics)
 {
+	source.mGeneration = detail::nextDispatchGeneration();
+	clearResolvedBases();
 }
 
-template <typename Signature, typename Traits>
-SingleDispatcher<Signature, Traits>& SingleDispatcher<Signature, Traits>::operator= (SingleDispatcher&& source)
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+SingleDispatcher<Signature, Traits, Storage, Statistics>::SingleDispatcher(const SingleDispatcher& origin, detail::CloneTag)
+: mTable(origin.mTable)
+, mFallback(origin.mFallback)
+, mGeneration(detail::nextDispatchGeneration())
+, mSealed(origin.mSealed)
+, mResolver(origin.mResolver ? detail::allocateUnique<BaseResolver>(origin.mResolver.get_deleter().allocator(), *origin.mResolver,
+	ContainerAllocator(origin.mResolver.get_deleter().allocator())) : ResolverPtr())
+, mStatistics(origin.mStatistics)
 {
-	mMap = std::move(source.mMap);
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+SingleDispatcher<Signature, Traits, Storage, Statistics>& SingleDispatcher<Signature, Traits, Storage, Statistics>::operator= (SingleDispatcher&& source)
+{
+	mTable = std::move(source.mTable);
 	mFallback = std::move(source.mFallback);
+	mGeneration = detail::nextDispatchGeneration();
+	mSealed = source.mSealed;
+	mResolver = std::move(source.mResolver);
+	mStatistics = source.mStatistics;
+	clearResolvedBases();
+
+	source.mGeneration = detail::nextDispatchGeneration();
 
 	return *this;
 }
 
-template <typename Signature, typename Traits>
-SingleDispatcher<Signature, Traits>::~SingleDispatcher()
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+SingleDispatcher<Signature, Traits, Storage, Statistics>::~SingleDispatcher()
 {
 }
 
-template <typename Signature, typename Traits>
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+SingleDispatcher<Signature, Traits, Storage, Statistics>* SingleDispatcher<Signature, Traits, Storage, Statistics>::clone() const
+{
+	return new SingleDispatcher(*this, detail::CloneTag());
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
 template <typename Id, typename Fn>
-void SingleDispatcher<Signature, Traits>::bind(const Id& identifier, Fn function)
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::bind(const Id& identifier, Fn function)
 {
-	mMap[Traits::keyFromId(identifier)] = Traits::template trampoline1<Id>(function);
+	if (mSealed)
+		throw FunctionCallException("SingleDispatcher::bind() - dispatcher has been sealed");
+
+	const Key key = Traits::keyFromId(identifier);
+	mTable.insert(key, Traits::template trampoline1<Id>(function));
+	mGeneration = detail::nextDispatchGeneration();
+
+	if (mResolver)
+	{
+		mResolver->addProbe(key, identifier);
+
+		// Resolved functions may be outdated or dangling
+		mResolver->clear();
+	}
 }
 
-template <typename Signature, typename Traits>
-typename SingleDispatcher<Signature, Traits>::Result SingleDispatcher<Signature, Traits>::call(Parameter arg) const
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename... Args>
+typename SingleDispatcher<Signature, Traits, Storage, Statistics>::Result SingleDispatcher<Signature, Traits, Storage, Statistics>::call(
+	Parameter arg, Args&&... args) const
 {
+	static_assert(sizeof...(Args) + 1u == FunctionArity<Signature>::value, "call() expects the arguments specified by Signature.");
+
 	Key key = Traits::keyFromBase(arg);
 
 	// If no corresponding class (or base class) has been found, throw exception
-	auto itr = mMap.find(key);
-	if (itr == mMap.end())
+	const BaseFunction* function = find(key, arg);
+	if (!function)
 	{
+		mStatistics.miss(key);
+
 		if (mFallback)
-			return mFallback(arg);
+			return mFallback(arg, std::forward<Args>(args)...);
 		else
 			throw FunctionCallException(std::string("SingleDispatcher::call() - function with parameter \"") + Traits::name(key) + "\" not registered");
 	}
 
 	// Otherwise, call dispatched function
-	return itr->second(arg);
+	auto measurement = mStatistics.measure(key);
+	return (*function)(arg, std::forward<Args>(args)...);
 }
 
-template <typename Signature, typename Traits>
-typename SingleDispatcher<Signature, Traits>::Result SingleDispatcher<Signature, Traits>::call(Parameter arg, UserData data) const
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename... Args>
+typename SingleDispatcher<Signature, Traits, Storage, Statistics>::TryResult SingleDispatcher<Signature, Traits, Storage, Statistics>::tryCall(
+	Parameter arg, Args&&... args) const
 {
+	static_assert(sizeof...(Args) + 1u == FunctionArity<Signature>::value, "tryCall() expects the arguments specified by Signature.");
+
 	Key key = Traits::keyFromBase(arg);
 
-	// If no corresponding class (or base class) has been found, throw exception
-	auto itr = mMap.find(key);
-	if (itr == mMap.end())
+	const BaseFunction* function = find(key, arg);
+	if (!function)
 	{
+		mStatistics.miss(key);
+		return detail::TryCall<Result>::miss();
+	}
+
+	auto measurement = mStatistics.measure(key);
+	return detail::TryCall<Result>::invoke(*function, arg, std::forward<Args>(args)...);
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+std::function<Signature> SingleDispatcher<Signature, Traits, Storage, Statistics>::resolve(Parameter arg) const
+{
+	Key key = Traits::keyFromBase(arg);
+
+	const BaseFunction* function = find(key, arg);
+	if (!function)
+	{
+		mStatistics.miss(key);
+
 		if (mFallback)
-			return mFallback(arg, data);
+			return mFallback;
 		else
-			throw FunctionCallException(std::string("SingleDispatcher::call() - function with parameter \"") + Traits::name(key) + "\" not registered");
+			throw FunctionCallException(std::string("SingleDispatcher::resolve() - function with parameter \"") + Traits::name(key) + "\" not registered");
 	}
 
-	// Otherwise, call dispatched function
-	return itr->second(arg, data);
+	return detail::RecordedFunction<Result, BaseFunction, Recorder, Key>(*function, mStatistics, key);
 }
 
-template <typename Signature, typename Traits>
-void SingleDispatcher<Signature, Traits>::fallback(std::function<Signature> function)
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Id>
+bool SingleDispatcher<Signature, Traits, Storage, Statistics>::contains(const Id& identifier) const
+{
+	return mTable.find(Traits::keyFromId(identifier)) != nullptr;
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Itr, typename... Args>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::callBatch(Itr first, Itr last, Args&&... args) const
+{
+	static_assert(sizeof...(Args) + 1u == FunctionArity<Signature>::value, "callBatch() expects the arguments specified by Signature.");
+
+	dispatchBatch(first, last, [this, &args...] (const BaseFunction* function, Parameter arg)
+	{
+		if (function)
+			(*function)(arg, args...);
+		else
+			mFallback(arg, args...);
+	});
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+DispatchReport SingleDispatcher<Signature, Traits, Storage, Statistics>::statistics() const
+{
+	return mStatistics.report([] (const Key& key) -> std::string
+	{
+		return Traits::name(key);
+	});
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::seal()
+{
+	mTable.seal();
+	mSealed = true;
+
+	// Sealing may relocate the functions, so call sites and resolved functions referring to them are dangling
+	mGeneration = detail::nextDispatchGeneration();
+	clearResolvedBases();
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::optimize()
+{
+	mTable.optimize();
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::fallback(std::function<Signature> function)
 {
 	mFallback = std::move(function);
 }
 
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+const typename SingleDispatcher<Signature, Traits, Storage, Statistics>::BaseFunction* SingleDispatcher<Signature, Traits, Storage, Statistics>::find(
+	const Key& key, Parameter arg) const
+{
+	const BaseFunction* function = mTable.find(key);
+	if (!function && mResolver)
+	{
+		function = mResolver->resolve(key, arg, [this] (const Key& base)
+		{
+			return mTable.find(base);
+		});
+	}
+
+	return function;
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::clearResolvedBases()
+{
+	if (mResolver)
+		mResolver->clear();
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Itr, typename Invoker>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::dispatchBatch(Itr first, Itr last, Invoker invoker) const
+{
+	typedef typename std::remove_reference<typename std::iterator_traits<Itr>::reference>::type Element;
+
+	detail::BatchScratchLease scratch;
+	scratch->reset(static_cast<std::size_t>(std::distance(first, last)));
+
+	// Assign a group to each distinct function. Runs of equal keys need only one lookup.
+	Optional<Key> lastKey;
+	std::size_t lastGroup = 0u;
+
+	std::size_t i = 0u;
+	for (Itr itr = first; itr != last; ++itr, ++i)
+	{
+		Element& element = *itr;
+		Parameter arg = detail::toParameter<Parameter>(element);
+		Key key = Traits::keyFromBase(arg);
+
+		if (!lastKey || !(*lastKey == key))
+		{
+			// Throw before any function is invoked, leaving no partially processed range
+			const BaseFunction* function = find(key, arg);
+			if (!function && !mFallback)
+				throw FunctionCallException(std::string("SingleDispatcher::callBatch() - function with parameter \"") + Traits::name(key) + "\" not registered");
+
+			lastKey = key;
+			lastGroup = scratch->group(function);
+		}
+
+		scratch->assign(i, std::addressof(element), lastGroup, false);
+	}
+
+	scratch->sort();
+	scratch->forEach([this, &invoker] (const void* function, const void* element, bool)
+	{
+		Parameter arg = detail::toParameter<Parameter>(*static_cast<Element*>(const_cast<void*>(element)));
+		invokeBatched(static_cast<const BaseFunction*>(function), arg, invoker,
+			std::integral_constant<bool, !std::is_same<Statistics, NoDispatchStatistics>::value>());
+	});
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Invoker>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::invokeBatched(const BaseFunction* function, Parameter arg, Invoker& invoker,
+	std::true_type /*record*/) const
+{
+	// The keys are not stored during sorting, so they are computed again
+	Key key = Traits::keyFromBase(arg);
+
+	if (function)
+	{
+		auto measurement = mStatistics.measure(key);
+		invoker(function, arg);
+	}
+	else
+	{
+		mStatistics.miss(key);
+		invoker(function, arg);
+	}
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <typename Invoker>
+void SingleDispatcher<Signature, Traits, Storage, Statistics>::invokeBatched(const BaseFunction* function, Parameter arg, Invoker& invoker,
+	std::false_type /*record*/) const
+{
+	invoker(function, arg);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <std::size_t N>
+SingleDispatcher<Signature, Traits, Storage, Statistics>::CallSite<N>::CallSite()
+: mKeys()
+, mFunctions()
+, mSize(0u)
+, mNext(0u)
+, mGeneration(0u)
+, mHits(0u)
+, mMisses(0u)
+{
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <std::size_t N>
+template <typename... Args>
+typename SingleDispatcher<Signature, Traits, Storage, Statistics>::Result SingleDispatcher<Signature, Traits, Storage, Statistics>::CallSite<N>::call(
+	const SingleDispatcher& dispatcher, Parameter arg, Args&&... args)
+{
+	Key key = Traits::keyFromBase(arg);
+
+	// Misses (unregistered keys) are delegated to the dispatcher, which handles fallback, exception and statistics
+	if (const BaseFunction* function = lookup(dispatcher, key, arg))
+	{
+		auto measurement = dispatcher.mStatistics.measure(key);
+		return (*function)(arg, std::forward<Args>(args)...);
+	}
+	else
+	{
+		return dispatcher.call(arg, std::forward<Args>(args)...);
+	}
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <std::size_t N>
+std::size_t SingleDispatcher<Signature, Traits, Storage, Statistics>::CallSite<N>::hits() const
+{
+	return mHits;
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <std::size_t N>
+std::size_t SingleDispatcher<Signature, Traits, Storage, Statistics>::CallSite<N>::misses() const
+{
+	return mMisses;
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <std::size_t N>
+float SingleDispatcher<Signature, Traits, Storage, Statistics>::CallSite<N>::hitRate() const
+{
+	const std::size_t total = mHits + mMisses;
+	return total == 0u ? 0.f : static_cast<float>(mHits) / static_cast<float>(total);
+}
+
+template <typename Signature, typename Traits, typename Storage, typename Statistics>
+template <std::size_t N>
+const typename SingleDispatcher<Signature, Traits, Storage, Statistics>::BaseFunction* SingleDispatcher<Signature, Traits, Storage, Statistics>::CallSite<N>::lookup(
+	const SingleDispatcher& dispatcher, const Key& key, Parameter arg)
+{
+	// Dispatcher modified or different dispatcher: remembered functions may be dangling
+	if (mGeneration != dispatcher.mGeneration)
+	{
+		mGeneration = dispatcher.mGeneration;
+		mSize = 0u;
+		mNext = 0u;
+	}
+
+	for (std::size_t i = 0u; i < mSize; ++i)
+	{
+		if (*mKeys[i] == key)
+		{
+			++mHits;
+			return mFunctions[i];
+		}
+	}
+
+	++mMisses;
+	const BaseFunction* function = dispatcher.find(key, arg);
+
+	// Remember only keys with a function (possibly resolved from a base class), replacing the entries in round-robin order
+	if (function)
+	{
+		mKeys[mNext] = key;
+		mFunctions[mNext] = function;
+		mNext = (mNext + 1u) % N;
+
+		if (mSize < N)
+			++mSize;
+	}
+
+	return function;
+}
+
 } // namespace aurora
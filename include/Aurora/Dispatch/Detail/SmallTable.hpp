@@ -0,0 +1,198 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Table for dispatchers with few keys: hash values are compared in parallel using SIMD instructions
+
+#ifndef AURORA_SMALLTABLE_HPP
+#define AURORA_SMALLTABLE_HPP
+
+#include <Aurora/Config.hpp>
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#if defined(AURORA_HAS_AVX2)
+	#include <immintrin.h>
+#elif defined(AURORA_HAS_SSE2)
+	#include <emmintrin.h>
+#endif
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Returns a bit mask, in which bit i is set if hashes[i] == hash. Reads up to 7 elements beyond count, which are ignored.
+	inline std::uint32_t matchHashes(const std::uint32_t* hashes, std::size_t count, std::uint32_t hash)
+	{
+		std::uint32_t mask = 0u;
+
+#if defined(AURORA_HAS_AVX2)
+		const __m256i wanted = _mm256_set1_epi32(static_cast<int>(hash));
+		for (std::size_t i = 0u; i < count; i += 8u)
+		{
+			__m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + i)), wanted);
+			mask |= static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(equal))) << i;
+		}
+#elif defined(AURORA_HAS_SSE2)
+		const __m128i wanted = _mm_set1_epi32(static_cast<int>(hash));
+		for (std::size_t i = 0u; i < count; i += 4u)
+		{
+			__m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hashes + i)), wanted);
+			mask |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(equal))) << i;
+		}
+#else
+		for (std::size_t i = 0u; i < count; ++i)
+		{
+			if (hashes[i] == hash)
+				mask |= 1u << i;
+		}
+#endif
+
+		return (count < 32u) ? mask & ((1u << count) - 1u) : mask;
+	}
+
+
+	// Stores up to Threshold keys in arrays. Lookups compare the 32-bit hash values of all keys at once, and only the
+	// keys with matching hash value. When more keys are inserted, all entries are moved to a table of the policy Base.
+	template <typename Key, typename Value, typename Hash, typename Base, std::size_t Threshold>
+	class SmallTable
+	{
+		static_assert(Threshold >= 1u && Threshold <= 32u, "SmallStorage threshold must be in [1, 32].");
+
+		private:
+			typedef typename Base::template Table<Key, Value, Hash>		LargeTable;
+
+			// Hash array is padded to full SIMD registers
+			static const std::size_t Capacity = (Threshold + 7u) / 8u * 8u;
+
+		public:
+			SmallTable()
+			: mHashes()
+			, mKeys()
+			, mValues()
+			, mLarge()
+			, mIsLarge(false)
+			{
+			}
+
+			Value* find(const Key& key)
+			{
+				return const_cast<Value*>(static_cast<const SmallTable&>(*this).find(key));
+			}
+
+			const Value* find(const Key& key) const
+			{
+				if (mIsLarge)
+					return mLarge.find(key);
+				else
+					return findSmall(key, hashOf(key));
+			}
+
+			void insert(const Key& key, Value value)
+			{
+				const std::uint32_t hash = hashOf(key);
+
+				if (mIsLarge)
+				{
+					mLarge.insert(key, std::move(value));
+				}
+				else if (Value* existing = const_cast<Value*>(findSmall(key, hash)))
+				{
+					*existing = std::move(value);
+				}
+				else if (mKeys.size() < Threshold)
+				{
+					// Reserve the full size at once, so that values don't move while the table is small
+					mKeys.reserve(Threshold);
+					mValues.reserve(Threshold);
+
+					mHashes[mKeys.size()] = hash;
+					mKeys.push_back(key);
+					mValues.push_back(std::move(value));
+				}
+				else
+				{
+					for (std::size_t i = 0u; i < mKeys.size(); ++i)
+						mLarge.insert(mKeys[i], std::move(mValues[i]));
+
+					mLarge.insert(key, std::move(value));
+					mKeys = std::vector<Key>();
+					mValues = std::vector<Value>();
+					mIsLarge = true;
+				}
+			}
+
+			std::size_t size() const
+			{
+				return mIsLarge ? mLarge.size() : mKeys.size();
+			}
+
+			void seal()
+			{
+				if (mIsLarge)
+					mLarge.seal();
+			}
+
+			void optimize()
+			{
+				if (mIsLarge)
+					mLarge.optimize();
+			}
+
+		private:
+			static std::uint32_t hashOf(const Key& key)
+			{
+				const std::uint64_t hash = Hash()(key);
+				return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+			}
+
+			const Value* findSmall(const Key& key, std::uint32_t hash) const
+			{
+				std::uint32_t mask = matchHashes(mHashes, mKeys.size(), hash);
+
+				for (std::size_t i = 0u; mask != 0u; ++i, mask >>= 1)
+				{
+					if ((mask & 1u) && mKeys[i] == key)
+						return &mValues[i];
+				}
+
+				return nullptr;
+			}
+
+		private:
+			std::uint32_t			mHashes[Capacity];
+			std::vector<Key>		mKeys;
+			std::vector<Value>		mValues;
+			LargeTable				mLarge;
+			bool					mIsLarge;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_SMALLTABLE_HPP
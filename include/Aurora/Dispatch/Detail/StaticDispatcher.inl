@@ -0,0 +1,94 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace aurora
+{
+
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+constexpr typename StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::FunctionArray
+	StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::sFunctions;
+
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::StaticDispatcher()
+: mTable()
+, mFallback(nullptr)
+{
+	// Braced initializers are evaluated in order, so that later bindings overwrite earlier ones with the same key
+	std::size_t index = 0u;
+	int expand[] = { 0, (mTable.insert(Traits::keyFromId(Type<typename Bindings::Class>()), sFunctions[index++]), 0)... };
+	(void) expand;
+
+	mTable.seal();
+}
+
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+template <typename... Args>
+typename StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::Result
+	StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::call(Parameter arg, Args&&... args) const
+{
+	return find(arg)(arg, std::forward<Args>(args)...);
+}
+
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+template <typename... Args>
+typename StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::TryResult
+	StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::tryCall(Parameter arg, Args&&... args) const
+{
+	if (const Function* function = mTable.find(Traits::keyFromBase(arg)))
+		return detail::TryCall<Result>::invoke(*function, arg, std::forward<Args>(args)...);
+	else
+		return detail::TryCall<Result>::miss();
+}
+
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+template <typename Id>
+bool StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::contains(const Id& identifier) const
+{
+	return mTable.find(Traits::keyFromId(identifier)) != nullptr;
+}
+
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+void StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::fallback(Signature* function)
+{
+	mFallback = function;
+}
+
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+typename StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::Function
+	StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>::find(Parameter arg) const
+{
+	Key key = Traits::keyFromBase(arg);
+
+	const Function* function = mTable.find(key);
+	if (function)
+		return *function;
+
+	if (!mFallback)
+		throw FunctionCallException(std::string("StaticDispatcher::call() - function with parameter \"") + Traits::name(key) + "\" not registered");
+
+	return mFallback;
+}
+
+} // namespace aurora
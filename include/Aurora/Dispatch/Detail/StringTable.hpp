@@ -0,0 +1,185 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// Table for dispatchers with string keys: the characters of all keys are copied into one contiguous arena
+
+#ifndef AURORA_STRINGTABLE_HPP
+#define AURORA_STRINGTABLE_HPP
+
+#include <Aurora/Tools/StringKey.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Open-addressing table that interns its keys. Each slot stores hash, length and the first 8 characters of its key,
+	// so that mismatches are usually detected without accessing the arena.
+	template <typename Key, typename Value, typename Hash>
+	class StringTable
+	{
+		static_assert(std::is_same<Key, StringKey>::value, "StringStorage requires aurora::StringKey keys.");
+
+		public:
+			StringTable()
+			: mSlots()
+			, mArena()
+			, mValues()
+			{
+			}
+
+			Value* find(const StringKey& key)
+			{
+				return const_cast<Value*>(static_cast<const StringTable&>(*this).find(key));
+			}
+
+			const Value* find(const StringKey& key) const
+			{
+				if (const Slot* slot = findSlot(key))
+					return &mValues[slot->value - 1u];
+				else
+					return nullptr;
+			}
+
+			void insert(const StringKey& key, Value value)
+			{
+				if (const Slot* slot = findSlot(key))
+				{
+					mValues[slot->value - 1u] = std::move(value);
+					return;
+				}
+
+				// Keep load factor at 1/2 or below
+				if (2u * (mValues.size() + 1u) > mSlots.size())
+					rehash(std::max<std::size_t>(16u, 2u * mSlots.size()));
+
+				Slot slot = { key.hash(), prefix(key), static_cast<std::uint32_t>(mArena.size()),
+					static_cast<std::uint32_t>(key.size()), static_cast<std::uint32_t>(mValues.size() + 1u) };
+
+				mArena.insert(mArena.end(), key.data(), key.data() + key.size());
+				mValues.push_back(std::move(value));
+				place(slot);
+			}
+
+			std::size_t size() const
+			{
+				return mValues.size();
+			}
+
+			void seal()
+			{
+				mArena.shrink_to_fit();
+				mValues.shrink_to_fit();
+			}
+
+			void optimize()
+			{
+			}
+
+		private:
+			// value is the index + 1 into mValues, or 0 for empty slots
+			struct Slot
+			{
+				std::size_t			hash;
+				std::uint64_t		prefix;
+				std::uint32_t		offset;
+				std::uint32_t		length;
+				std::uint32_t		value;
+			};
+
+		private:
+			// First 8 characters of the key, padded with zeros
+			static std::uint64_t prefix(const StringKey& key)
+			{
+				std::uint64_t result = 0u;
+				std::memcpy(&result, key.data(), std::min<std::size_t>(key.size(), 8u));
+
+				return result;
+			}
+
+			const Slot* findSlot(const StringKey& key) const
+			{
+				if (mSlots.empty())
+					return nullptr;
+
+				const std::uint64_t keyPrefix = prefix(key);
+				const std::size_t mask = mSlots.size() - 1u;
+
+				for (std::size_t i = key.hash() & mask; ; i = (i + 1u) & mask)
+				{
+					const Slot& slot = mSlots[i];
+					if (slot.value == 0u)
+						return nullptr;
+
+					// Compare the cheap properties first, the prefix already covers the first 8 characters
+					if (slot.hash == key.hash() && slot.length == key.size() && slot.prefix == keyPrefix
+						&& (slot.length <= 8u || std::memcmp(&mArena[slot.offset + 8u], key.data() + 8u, slot.length - 8u) == 0))
+						return &slot;
+				}
+			}
+
+			void place(const Slot& slot)
+			{
+				const std::size_t mask = mSlots.size() - 1u;
+
+				std::size_t i = slot.hash & mask;
+				while (mSlots[i].value != 0u)
+					i = (i + 1u) & mask;
+
+				mSlots[i] = slot;
+			}
+
+			void rehash(std::size_t slotCount)
+			{
+				std::vector<Slot> slots;
+				slots.swap(mSlots);
+
+				Slot empty = {};
+				mSlots.resize(slotCount, empty);
+
+				for (const Slot& slot : slots)
+				{
+					if (slot.value != 0u)
+						place(slot);
+				}
+			}
+
+		private:
+			std::vector<Slot>		mSlots;
+			std::vector<char>		mArena;
+			std::vector<Value>		mValues;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_STRINGTABLE_HPP
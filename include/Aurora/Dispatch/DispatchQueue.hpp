@@ -0,0 +1,216 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class template aurora::DispatchQueue
+
+#ifndef AURORA_DISPATCHQUEUE_HPP
+#define AURORA_DISPATCHQUEUE_HPP
+
+#include <Aurora/Dispatch/DispatchTraits.hpp>
+#include <Aurora/Dispatch/Detail/PerThread.hpp>
+#include <Aurora/Dispatch/Detail/Arena.hpp>
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Meta/Variadic.hpp>
+#include <Aurora/Config.hpp>
+
+#include <mutex>
+#include <typeinfo>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Queue that collects objects and dispatches them later, grouped by their class.
+/// @details When objects of different classes are dispatched as soon as they are created, the invoked functions alternate
+///  constantly. A DispatchQueue instead stores copies of the objects passed to post(), and dispatches all of them in drain().
+///  The objects are sorted by their dispatch key beforehand, so that each function is invoked for all its objects in a row.
+///  @n@n Every thread posts into its own buffer, so producers don't contend with each other. The objects are allocated in
+///  arenas, whose memory is reused after each drain(); memory consumption is thus bounded by the largest number of objects
+///  pending at the same time.
+///  @n@n Ordering: objects with the same key that are posted by the same thread are dispatched in the order of posting.
+///  No order is guaranteed between different keys, or between objects posted by different threads. Integral and enum keys
+///  (such as those of aurora::DenseDispatchTraits) are sorted by their value, so the objects of each key are dispatched in
+///  one contiguous run. Other keys, such as std::type_index, are sorted by a 32-bit hash value; in the rare case that two
+///  keys have the same hash value, their runs may interleave.
+/// @tparam Dispatcher Dispatcher that invokes the functions, aurora::SingleDispatcher or aurora::DoubleDispatcher.
+/// @tparam N Number of objects per dispatch: 1 for aurora::SingleDispatcher, 2 for aurora::DoubleDispatcher.
+/// @code
+/// aurora::SingleDispatcher<void(Event&)> dispatcher;
+/// aurora::DispatchQueue<aurora::SingleDispatcher<void(Event&)>> queue(dispatcher);
+///
+/// // Any thread
+/// queue.post(Collision(a, b));
+///
+/// // Once per frame
+/// queue.drain();
+/// @endcode
+template <class Dispatcher, std::size_t N = 1>
+class DispatchQueue : private NonCopyable
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public types
+	public:
+		/// @brief Function parameter type denoting the object used for the dispatch
+		///
+		typedef typename Dispatcher::Parameter					Parameter;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Static assertions
+
+	static_assert(N == 1 || N == 2, "DispatchQueue supports one or two objects per dispatch.");
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Constructor
+		/// @param dispatcher Dispatcher that is used by drain(). Must outlive the queue.
+		explicit					DispatchQueue(const Dispatcher& dispatcher);
+
+		/// @brief Destructor
+		/// @details Destroys pending objects without dispatching them. No thread may post during destruction.
+									~DispatchQueue();
+
+		/// @brief Stores copies of objects, to be dispatched by the next drain().
+		/// @details Usage: <tt>post(object)</tt> or, for N = 2, <tt>post(object1, object2)</tt>. The objects are copied or
+		///  moved into the calling thread's buffer as their static type, so they must be passed as their most derived
+		///  class; for polymorphic classes, this is checked by an assertion. The objects are grouped by the keys that the
+		///  dispatcher's traits compute from the stored copies. Can be invoked concurrently by any threads, also by
+		///  functions that are invoked during drain(); these objects are dispatched by the next drain().
+		/// @param objects N objects whose classes derive from the dispatcher's parameter class.
+		template <typename... Objects>
+		void						post(Objects&&... objects);
+
+		/// @brief Dispatches all posted objects and destroys them afterwards.
+		/// @details Must not be invoked by multiple threads concurrently. If a function throws an exception, the remaining
+		///  objects are destroyed without being dispatched, and the exception is propagated.
+		/// @param args Additional user arguments, one for each further parameter in the dispatcher's signature. Since they
+		///  are shared by all function calls, they are passed as lvalues and never moved from; the signature must therefore
+		///  not contain rvalue reference parameters.
+		/// @return Number of dispatches.
+		template <typename... Args>
+		std::size_t					drain(Args&&... args);
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		typedef typename std::remove_pointer<typename std::remove_reference<Parameter>::type>::type Object;
+		typedef typename Dispatcher::KeyTraits										Traits;
+		typedef detail::MakeIndexSequence<N>										Indices;
+
+		// Posted objects, sorted by the sort keys of all objects (the first object's key being the most significant)
+		struct Record
+		{
+			std::uint64_t				keys[N];
+			Object*						objects[N];
+		};
+
+		// Objects that are not trivially destructible
+		struct Destructor
+		{
+			void*						object;
+			void						(*destroy)(void*);
+		};
+
+		// Posted objects of one thread, together with their memory
+		struct Batch
+		{
+			void						clear();
+
+			detail::Arena				arena;
+			std::vector<Record>			records;
+			std::vector<Destructor>		destructors;
+		};
+
+		// Per-thread buffer: producers post into active, drain() swaps it with the cleared batch
+		struct Buffer
+		{
+			std::mutex					mutex;
+			Batch						active;
+			Batch						drained;
+		};
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		// Copies an object into the batch and returns a pointer to it
+		template <typename T>
+		static Object*				store(Batch& batch, T&& object);
+
+		template <typename T>
+		static void					destroy(void* object);
+
+		// Returns the value by which objects are sorted: the dispatch key itself if it is integral or an enum, otherwise
+		// its hash value folded to 32 bits
+		static std::uint64_t		sortKey(Object* object);
+
+		template <typename Key>
+		static std::uint64_t		sortKey(const Key& key, std::true_type /*isIntegral*/);
+
+		template <typename Key>
+		static std::uint64_t		sortKey(const Key& key, std::false_type /*isIntegral*/);
+
+		// Collects and sorts all records, dispatches them using invoker(record), and clears the drained batches
+		template <typename Invoker>
+		std::size_t					drainImpl(Invoker invoker);
+
+		// Stable LSD radix sort of mRecords by keys, skipping bytes that are zero in all keys
+		void						sortRecords();
+
+		template <std::size_t... Is, typename... Extra>
+		void						invoke(const Record& record, detail::IndexSequence<Is...>, Extra&&... extra) const;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		const Dispatcher*				mDispatcher;
+		detail::PerThread<Buffer>		mBuffers;
+		std::vector<Record>				mRecords;
+		std::vector<Record>				mScratch;
+};
+
+/// @}
+
+} // namespace aurora
+
+#include <Aurora/Dispatch/Detail/DispatchQueue.inl>
+
+#endif // AURORA_DISPATCHQUEUE_HPP
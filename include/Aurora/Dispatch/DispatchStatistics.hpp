@@ -0,0 +1,373 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Statistics policies for dispatchers
+
+#ifndef AURORA_DISPATCHSTATISTICS_HPP
+#define AURORA_DISPATCHSTATISTICS_HPP
+
+#include <Aurora/Dispatch/Detail/PerThread.hpp>
+#include <Aurora/Tools/Optional.hpp>
+#include <Aurora/Tools/StringKey.hpp>
+#include <Aurora/Config.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+namespace detail
+{
+
+	// Makes keys stored by the statistics independent of the dispatched objects. Keys are stored as they are, except
+	// for StringKey, whose characters are copied.
+	template <typename Key>
+	struct KeyArena
+	{
+		const Key& intern(const Key& key)
+		{
+			return key;
+		}
+	};
+
+	template <>
+	struct KeyArena<StringKey>
+	{
+		// Elements of a deque are never relocated, so the characters of the strings stay in place
+		StringKey intern(const StringKey& key)
+		{
+			strings.emplace_back(key.data(), key.size());
+			return StringKey(strings.back());
+		}
+
+		std::deque<std::string> strings;
+	};
+
+} // namespace detail
+
+/// @brief Statistics collected by a dispatcher, see aurora::DispatchStatistics.
+///
+struct DispatchReport
+{
+	/// @brief Number of buckets in the latency histogram.
+	/// @details Bucket @c i counts the calls that took between 2^i and 2^(i+1) nanoseconds; bucket 0 also counts shorter
+	///  calls, the last bucket also longer ones.
+	static const std::size_t histogramSize = 32u;
+
+	/// @brief Statistics of a single key (or key combination)
+	///
+	struct Entry
+	{
+		std::string											name;		///< Key, as returned by Traits::name()
+		std::uint64_t										calls;		///< Number of calls of the registered function
+		std::uint64_t										misses;		///< Number of calls without registered function
+		std::array<std::uint64_t, histogramSize>			latencies;	///< Histogram of the sampled execution times
+	};
+
+	/// @brief Entries for all keys that have been dispatched, ordered by decreasing number of calls.
+	///
+	std::vector<Entry>										entries;
+};
+
+/// @brief Prints a dispatch report, one line per key.
+/// @details For each key, the number of calls and misses is printed, as well as the non-empty histogram buckets in the
+///  form <tt>lower bound in ns: count</tt>.
+/// @relates DispatchReport
+inline std::ostream& operator<< (std::ostream& stream, const DispatchReport& report)
+{
+	for (const DispatchReport::Entry& entry : report.entries)
+	{
+		stream << entry.name << ": " << entry.calls << " calls, " << entry.misses << " misses";
+
+		for (std::size_t i = 0u; i < DispatchReport::histogramSize; ++i)
+		{
+			if (entry.latencies[i] != 0u)
+				stream << ", " << (std::uint64_t(1u) << i) << "ns: " << entry.latencies[i];
+		}
+
+		stream << '\n';
+	}
+
+	return stream;
+}
+
+/// @brief Statistics policy for dispatchers that records nothing.
+/// @details Default policy. All instrumentation is empty and removed by the compiler; the report is empty.
+struct NoDispatchStatistics
+{
+	template <typename Key, typename Hash>
+	class Recorder
+	{
+		public:
+			struct Measurement
+			{
+				~Measurement()
+				{
+				}
+			};
+
+			Measurement measure(const Key&) const
+			{
+				return Measurement();
+			}
+
+			void miss(const Key&) const
+			{
+			}
+
+			template <typename NameFn>
+			DispatchReport report(NameFn) const
+			{
+				return DispatchReport();
+			}
+	};
+};
+
+/// @brief Statistics policy for dispatchers that records calls, misses and latencies per key.
+/// @details For every key, the dispatcher counts how often a registered function was invoked and how often no function
+///  was found. The execution times of function calls are sampled and stored in a histogram with logarithmic buckets: each
+///  thread measures one call out of about @c latencySampling, at random intervals so that periodic call patterns don't
+///  bias the samples. All other calls only increment a counter.
+///  @n@n Each thread records into its own counters, which are updated without locks; only the first call for a key in a
+///  thread takes a lock. Repeated calls with the same key skip the key lookup. The dispatcher's statistics() method merges the counters of all threads into a DispatchReport.
+///  Copies of a dispatcher (as made by aurora::ConcurrentDispatcher) share their statistics. Keys of type aurora::StringKey
+///  are copied when first recorded, so the dispatched strings need not outlive the dispatcher.
+/// @code
+/// aurora::SingleDispatcher<void(Base&), aurora::RttiDispatchTraits<void(Base&), 1>, aurora::HashStorage,
+///     aurora::DispatchStatistics> dispatcher;
+/// ...
+/// std::cout << dispatcher.statistics();
+/// @endcode
+struct DispatchStatistics
+{
+	/// @brief Average number of calls per thread, of which one has its execution time measured.
+	///
+	static const std::uint32_t latencySampling = 16u;
+
+	template <typename Key, typename Hash>
+	class Recorder
+	{
+		private:
+			struct Counters
+			{
+				Counters()
+				: calls(0u)
+				, misses(0u)
+				, latencies()
+				{
+					for (std::atomic<std::uint64_t>& bucket : latencies)
+						bucket.store(0u, std::memory_order_relaxed);
+				}
+
+				std::atomic<std::uint64_t>		calls;
+				std::atomic<std::uint64_t>		misses;
+				std::atomic<std::uint64_t>		latencies[DispatchReport::histogramSize];
+			};
+
+			// Counters of one thread. Only the owning thread inserts keys, other threads read under the lock.
+			struct Block
+			{
+				Block()
+				: lastKey()
+				, last(nullptr)
+				, random(0x9e3779b9u)
+				, countdown(1u)
+				, counters()
+				, mutex()
+				{
+				}
+
+				Counters& get(const Key& key)
+				{
+					// Map nodes are stable, so the counters of the previous key can be remembered
+					if (last && *lastKey == key)
+						return *last;
+
+					auto itr = counters.find(key);
+					if (itr == counters.end())
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						itr = counters.emplace(std::piecewise_construct, std::forward_as_tuple(keys.intern(key)), std::forward_as_tuple()).first;
+					}
+
+					lastKey = itr->first;
+					last = &itr->second;
+					return *last;
+				}
+
+				// Returns true for one call out of latencySampling on average, with random (xorshift) intervals
+				bool sample()
+				{
+					if (--countdown != 0u)
+						return false;
+
+					random ^= random << 13u;
+					random ^= random >> 17u;
+					random ^= random << 5u;
+					countdown = 1u + random % (2u * latencySampling - 1u);
+
+					return true;
+				}
+
+				Optional<Key>								lastKey;
+				Counters*									last;
+				std::uint32_t								random;
+				std::uint32_t								countdown;
+				std::unordered_map<Key, Counters, Hash>		counters;
+				detail::KeyArena<Key>						keys;
+				mutable std::mutex							mutex;
+			};
+
+			typedef std::chrono::steady_clock Clock;
+
+		public:
+			// Counts a function call on destruction; if sampled, measures its duration from construction to destruction
+			class Measurement
+			{
+				public:
+					Measurement(Counters& counters, bool timed)
+					: mCounters(&counters)
+					, mTimed(timed)
+					, mStart(timed ? Clock::now() : Clock::time_point())
+					{
+					}
+
+					Measurement(Measurement&& source)
+					: mCounters(source.mCounters)
+					, mTimed(source.mTimed)
+					, mStart(source.mStart)
+					{
+						source.mCounters = nullptr;
+					}
+
+					~Measurement()
+					{
+						if (!mCounters)
+							return;
+
+						mCounters->calls.fetch_add(1u, std::memory_order_relaxed);
+						if (!mTimed)
+							return;
+
+						std::uint64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - mStart).count();
+
+						std::size_t bucket = 0u;
+						while (duration >>= 1u)
+							++bucket;
+
+						mCounters->latencies[std::min(bucket, DispatchReport::histogramSize - 1u)].fetch_add(1u, std::memory_order_relaxed);
+					}
+
+				private:
+					Counters*			mCounters;
+					bool				mTimed;
+					Clock::time_point	mStart;
+			};
+
+		public:
+			Recorder()
+			: mBlocks(std::make_shared<detail::PerThread<Block>>())
+			{
+			}
+
+			Measurement measure(const Key& key) const
+			{
+				Block& block = mBlocks->local();
+				return Measurement(block.get(key), block.sample());
+			}
+
+			void miss(const Key& key) const
+			{
+				mBlocks->local().get(key).misses.fetch_add(1u, std::memory_order_relaxed);
+			}
+
+			template <typename NameFn>
+			DispatchReport report(NameFn name) const
+			{
+				// Merge the counters of all threads
+				std::unordered_map<Key, DispatchReport::Entry, Hash> merged;
+
+				mBlocks->forEach([&] (const Block& block)
+				{
+					std::lock_guard<std::mutex> lock(block.mutex);
+
+					for (const auto& pair : block.counters)
+					{
+						auto itr = merged.find(pair.first);
+						if (itr == merged.end())
+						{
+							DispatchReport::Entry entry = { name(pair.first), 0u, 0u, {} };
+							itr = merged.insert(std::make_pair(pair.first, entry)).first;
+						}
+
+						const Counters& counters = pair.second;
+						itr->second.calls += counters.calls.load(std::memory_order_relaxed);
+						itr->second.misses += counters.misses.load(std::memory_order_relaxed);
+
+						for (std::size_t i = 0u; i < DispatchReport::histogramSize; ++i)
+							itr->second.latencies[i] += counters.latencies[i].load(std::memory_order_relaxed);
+					}
+				});
+
+				DispatchReport report;
+				for (auto& pair : merged)
+					report.entries.push_back(std::move(pair.second));
+
+				std::stable_sort(report.entries.begin(), report.entries.end(), [] (const DispatchReport::Entry& lhs, const DispatchReport::Entry& rhs)
+				{
+					return lhs.calls > rhs.calls;
+				});
+
+				return report;
+			}
+
+		private:
+			std::shared_ptr<detail::PerThread<Block>>	mBlocks;
+	};
+};
+
+/// @}
+
+} // namespace aurora
+
+#endif // AURORA_DISPATCHSTATISTICS_HPP
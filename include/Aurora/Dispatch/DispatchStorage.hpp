@@ -0,0 +1,291 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Storage policies for dispatchers
+
+#ifndef AURORA_DISPATCHSTORAGE_HPP
+#define AURORA_DISPATCHSTORAGE_HPP
+
+#include <Aurora/Dispatch/Detail/HashTable.hpp>
+#include <Aurora/Dispatch/Detail/FlatTable.hpp>
+#include <Aurora/Dispatch/Detail/DenseTable.hpp>
+#include <Aurora/Dispatch/Detail/ArrayTable.hpp>
+#include <Aurora/Dispatch/Detail/PerfectHashTable.hpp>
+#include <Aurora/Dispatch/Detail/AdaptiveTable.hpp>
+#include <Aurora/Dispatch/Detail/StringTable.hpp>
+#include <Aurora/Dispatch/Detail/SmallTable.hpp>
+#include <Aurora/Config.hpp>
+
+#include <memory>
+#include <type_traits>
+
+#ifdef AURORA_HAS_CXX17
+	#include <memory_resource>
+#endif
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Storage policy that keeps registered functions in a std::unordered_map.
+/// @details Default storage for dispatchers. Every lookup visits a bucket and a separately allocated node.
+///  @n@n A storage policy is a class with a member alias template <tt>Table<Key, Value, Hash></tt>, which must provide
+///  the following members:
+/// @code
+/// Value*       find(const Key& key);        // nullptr if key is not registered
+/// const Value* find(const Key& key) const;
+/// void         insert(const Key& key, Value value); // overwrites existing entries
+/// std::size_t  size() const;
+/// void         seal();                      // no more insertions follow, may reorganize the table
+/// void         optimize();                  // may reorganize the table according to the lookups so far
+/// @endcode
+struct HashStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::HashTable<Key, Value, Hash>;
+
+	template <typename Key, typename Value, typename Hash, typename Allocator>
+	using AllocatorTable = detail::HashTable<Key, Value, Hash, Allocator>;
+};
+
+/// @brief Storage policy that keeps keys and functions inline in one contiguous open-addressing array.
+/// @details Collisions are resolved by linear probing, and the load factor is kept at 1/2 or below. Compared to
+///  HashStorage, a lookup needs no pointer chasing: the key and its function are stored next to each other. Rehashing
+///  moves the stored functions, which only happens when new functions are registered.
+struct FlatStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::FlatTable<Key, Value, Hash>;
+
+	template <typename Key, typename Value, typename Hash, typename Allocator>
+	using AllocatorTable = detail::FlatTable<Key, Value, Hash, Allocator>;
+};
+
+/// @brief Storage policy that keeps registered functions in an array indexed by the key.
+/// @details Requires keys of integral or enum type, which should be small and dense -- the array is as large as the
+///  greatest key. Lookups involve no hashing and no probing, only a bounds check. This is the default storage for
+///  aurora::DenseDispatchTraits.
+///  @n@n In aurora::DoubleDispatcher, the functions are referenced from a square matrix indexed by both keys. Each cell is a
+///  32-bit index, so the matrix for 64 classes occupies 16 KB.
+struct DenseStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::DenseTable<Key, Value, Hash>;
+};
+
+/// @brief Storage policy that keeps registered functions in a fixed-size array indexed by the key.
+/// @details Like DenseStorage, but the range of keys is known at compile time: keys must be integers or enumerators in
+///  <tt>[0, Size)</tt>. The array is allocated inline and never resized. bind() throws aurora::FunctionCallException for
+///  keys out of range, while lookups perform no bounds checks (except assertions in debug mode). This is the default storage for aurora::EnumDispatchTraits.
+///  @n@n In aurora::DoubleDispatcher, the functions are referenced from a <tt>Size * Size</tt> matrix of 32-bit indices.
+/// @tparam Size Number of keys, i.e. the greatest key plus one.
+template <std::size_t Size>
+struct ArrayStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::ArrayTable<Key, Value, Hash, Size>;
+};
+
+/// @brief Storage policy that computes a minimal perfect hash function once all functions are registered.
+/// @details Intended for dispatchers that are populated at startup and never modified afterwards. After seal() has been
+///  called on the dispatcher, every lookup hashes the key once, computes the slot from a per-bucket displacement, and
+///  compares a single entry -- there are no probe sequences and no empty slots. Before sealing, lookups are linear
+///  searches, so seal() should not be forgotten.
+///  @n@n If different keys have equal hash values, no perfect hash function exists; the table then stays in linear mode.
+///  The same happens in the unlikely case that seal() finds no displacements for several hash functions, so seal()
+///  always terminates.
+struct PerfectHashStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::PerfectHashTable<Key, Value, Hash>;
+};
+
+/// @brief Storage policy for aurora::StringKey keys, which copies the characters of all keys into one contiguous arena.
+/// @details Since aurora::StringKey doesn't own its characters, this policy makes it possible to bind temporary strings.
+///  The table uses open addressing; each slot contains hash value, length and the first 8 characters of its key, so that
+///  different keys are usually told apart without accessing the arena. This is the default storage for
+///  aurora::StringDispatchTraits, and the only policy accepted for aurora::StringKey keys. Only single keys are supported,
+///  i.e. it cannot be used with aurora::DoubleDispatcher.
+struct StringStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::StringTable<Key, Value, Hash>;
+};
+
+/// @brief Storage policy for dispatchers with few functions, which compares all keys at once.
+/// @details As long as at most @c Threshold functions are registered, the 32-bit hash values of the keys are stored in
+///  an array, and a lookup compares the hash value of the searched key with all of them using SIMD instructions (AVX2
+///  or SSE2, depending on AURORA_HAS_AVX2 and AURORA_HAS_SSE2, otherwise a scalar loop). Only keys with equal hash values
+///  are compared with operator==. For small tables, this is faster than hashing into buckets.
+///  @n@n When more functions are registered, all entries are moved to a table of the @c Base policy, which serves all
+///  following lookups. In aurora::DoubleDispatcher, the combined hash value of the key pair is compared.
+/// @tparam Threshold Maximal number of keys in the small array, at most 32.
+/// @tparam Base Storage policy for tables with more keys.
+template <std::size_t Threshold = 16, class Base = HashStorage>
+struct SmallStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::SmallTable<Key, Value, Hash, Base, Threshold>;
+};
+
+/// @brief Storage policy that checks the most frequently dispatched keys first.
+/// @details Suited for skewed distributions, where few keys account for most calls. Lookups are sampled: every few
+///  lookups in a thread increment a hit counter of the found key. When the dispatcher's optimize() method is called, the
+///  @c FrontSize keys with the most hits are promoted to a small array, which is searched linearly before the table of
+///  the @c Base policy. Counters are halved by every optimization, so the promoted keys follow changing distributions.
+///  @n@n Promotion only happens in optimize(), never during a call. Like bind(), optimize() must not be invoked while
+///  other threads call the dispatcher (unless aurora::ConcurrentDispatcher is used).
+/// @tparam FrontSize Maximal number of promoted keys.
+/// @tparam Base Storage policy for the table that contains all keys.
+template <std::size_t FrontSize = 4, class Base = HashStorage>
+struct AdaptiveStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = detail::AdaptiveTable<Key, Value, Hash, Base, FrontSize>;
+};
+
+/// @brief Storage policy that allocates the tables' memory through a custom allocator.
+/// @details Tables of this policy are constructed from an allocator, which is passed to the constructor of the dispatcher
+///  (e.g. <tt>SingleDispatcher(bool, const Allocator&)</tt>). All tables of the dispatcher allocate their nodes and arrays
+///  through it, as do the containers that aurora::SingleDispatcher uses to resolve base classes. Moved dispatchers and
+///  the copies made by aurora::ConcurrentDispatcher keep the allocator. The registered functions themselves are stored
+///  inside aurora::Delegate objects and never allocate, unless @c AURORA_DELEGATE_ALLOW_HEAP is defined. This way,
+///  many short-lived dispatchers can be placed in an arena that is released at once, instead of fragmenting the heap.
+/// @tparam Allocator Default-constructible standard allocator for any value type; it is rebound to the types the tables store.
+/// @tparam Base Underlying policy, HashStorage or FlatStorage. It must provide a member alias template
+///  <tt>AllocatorTable<Key, Value, Hash, Allocator></tt>.
+template <typename Allocator, class Base = HashStorage>
+struct AllocatorStorage
+{
+	template <typename Key, typename Value, typename Hash>
+	using Table = typename Base::template AllocatorTable<Key, Value, Hash, Allocator>;
+};
+
+#ifdef AURORA_HAS_CXX17
+
+/// @brief Storage policy that allocates the tables' memory from a @c std::pmr::memory_resource.
+/// @details Shorthand for aurora::AllocatorStorage with @c std::pmr::polymorphic_allocator. A pointer to the memory resource
+///  can be passed to the dispatcher's constructor directly. Only available with C++17.
+/// @code
+/// std::pmr::monotonic_buffer_resource arena;
+/// aurora::SingleDispatcher<void(Base&), aurora::RttiDispatchTraits<void(Base&), 1>, aurora::PmrStorage<>> dispatcher(false, &arena);
+/// @endcode
+/// @tparam Base Underlying policy, HashStorage or FlatStorage.
+template <class Base = HashStorage>
+using PmrStorage = AllocatorStorage<std::pmr::polymorphic_allocator<char>, Base>;
+
+#endif // AURORA_HAS_CXX17
+
+/// @}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
+
+namespace detail
+{
+
+	template <typename T>
+	struct VoidType
+	{
+		typedef void type;
+	};
+
+	// Default storage of a dispatcher: Traits::Storage if present, HashStorage otherwise
+	template <typename Traits, typename Enable = void>
+	struct TraitsStorage
+	{
+		typedef HashStorage Type;
+	};
+
+	template <typename Traits>
+	struct TraitsStorage<Traits, typename VoidType<typename Traits::Storage>::type>
+	{
+		typedef typename Traits::Storage Type;
+	};
+
+	// Storage for the composite (array) keys of MultiDispatcher: policies that index by single keys fall back to HashStorage
+	template <typename Storage>
+	struct CompositeStorage
+	{
+		typedef Storage Type;
+	};
+
+	template <>
+	struct CompositeStorage<DenseStorage>
+	{
+		typedef HashStorage Type;
+	};
+
+	template <std::size_t Size>
+	struct CompositeStorage<ArrayStorage<Size>>
+	{
+		typedef HashStorage Type;
+	};
+
+	// Allocator for a dispatcher's other containers of T, so that they use the same memory as the tables of Storage
+	template <typename Storage, typename T>
+	struct StorageAllocator
+	{
+		typedef std::allocator<T> Type;
+	};
+
+	template <typename Allocator, class Base, typename T>
+	struct StorageAllocator<AllocatorStorage<Allocator, Base>, T>
+	{
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<T> Type;
+	};
+
+	// Whether tables of Storage keep their keys valid. StringKey doesn't own its characters, so only StringStorage (which
+	// copies them) can hold it.
+	template <typename Key, typename Storage>
+	struct OwnsKeys : std::true_type
+	{
+	};
+
+	template <typename Storage>
+	struct OwnsKeys<StringKey, Storage> : std::false_type
+	{
+	};
+
+	template <>
+	struct OwnsKeys<StringKey, StringStorage> : std::true_type
+	{
+	};
+
+	// Default storage of MultiDispatcher
+	template <typename Traits>
+	struct CompositeTraitsStorage
+	{
+		typedef typename CompositeStorage<typename TraitsStorage<Traits>::Type>::Type Type;
+	};
+
+} // namespace detail
+} // namespace aurora
+
+#endif // AURORA_DISPATCHSTORAGE_HPP
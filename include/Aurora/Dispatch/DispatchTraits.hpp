@@ -29,17 +29,32 @@
 /// @file
 /// @brief Class template aurora::DispatchTraits
 
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Tools/Delegate.hpp>
+#include <Aurora/Tools/Optional.hpp>
+#include <Aurora/Tools/StringKey.hpp>
 #include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Meta/Variadic.hpp>
 #include <Aurora/Config.hpp>
 
 #include <typeindex>
-#include <functional>
+#include <string>
+#include <atomic>
+
+#ifdef AURORA_HAS_CXX17
+	#include <variant>
+#endif
 
 
 namespace aurora
 {
 namespace detail
 {
+	// Selects the private copy constructors of dispatchers, which are only used to clone them
+	struct CloneTag
+	{
+	};
+
 	// Type-information for dereferenced type
 	// Important: Do not const-qualify parameters, or the first overload will accept const U*
 	template <typename T>
@@ -54,6 +69,255 @@ namespace detail
 		return typeid(*pointer);
 	}
 
+
+	// Dereferences pointers, passes references through
+	template <typename T>
+	T& deref(T& reference)
+	{
+		return reference;
+	}
+
+	template <typename T>
+	T& deref(T* pointer)
+	{
+		return *pointer;
+	}
+
+
+	// Converts a pointer or reference to the dispatcher's parameter type (pointer or reference)
+	template <typename Parameter, typename T>
+	Parameter toParameter(T&& element, std::true_type /*isPointer*/)
+	{
+		return &deref(element);
+	}
+
+	template <typename Parameter, typename T>
+	Parameter toParameter(T&& element, std::false_type /*isPointer*/)
+	{
+		return deref(element);
+	}
+
+	template <typename Parameter, typename T>
+	Parameter toParameter(T&& element)
+	{
+		return toParameter<Parameter>(std::forward<T>(element), std::is_pointer<Parameter>());
+	}
+
+
+	// Assigns consecutive IDs to the classes of a family
+	template <typename Family>
+	std::size_t nextDenseTypeId()
+	{
+		static std::atomic<std::size_t> counter(0u);
+		return counter++;
+	}
+
+	template <typename Family, typename T>
+	struct DenseTypeId
+	{
+		static std::size_t get()
+		{
+			static const std::size_t id = nextDenseTypeId<Family>();
+			return id;
+		}
+	};
+
+
+	// Casts an argument to the class identified by Id; arguments without identifier (EmptyType) are passed unchanged
+	template <typename B, typename Id>
+	struct DowncastArgument
+	{
+		typedef AURORA_REPLICATE(B, typename Id::type) Derived;
+
+		static Derived apply(B arg)
+		{
+			return static_cast<Derived>(arg);
+		}
+	};
+
+	template <typename B>
+	struct DowncastArgument<B, EmptyType>
+	{
+		template <typename T>
+		static T&& apply(T&& arg)
+		{
+			return std::forward<T>(arg);
+		}
+	};
+
+
+	// Function object that downcasts the first sizeof...(Ids) arguments and passes all arguments to the function
+	template <typename R, typename B, typename Fn, typename... Ids>
+	class DowncastInvoker
+	{
+		public:
+			explicit DowncastInvoker(Fn function)
+			: mFunction(std::move(function))
+			{
+			}
+
+			template <typename... Args>
+			R operator() (Args&&... args)
+			{
+				return invoke(MakeIndexSequence<sizeof...(Args)>(), std::forward<Args>(args)...);
+			}
+
+		private:
+			template <std::size_t... Is, typename... Args>
+			R invoke(IndexSequence<Is...>, Args&&... args)
+			{
+				return mFunction(DowncastArgument<B, typename NthType<Is, Ids...>::Type>::apply(std::forward<Args>(args))...);
+			}
+
+		private:
+			Fn mFunction;
+	};
+
+
+	// Trampolines that downcast the dispatched arguments from the base class to the registered derived classes.
+	// Further arguments are perfectly forwarded, so that arguments passed by value or rvalue reference are not copied.
+	template <typename S, std::size_t N>
+	class DowncastTraits
+	{
+		private:
+			typedef typename FunctionResult<S>::Type R;
+			typedef typename FunctionParam<S, 0>::Type B;
+
+			static_assert(std::is_polymorphic<typename std::remove_pointer<typename std::remove_reference<B>::type>::type>::value,
+				"B must be a pointer or reference to a polymorphic base class.");
+
+		public:
+			// Wraps a function such that the argument is downcast before being passed
+			template <typename Id, typename Fn>
+			static Delegate<S> trampoline1(Fn f)
+			{
+				return DowncastInvoker<R, B, Fn, Id>(std::move(f));
+			}
+
+			// Wraps a function such that both arguments are downcast before being passed
+			template <typename Id1, typename Id2, typename Fn>
+			static Delegate<S> trampoline2(Fn f)
+			{
+				return DowncastInvoker<R, B, Fn, Id1, Id2>(std::move(f));
+			}
+
+			// Wraps a function such that the first sizeof...(Ids) arguments are downcast before being passed
+			template <typename... Ids, typename Fn>
+			static Delegate<S> trampolineN(Fn f)
+			{
+				return DowncastInvoker<R, B, Fn, Ids...>(std::move(f));
+			}
+	};
+
+
+#ifdef AURORA_HAS_CXX17
+
+	// Index of alternative T in the std::variant V
+	template <typename T, typename V>
+	struct VariantIndex;
+
+	template <typename T, typename... Ts>
+	struct VariantIndex<T, std::variant<Ts...>> : IndexOfType<T, Ts...>
+	{
+	};
+
+
+	// Accesses the alternative identified by Id in a variant reference or pointer; arguments without identifier are passed unchanged
+	template <typename Id>
+	struct VariantArgument
+	{
+		typedef typename Id::type T;
+
+		template <typename V>
+		static auto apply(V& variant) -> decltype(*std::get_if<T>(&variant))
+		{
+			return *std::get_if<T>(&variant);
+		}
+
+		template <typename V>
+		static auto apply(V* variant) -> decltype(std::get_if<T>(variant))
+		{
+			return std::get_if<T>(variant);
+		}
+	};
+
+	template <>
+	struct VariantArgument<EmptyType>
+	{
+		template <typename T>
+		static T&& apply(T&& arg)
+		{
+			return std::forward<T>(arg);
+		}
+	};
+
+
+	// Function object that passes the alternatives of the first sizeof...(Ids) arguments and forwards all others
+	template <typename Fn, typename... Ids>
+	class VariantInvoker
+	{
+		public:
+			explicit VariantInvoker(Fn function)
+			: mFunction(std::move(function))
+			{
+			}
+
+			template <typename... Args>
+			decltype(auto) operator() (Args&&... args)
+			{
+				return invoke(MakeIndexSequence<sizeof...(Args)>(), std::forward<Args>(args)...);
+			}
+
+		private:
+			template <std::size_t... Is, typename... Args>
+			decltype(auto) invoke(IndexSequence<Is...>, Args&&... args)
+			{
+				return mFunction(VariantArgument<typename NthType<Is, Ids...>::Type>::apply(std::forward<Args>(args))...);
+			}
+
+		private:
+			Fn mFunction;
+	};
+
+#endif // AURORA_HAS_CXX17
+
+
+	// Result of tryCall(): Optional<R>, or bool if R is void
+	template <typename R>
+	struct TryCall
+	{
+		typedef Optional<R> Type;
+
+		template <typename Fn, typename... Args>
+		static Type invoke(const Fn& function, Args&&... args)
+		{
+			return Type(function(std::forward<Args>(args)...));
+		}
+
+		static Type miss()
+		{
+			return Type();
+		}
+	};
+
+	template <>
+	struct TryCall<void>
+	{
+		typedef bool Type;
+
+		template <typename Fn, typename... Args>
+		static Type invoke(const Fn& function, Args&&... args)
+		{
+			function(std::forward<Args>(args)...);
+			return true;
+		}
+
+		static Type miss()
+		{
+			return false;
+		}
+	};
+
 } // namespace detail
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -97,6 +361,14 @@ struct DispatchTraits
 		return f;
 	}
 
+	/// @brief Maps a function to itself (no trampoline needed)
+	///
+	template <typename... UnusedIds, typename Fn>
+	static Fn trampolineN(Fn f)
+	{
+		return f;
+	}
+
 	/// @brief Returns a string representation of the key, for debugging
 	///
 	static const char* name(Key)
@@ -105,21 +377,90 @@ struct DispatchTraits
 	}
 };
 
+/// @brief Helper base class to implement traits for dispatchers with enum keys
+/// @details Like aurora::DispatchTraits<E>, but the dispatchers store their functions in an array indexed by the enumerator
+///  (see aurora::ArrayStorage), so that lookups involve no hashing. The enumerators must lie in the range <tt>[0, Max]</tt>.
+///  You have to define keyFromBase() in a derived class:
+/// @code
+/// enum class CommandType { Move, Attack, Stop };
+/// struct Command { CommandType type; };
+///
+/// struct CommandTraits : aurora::EnumDispatchTraits<CommandType, CommandType::Stop>
+/// {
+///     static CommandType keyFromBase(const Command& c) { return c.type; }
+/// };
+///
+/// aurora::SingleDispatcher<void(const Command&), CommandTraits> dispatcher;
+/// dispatcher.bind(CommandType::Move, &move);
+/// @endcode
+/// @tparam E The enum type that identifies the objects to dispatch.
+/// @tparam Max The greatest enumerator in use.
+template <typename E, E Max>
+struct EnumDispatchTraits : DispatchTraits<E>
+{
+	static_assert(std::is_enum<E>::value, "E must be an enum type.");
+
+	/// @brief Storage policy used by default for dispatchers with these traits.
+	///
+	typedef ArrayStorage<static_cast<std::size_t>(Max) + 1u> Storage;
+
+	/// @brief Returns a string representation of the key, for debugging
+	///
+	static std::string name(E k)
+	{
+		return std::to_string(static_cast<long long>(k));
+	}
+};
+
+/// @brief Traits for dispatchers with string keys
+/// @details Objects are dispatched by strings, represented as aurora::StringKey. The dispatched parameter of @c S can be
+///  <tt>const char*</tt>, <tt>const std::string&</tt> or (in C++17) <tt>const std::string_view&</tt>, and bind() accepts any
+///  of these as well as string literals. call() computes the hash value of its argument once and allocates no memory.
+///  Registered keys are copied into the table of aurora::StringStorage, which is the only storage policy accepted for
+///  string keys. aurora::DispatchStatistics copies the keys it records as well. Only aurora::SingleDispatcher supports
+///  these traits.
+/// @code
+/// aurora::SingleDispatcher<void(const char*), aurora::StringDispatchTraits<void(const char*)>> dispatcher;
+/// dispatcher.bind("quit", [] (const char*) { quit(); });
+/// dispatcher.call(command);
+/// @endcode
+/// @tparam S Function signature of the dispatcher.
+template <typename S>
+struct StringDispatchTraits : DispatchTraits<StringKey>
+{
+	private:
+		typedef typename FunctionParam<S, 0>::Type B;
+
+	public:
+		/// @brief Storage policy used by default for dispatchers with these traits.
+		///
+		typedef StringStorage Storage;
+
+		/// @brief Function that takes the dispatched string and returns a key referring to its characters.
+		///
+		static StringKey keyFromBase(B string)
+		{
+			return StringKey(string);
+		}
+
+		/// @brief Returns a string representation of the key, for debugging
+		///
+		static std::string name(const StringKey& k)
+		{
+			return k.str();
+		}
+};
+
 /// @brief Identifies a class using RTTI.
 /// @details Default key for SingleDispatcher and DoubleDispatcher. With it, classes are identified using the compiler's
 ///  RTTI capabilities (in particular, the @c typeid operator).
 template <typename S, std::size_t N>
-class RttiDispatchTraits
+class RttiDispatchTraits : public detail::DowncastTraits<S, N>
 {
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Private types
 	private:
-		typedef typename FunctionResult<S>::Type R;
 		typedef typename FunctionParam<S, 0>::Type B;
-		typedef typename FunctionParam<S, N>::Type U;
-
-		static_assert(std::is_polymorphic<typename std::remove_pointer<typename std::remove_reference<B>::type>::type>::value,
-			"B must be a pointer or reference to a polymorphic base class.");
 
 
 	// ---------------------------------------------------------------------------------------------------------------------------
@@ -145,120 +486,209 @@ class RttiDispatchTraits
 			return typeid(T);
 		}
 
-		/// @brief Wraps a function such that the argument is downcast before being passed
+		/// @brief Returns a string representation of the key, for debugging
 		///
-		template <typename Id, typename Fn>
-		static std::function<S> trampoline1(Fn f)
+		static const char* name(Key k)
 		{
-			return trampoline1<Id, Fn>(f, Int<FunctionArity<S>::value - N>());
+			return k.name();
 		}
+};
 
-		/// @brief Wraps a function such that both arguments are downcast before being passed
+/// @brief Returns a dense integer that identifies the class @c T within the class hierarchy @c Family.
+/// @details The first class of a family that is passed to this function receives the ID 0, the next one 1, and so on.
+///  IDs are thus suited as indices into arrays. Const qualifiers are ignored. The function is thread-safe.
+/// @tparam Family Any type that denotes a group of classes, usually their common base class.
+/// @tparam T Class to identify.
+/// @see DenseDispatchTraits
+template <typename Family, typename T>
+std::size_t denseTypeId()
+{
+	return detail::DenseTypeId<typename detail::RawType<Family>::type, typename detail::RawType<T>::type>::get();
+}
+
+/// @brief Identifies a class using a dense integer ID, provided by a virtual member function.
+/// @details Instead of RTTI, the base class @c B declares a virtual function <b>std::size_t typeId() const</b>, which every
+///  derived class overrides to return aurora::denseTypeId<B, Derived>(). Since the keys are small integers, dispatchers using
+///  these traits store their functions in an array indexed by the key (see aurora::DenseStorage), so that dispatching
+///  amounts to a virtual call, an array access and the indirect call of the function.
+/// @code
+/// class Base
+/// {
+///     public:
+///         virtual ~Base() {}
+///         virtual std::size_t typeId() const = 0;
+/// };
+///
+/// class Derived : public Base
+/// {
+///     public:
+///         virtual std::size_t typeId() const
+///         {
+///             return aurora::denseTypeId<Base, Derived>();
+///         }
+/// };
+///
+/// aurora::SingleDispatcher<void(Base&), aurora::DenseDispatchTraits<void(Base&), 1>> dispatcher;
+/// @endcode
+template <typename S, std::size_t N>
+class DenseDispatchTraits : public detail::DowncastTraits<S, N>
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		typedef typename FunctionParam<S, 0>::Type B;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public types and static member functions
+	public:
+		/// @brief Key type.
 		///
-		template <typename Id1, typename Id2, typename Fn>
-		static std::function<S> trampoline2(Fn f)
+		typedef std::size_t Key;
+
+		/// @brief Storage policy used by default for dispatchers with these traits.
+		///
+		typedef DenseStorage Storage;
+
+		/// @brief Function that takes an object to identify and returns its dense ID.
+		///
+		static Key keyFromBase(B m)
 		{
-			return trampoline2<Id1, Id2, Fn>(f, Int<FunctionArity<S>::value - N>());
+			return detail::deref(m).typeId();
 		}
 
-		/// @brief Returns a string representation of the key, for debugging
+		/// @brief Function that takes static type information and returns the dense ID.
 		///
-		static const char* name(Key k)
+		template <typename T>
+		static Key keyFromId(Type<T> id)
 		{
-			return k.name();
+			static_cast<void>(id); // unused parameter
+			return denseTypeId<B, T>();
 		}
 
+		/// @brief Returns a string representation of the key, for debugging
+		///
+		static std::string name(Key k)
+		{
+			return std::to_string(static_cast<unsigned long long>(k));
+		}
+};
 
+#ifdef AURORA_HAS_CXX17
+
+/// @brief Identifies the alternatives of a @c std::variant by their index.
+/// @details For closed sets of types, objects can be stored in a @c std::variant instead of a class hierarchy. With these
+///  traits, functions are still registered for each type using bind(aurora::Type<T>(), function), and receive a reference
+///  (or pointer, according to the dispatcher's signature) to the alternative of type @c T. The key is <tt>V::index()</tt>,
+///  and the functions are stored in an array with one element per alternative (see aurora::ArrayStorage), so that neither
+///  RTTI, nor hashing, nor virtual functions are involved. Variants that are valueless by exception have no function and
+///  are passed to the fallback function. Only available with C++17.
+/// @code
+/// struct Circle { float radius; };
+/// struct Rect { float width, height; };
+/// typedef std::variant<Circle, Rect> Shape;
+///
+/// aurora::SingleDispatcher<float(const Shape&), aurora::VariantDispatchTraits<Shape>> area;
+/// area.bind(aurora::Type<Circle>(), [] (const Circle& c) { return 3.14159f * c.radius * c.radius; });
+/// area.bind(aurora::Type<Rect>(), [] (const Rect& r) { return r.width * r.height; });
+///
+/// float a = area.call(shape);
+/// @endcode
+/// @tparam V The @c std::variant type. Its alternatives must be distinct types.
+template <typename V>
+class VariantDispatchTraits
+{
 	// ---------------------------------------------------------------------------------------------------------------------------
-	// Private types and static member functions
+	// Private types
 	private:
-		// Implementation for signature without additional argument
-		template <typename Id, typename Fn>
-		static std::function<S> trampoline1(Fn f, Int<0>)
+		static constexpr std::size_t Size = std::variant_size<V>::value;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public types and static member functions
+	public:
+		/// @brief Key type: the index of the alternative.
+		///
+		typedef std::size_t Key;
+
+		/// @brief Storage policy used by default for dispatchers with these traits; the last element is reserved for valueless variants.
+		///
+		typedef ArrayStorage<Size + 1u> Storage;
+
+		/// @brief Function that takes a variant and returns the index of its alternative.
+		///
+		static Key keyFromBase(const V& variant)
 		{
-			return [f] (B arg) mutable -> R
-			{
-				typedef AURORA_REPLICATE(B, typename Id::type) Derived;
-				return f(static_cast<Derived>(arg));
-			};
+			return variant.valueless_by_exception() ? Size : variant.index();
+		}
+
+		/// @brief Function that takes a pointer to a variant and returns the index of its alternative.
+		///
+		static Key keyFromBase(const V* variant)
+		{
+			return keyFromBase(*variant);
+		}
+
+		/// @brief Function that takes static type information and returns the index of the alternative @c T.
+		///
+		template <typename T>
+		static Key keyFromId(Type<T> id)
+		{
+			static_cast<void>(id); // unused parameter
+			return detail::VariantIndex<T, V>::value;
 		}
 
-		// Implementation for signature with a user-defined argument
+		/// @brief Wraps a function such that it receives the alternative instead of the variant
+		///
 		template <typename Id, typename Fn>
-		static std::function<S> trampoline1(Fn f, Int<1>)
+		static detail::VariantInvoker<Fn, Id> trampoline1(Fn f)
 		{
-			return [f] (B arg, U userData) mutable -> R
-			{
-				typedef AURORA_REPLICATE(B, typename Id::type) Derived;
-				return f(static_cast<Derived>(arg), userData);
-			};
+			return detail::VariantInvoker<Fn, Id>(std::move(f));
 		}
 
-		// Implementation for signature without additional argument
+		/// @brief Wraps a function such that it receives the alternatives of both variants
+		///
 		template <typename Id1, typename Id2, typename Fn>
-		static std::function<S> trampoline2(Fn f, Int<0>)
+		static detail::VariantInvoker<Fn, Id1, Id2> trampoline2(Fn f)
 		{
-			return [f] (B arg1, B arg2) mutable -> R
-			{
-				typedef AURORA_REPLICATE(B, typename Id1::type) Derived1;
-				typedef AURORA_REPLICATE(B, typename Id2::type) Derived2;
-				return f(static_cast<Derived1>(arg1), static_cast<Derived2>(arg2));
-			};
+			return detail::VariantInvoker<Fn, Id1, Id2>(std::move(f));
 		}
 
-		// Implementation for signature with a user-defined argument
-		template <typename Id1, typename Id2, typename Fn>
-		static std::function<S> trampoline2(Fn f, Int<1>)
+		/// @brief Wraps a function such that it receives the alternatives of the first sizeof...(Ids) variants
+		///
+		template <typename... Ids, typename Fn>
+		static detail::VariantInvoker<Fn, Ids...> trampolineN(Fn f)
 		{
-			return [f] (B arg1, B arg2, U userData) mutable -> R
-			{
-				typedef AURORA_REPLICATE(B, typename Id1::type) Derived1;
-				typedef AURORA_REPLICATE(B, typename Id2::type) Derived2;
-				return f(static_cast<Derived1>(arg1), static_cast<Derived2>(arg2), userData);
-			};
+			return detail::VariantInvoker<Fn, Ids...>(std::move(f));
+		}
+
+		/// @brief Returns a string representation of the key, for debugging
+		///
+		static std::string name(Key k)
+		{
+			return (k == Size) ? std::string("valueless") : "alternative " + std::to_string(static_cast<unsigned long long>(k));
 		}
 };
 
+#endif // AURORA_HAS_CXX17
+
 /// @brief Functor doing nothing
 /// @tparam R Return type
 /// @tparam N Arity (number of arguments)
-/// @details Can be used as a fallback function for the dynamic dispatchers. The functor returns a
-///  default-constructed object of type R, or nothing if R is void.
+/// @details Can be used as a fallback function for the dynamic dispatchers. The functor accepts exactly @c N arguments
+///  of any type and returns a default-constructed object of type R, or nothing if R is void.
 template <typename R, unsigned int N>
 struct NoOp
 {
-};
-
-/// @}
-
-template <typename R>
-struct NoOp<R, 0>
-{
-	R operator() () const
-	{
-		return R();
-	}
-};
-
-template <typename R>
-struct NoOp<R, 1>
-{
-	template <typename T1>
-	R operator() (const T1&) const
+	template <typename... Ts>
+	R operator() (Ts&&...) const
 	{
+		static_assert(sizeof...(Ts) == N, "NoOp<R, N> must be invoked with N arguments.");
 		return R();
 	}
 };
 
-template <typename R>
-struct NoOp<R, 2>
-{
-	template <typename T1, typename T2>
-	R operator() (const T1&, const T2&) const
-	{
-		return R();
-	}
-};
+/// @}
 
 } // namespace aurora
 
@@ -30,15 +30,25 @@
 #define AURORA_DOUBLEDISPATCHER_HPP
 
 #include <Aurora/Dispatch/DispatchTraits.hpp>
-#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Dispatch/DispatchStatistics.hpp>
+#include <Aurora/Dispatch/Detail/BatchScratch.hpp>
 #include <Aurora/Tools/Exceptions.hpp>
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Tools/Delegate.hpp>
 #include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Tools/Optional.hpp>
 #include <Aurora/Meta/Templates.hpp>
 #include <Aurora/Config.hpp>
 
-#include <unordered_map>
 #include <functional>
+#include <utility>
 #include <algorithm>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include <cassert>
 
 
@@ -84,13 +94,23 @@ namespace aurora
 ///	    // R(B, B) signature. It therefore acts as a wrapper for user-defined functions which can link different signatures together.
 ///	    // For example, this is the place to insert downcasts.
 ///	    // The first two template parameters Id1 and Id2 are required, as they will be explicitly specified when trampoline2() is called.
+///	    // The returned function object is stored in an aurora::Delegate. It must fit into AURORA_DELEGATE_CAPACITY, unless
+///	    // AURORA_DELEGATE_ALLOW_HEAP is defined, in which case larger function objects are allocated on the heap.
 ///	    template <typename Id1, typename Id2, typename Fn>
-///	    static std::function<R(B, B)> trampoline2(Fn f);
+///	    static aurora::Delegate<R(B, B)> trampoline2(Fn f);
 ///
 ///	    // Optional function that returns a string representation of key for debugging.
 ///	    static const char* name(Key k);
+///
+///	    // Optional storage policy that is used if the dispatcher's Storage parameter is not specified.
+///	    typedef S Storage;
 /// };
 /// @endcode
+/// @tparam Storage Policy that determines how the registered functions are stored. The table is indexed by pairs of keys.
+///  By default, @c Traits::Storage is used if it exists, and aurora::HashStorage otherwise. With aurora::DenseDispatchTraits,
+///  the functions are referenced from a matrix indexed by both keys (see aurora::DenseStorage).
+/// @tparam Statistics Policy that determines whether calls are recorded: aurora::NoDispatchStatistics (default) records
+///  nothing and has no overhead, aurora::DispatchStatistics counts calls and misses and measures latencies per key.
 ///
 /// Usage example:
 /// @code
@@ -115,7 +135,8 @@ namespace aurora
 /// dispatcher.call(ptr, ptr); // Invokes void func11(Derived1* lhs, Derived1* rhs);
 /// delete ptr;
 /// @endcode
-template <typename Signature, class Traits = RttiDispatchTraits<Signature, 2>>
+template <typename Signature, class Traits = RttiDispatchTraits<Signature, 2>, class Storage = typename detail::TraitsStorage<Traits>::Type,
+	class Statistics = NoDispatchStatistics>
 class DoubleDispatcher : private NonCopyable
 {
 	// ---------------------------------------------------------------------------------------------------------------------------
@@ -129,10 +150,18 @@ class DoubleDispatcher : private NonCopyable
 		///
 		typedef typename FunctionParam<Signature, 0>::Type		Parameter;
 
-		/// @brief Addition parameter for user data, only useful if @c Signature contains more than 2 parameters
+		/// @brief First additional parameter for user data, only useful if @c Signature contains more than 2 parameters
 		///
 		typedef typename FunctionParam<Signature, 2>::Type		UserData;
 
+		/// @brief Return type of tryCall(): <tt>aurora::Optional<Result></tt>, or @c bool if @c Result is @c void
+		///
+		typedef typename detail::TryCall<Result>::Type			TryResult;
+
+		/// @brief Traits class that computes the keys of dispatched objects
+		///
+		typedef Traits											KeyTraits;
+
 
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Static assertions
@@ -145,6 +174,10 @@ class DoubleDispatcher : private NonCopyable
 	static_assert(std::is_same<typename FunctionParam<Signature, 0>::Type, typename FunctionParam<Signature, 1>::Type>::value,
 		"The two function parameters must have the same type.");
 
+	// Key combinations are stored by tables that don't copy the characters of non-owning string keys
+	static_assert(!std::is_same<typename Traits::Key, StringKey>::value,
+		"aurora::StringKey keys are only supported by SingleDispatcher.");
+
 
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Public member functions
@@ -155,6 +188,14 @@ class DoubleDispatcher : private NonCopyable
 		///  to different functions.
 		explicit					DoubleDispatcher(bool symmetric = true);
 
+		/// @brief Constructor with allocator
+		/// @details Requires a storage policy whose tables can be constructed from @c allocator, such as aurora::AllocatorStorage
+		///  or aurora::PmrStorage. All tables of the dispatcher then allocate their memory through @c allocator.
+		/// @param symmetric See DoubleDispatcher(bool).
+		/// @param allocator Allocator, or (for aurora::PmrStorage) pointer to a @c std::pmr::memory_resource.
+		template <typename Allocator>
+									DoubleDispatcher(bool symmetric, const Allocator& allocator);
+
 		/// @brief Move constructor
 									DoubleDispatcher(DoubleDispatcher&& source);
 
@@ -172,8 +213,9 @@ class DoubleDispatcher : private NonCopyable
 		///  from each identifier through Traits::keyFromId(identifier).
 		/// @param function Function to register and associate with the given identifier. Usually, the function has the signature
 		///  <tt>Result(Parameter, Parameter)</tt>, but it's possible to deviate from it (e.g. using derived classes), see also the
-		///  note about trampolines in the Traits classes. In case you specified a third parameter for the @c Signature template
-		///  parameter, the function should have the signature <tt>Result(Parameter, Parameter, UserData)</tt>.
+		///  note about trampolines in the Traits classes. In case you specified further parameters for the @c Signature template
+		///  parameter, the function should accept them after the first two, e.g. <tt>Result(Parameter, Parameter, UserData)</tt>.
+		/// @throw FunctionCallException if the dispatcher has been sealed.
 		template <typename Id1, typename Id2, typename Fn>
 		void						bind(const Id1& identifier1, const Id2& identifier2, Fn function);
 
@@ -185,23 +227,63 @@ class DoubleDispatcher : private NonCopyable
 		///  correct parameters in the registered functions, even if the order is different. When necessary, they are swapped.
 		///  In other words, symmetric dispatchers don't care about the order of the arguments at all.
 		/// @param arg1,arg2 Function arguments as references or pointers.
+		/// @param args Additional user arguments, one for each further parameter in @c Signature. They are perfectly forwarded
+		///  to the function and are never swapped.
 		/// @return The return value of the dispatched function, if any.
 		/// @throw FunctionCallException when no corresponding function is found and no fallback has been registered.
-		Result						call(Parameter arg1, Parameter arg2) const;
+		template <typename... Args>
+		Result						call(Parameter arg1, Parameter arg2, Args&&... args) const;
 
-		/// @brief Invokes the function depending on @c arg1 and @c arg2 and passes a user-defined argument @c data
-		/// @details <tt>Traits::keyFromBase(arg)</tt> is invoked to determine the key of the passed argument. The function bound to
-		///  that key is then looked up in the map and invoked. If no match is found and a fallback function has been registered
-		///  using fallback(), then the fallback function will be invoked.
-		///  @n@n When the dispatcher is configured in symmetric mode (see constructor), then the arguments are forwarded to the
-		///  correct parameters in the registered functions, even if the order is different. When necessary, they are swapped.
-		///  In other words, symmetric dispatchers don't care about the order of the first two arguments.
-		///  @n@n This method is only enabled if the @c Signature template parameter contains 3 parameters.
+		/// @brief Invokes the function registered for @c arg1 and @c arg2, if any
+		/// @details Like call(), but a missing function is reported through the return value: there is no exception, no
+		///  memory allocation and no call to Traits::name(). The fallback function is not invoked.
 		/// @param arg1,arg2 Function arguments as references or pointers.
-		/// @param data An additional user argument that is forwarded to the function.
-		/// @return The return value of the dispatched function, if any.
-		/// @throw FunctionCallException when no corresponding function is found and no fallback has been registered.
-		Result						call(Parameter arg1, Parameter arg2, UserData data) const;
+		/// @param args Additional user arguments, forwarded like in call().
+		/// @return The return value of the dispatched function wrapped in aurora::Optional, or an empty optional if no
+		///  function is registered. If @c Result is @c void, the return type is @c bool, denoting whether a function was invoked.
+		template <typename... Args>
+		TryResult					tryCall(Parameter arg1, Parameter arg2, Args&&... args) const;
+
+		/// @brief Checks whether a function is registered for a specific combination of keys
+		/// @param identifier1,identifier2 Values that identify the objects, as in bind(). In symmetric mode, the order
+		///  does not matter.
+		/// @return True if bind() has been called with these identifiers.
+		template <typename Id1, typename Id2>
+		bool						contains(const Id1& identifier1, const Id2& identifier2) const;
+
+		/// @brief Dispatches every pair of objects in the range [first, last), grouped by the invoked function
+		/// @details Like SingleDispatcher::callBatch(), for pairs: the keys of all pairs are computed and brought into
+		///  symmetric order first, consecutive pairs with equal keys sharing one lookup. The pairs are then sorted by
+		///  their function using a stable counting sort, and each function is invoked on its pairs in a row. Arguments are
+		///  swapped per pair as in call(), so that each function receives the objects in the order of its parameters.
+		///  @n@n Return values are discarded. Pairs with unregistered keys are passed to the fallback function; if there is
+		///  none, an exception is thrown before any function is invoked.
+		///  @n@n The sorting buffers are kept per thread and reused, so repeated batches do not allocate memory once the
+		///  buffers have reached the batch size.
+		/// @tparam Itr Forward iterator. The elements provide the members @c first and @c second (such as std::pair), which
+		///  are pointers or references to objects; they are dereferenced or their address is taken to match @c Parameter.
+		/// @param args Additional user arguments, one for each further parameter in @c Signature. Since they are shared by
+		///  all function calls, they are passed as lvalues and never moved from, so @c Signature must not contain rvalue
+		///  reference parameters. They are never swapped.
+		/// @throw FunctionCallException when a pair of keys is not registered and no fallback has been registered.
+		template <typename Itr, typename... Args>
+		void						callPairs(Itr first, Itr last, Args&&... args) const;
+
+		/// @brief Returns the statistics recorded by all threads so far.
+		/// @details The report is only filled if the @c Statistics template parameter is aurora::DispatchStatistics. It
+		///  contains the calls and misses of call(), tryCall() and callPairs(); keys are labeled using Traits::name().
+		DispatchReport				statistics() const;
+
+		/// @brief Declares that no more functions will be registered.
+		/// @details Gives the storage policy the opportunity to reorganize its table for faster lookups; for example,
+		///  aurora::PerfectHashStorage computes a perfect hash function. After this call, bind() throws an exception.
+		///  The fallback function can still be changed.
+		void						seal();
+
+		/// @brief Reorganizes the table according to the calls so far.
+		/// @details Only has an effect with adaptive storage policies such as aurora::AdaptiveStorage, which move the most
+		///  frequently called keys to the front. Can be called periodically, but not while other threads call the dispatcher.
+		void						optimize();
 
 		/// @brief Registers a fallback function.
 		/// @details The passed function will be invoked when call() doesn't find a registered function. It can be used when
@@ -214,39 +296,64 @@ class DoubleDispatcher : private NonCopyable
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Private types
 	private:
-		typedef typename Traits::Key					SingleKey;
-		typedef std::function<Signature>				BaseFunction;
+		typedef typename Traits::Key									SingleKey;
+		typedef Delegate<Signature>										BaseFunction;
+		typedef std::pair<SingleKey, SingleKey>							Key;
 
-		struct Key
+		// Registered function, together with the information whether its keys were swapped for the table
+		struct Entry
 		{
-											Key(const SingleKey& key1, const SingleKey& key2, bool swapped);
-			bool							operator== (const Key& rhs) const;
+											Entry(BaseFunction function, bool swapped);
 
-			std::pair<SingleKey, SingleKey>	keyPair;
+			BaseFunction					function;
 			bool							swapped;
 		};
 
-		struct Hasher
-		{
-			std::size_t operator() (const Key& k) const;
-		};
-
-		typedef std::unordered_map<Key, BaseFunction, Hasher>		FnMap;
+		typedef typename Storage::template Table<Key, Entry, PairHasher>	FnTable;
+		typedef typename Statistics::template Recorder<Key, PairHasher>	Recorder;
 
 
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Private member functions
 	private:
+		// Copy constructor, only accessible through clone()
+									DoubleDispatcher(const DoubleDispatcher& origin, detail::CloneTag);
+
+		// Returns a new copy, used by aurora::ConcurrentDispatcher to create new versions of the dispatcher
+		DoubleDispatcher*			clone() const;
+
 		// Makes sure that the keys are sorted in case we use symmetric argument dispatching.
-		Key							makeKey(SingleKey key1, SingleKey key2) const;
+		// Sets swapped to true if the key order differs from the argument order.
+		Key							makeKey(SingleKey key1, SingleKey key2, bool& swapped) const;
+
+		// Order of the keys in symmetric mode: integral and enum keys by value, other keys by hash value
+		static bool					keyLess(const SingleKey& lhs, const SingleKey& rhs, std::true_type /*byValue*/);
+		static bool					keyLess(const SingleKey& lhs, const SingleKey& rhs, std::false_type /*byValue*/);
+
+		// Sorts the pairs by function and calls invoker(function, arg1, arg2) on each pair, with the arguments in parameter
+		// order; nullptr denotes the fallback, which receives the arguments in their original order
+		template <typename Itr, typename Invoker>
+		void						dispatchPairs(Itr first, Itr last, Invoker invoker) const;
+
+		// Calls invoker(function, arg1, arg2) for one pair of a batch, and records the call if statistics are enabled
+		template <typename Invoker>
+		void						invokePaired(const Entry* entry, Parameter arg1, Parameter arg2, bool reversed, Invoker& invoker, std::true_type) const;
+
+		template <typename Invoker>
+		void						invokePaired(const Entry* entry, Parameter arg1, Parameter arg2, bool reversed, Invoker& invoker, std::false_type) const;
 
 
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Private variables
 	private:
-		FnMap						mMap;
-		BaseFunction				mFallback;
+		FnTable						mTable;
+		std::function<Signature>	mFallback;
 		bool						mSymmetric;
+		bool						mSealed;
+		Recorder					mStatistics;
+
+	template <class Dispatcher>
+	friend class ConcurrentDispatcher;
 };
 
 /// @}
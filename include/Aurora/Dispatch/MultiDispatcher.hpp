@@ -0,0 +1,282 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class template aurora::MultiDispatcher
+
+#ifndef AURORA_MULTIDISPATCHER_HPP
+#define AURORA_MULTIDISPATCHER_HPP
+
+#include <Aurora/Dispatch/DispatchTraits.hpp>
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Dispatch/DispatchStatistics.hpp>
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Tools/Exceptions.hpp>
+#include <Aurora/Tools/Delegate.hpp>
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Meta/Variadic.hpp>
+#include <Aurora/Config.hpp>
+
+#include <array>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <cassert>
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Class that is able to perform dynamic dispatch on multiple functions with N parameters.
+/// @details Generalization of aurora::SingleDispatcher and aurora::DoubleDispatcher for any number of dispatched
+///  arguments. The keys of all N arguments are combined into one composite key, so that each call requires a single
+///  lookup. Like DoubleDispatcher, the dispatcher can be symmetric: then, the order of the arguments doesn't matter, and
+///  they are rearranged to the parameter order of the registered function.
+/// @tparam Signature Function signature <b>R(B, ..., B)</b> with N parameters of type @c B, or <b>R(B, ..., B, U...)</b>
+///  with additional user parameters @c U. See SingleDispatcher for a description of these types.
+/// @tparam N Number of dispatched parameters.
+/// @tparam Traits Traits class to customize the usage of the dispatcher. In addition to the members described in
+///  SingleDispatcher, it must provide <b>template <typename... Ids, typename Fn> static Delegate<S> trampolineN(Fn f)</b>,
+///  which receives the N type identifiers passed to bind(). aurora::RttiDispatchTraits<S, N> is used by default.
+/// @tparam Storage Policy that determines how the registered functions are stored. Since keys are arrays, only policies
+///  supporting hashable keys can be used (e.g. HashStorage, FlatStorage, PerfectHashStorage, SmallStorage). By default,
+///  the storage of @c Traits is used; if that indexes arrays by single keys (DenseStorage, ArrayStorage), HashStorage.
+/// @tparam Statistics Policy that determines whether calls are recorded, see aurora::SingleDispatcher.
+/// @code
+/// // Example class hierarchy
+/// class Base { public: virtual ~Base() {} };
+/// class Unit : public Base {};
+/// class Weapon : public Base {};
+///
+/// // Free function for the derived types
+/// void attack(Unit* attacker, Weapon* weapon, Unit* target);
+///
+/// // Create dispatcher and register function
+/// aurora::MultiDispatcher<void(Base*, Base*, Base*), 3> dispatcher(false);
+/// dispatcher.bind(aurora::Type<Unit>(), aurora::Type<Weapon>(), aurora::Type<Unit>(), &attack);
+///
+/// // Invoke function on base class pointers
+/// dispatcher.call(attacker, weapon, target);
+/// @endcode
+template <typename Signature, std::size_t N, class Traits = RttiDispatchTraits<Signature, N>,
+	class Storage = typename detail::CompositeTraitsStorage<Traits>::Type, class Statistics = NoDispatchStatistics>
+class MultiDispatcher : private NonCopyable
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public types
+	public:
+		/// @brief Function return type
+		///
+		typedef typename FunctionResult<Signature>::Type		Result;
+
+		/// @brief Function parameter type denoting the object used for the dispatch
+		///
+		typedef typename FunctionParam<Signature, 0>::Type		Parameter;
+
+		/// @brief First additional parameter for user data, only useful if @c Signature contains more than N parameters
+		///
+		typedef typename FunctionParam<Signature, N>::Type		UserData;
+
+		/// @brief Return type of tryCall(): <tt>aurora::Optional<Result></tt>, or @c bool if @c Result is @c void
+		///
+		typedef typename detail::TryCall<Result>::Type			TryResult;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Static assertions
+
+	// Make sure that B is either T* or T&
+	static_assert(std::is_pointer<Parameter>::value || std::is_lvalue_reference<Parameter>::value,
+		"Function parameter must be a pointer or reference.");
+
+	static_assert(N >= 1 && FunctionArity<Signature>::value >= N,
+		"Signature must have N dispatched parameters, optionally followed by user parameters.");
+
+	// Key combinations are stored by tables that don't copy the characters of non-owning string keys
+	static_assert(!std::is_same<typename Traits::Key, StringKey>::value,
+		"aurora::StringKey keys are only supported by SingleDispatcher.");
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Constructor
+		/// @param symmetric Is true if the calls shall be symmetric, i.e. the order of the arguments does not matter.
+		///  A function registered for the types (A, B, C) is then also invoked for the arguments (C, A, B), with the
+		///  arguments rearranged accordingly.
+		explicit					MultiDispatcher(bool symmetric = true);
+
+		/// @brief Constructor with allocator
+		/// @details Requires a storage policy whose tables can be constructed from @c allocator, such as aurora::AllocatorStorage
+		///  or aurora::PmrStorage. All tables of the dispatcher then allocate their memory through @c allocator.
+		/// @param symmetric See MultiDispatcher(bool).
+		/// @param allocator Allocator, or (for aurora::PmrStorage) pointer to a @c std::pmr::memory_resource.
+		template <typename Allocator>
+									MultiDispatcher(bool symmetric, const Allocator& allocator);
+
+		/// @brief Move constructor
+									MultiDispatcher(MultiDispatcher&& source);
+
+		/// @brief Move assignment operator
+		MultiDispatcher&			operator= (MultiDispatcher&& source);
+
+		/// @brief Destructor
+									~MultiDispatcher();
+
+		/// @brief Registers a function bound to a specific combination of keys.
+		/// @details Usage: <tt>bind(identifier1, ..., identifierN, function)</tt>. The keys are computed from each
+		///  identifier through Traits::keyFromId(identifier). The function usually has the signature
+		///  <tt>Result(Parameter, ..., Parameter)</tt>, but may take derived classes, see the trampolines in the Traits classes.
+		///  In case @c Signature contains user parameters, the function receives them after the dispatched arguments.
+		/// @param args N identifiers, followed by the function to register.
+		/// @throw FunctionCallException if the dispatcher has been sealed.
+		template <typename... Args>
+		void						bind(Args&&... args);
+
+		/// @brief Dispatches the keys of the first N arguments and invokes the corresponding function.
+		/// @details Usage: <tt>call(arg1, ..., argN)</tt>, or <tt>call(arg1, ..., argN, data...)</tt> if @c Signature contains
+		///  user parameters, which are perfectly forwarded to the function. <tt>Traits::keyFromBase(arg)</tt> is invoked to determine the key of each dispatched argument.
+		///  The function bound to the combination of all keys is then looked up and invoked. If no match is found and a
+		///  fallback function has been registered using fallback(), then the fallback function will be invoked.
+		/// @param args Function arguments according to @c Signature.
+		/// @return The return value of the dispatched function, if any.
+		/// @throw FunctionCallException when no corresponding function is found and no fallback has been registered.
+		template <typename... Args>
+		Result						call(Args&&... args) const;
+
+		/// @brief Invokes the function registered for the first N arguments, if any
+		/// @details Like call(), but a missing function is reported through the return value, without exception or call to
+		///  Traits::name(). The fallback function is not invoked.
+		/// @param args Function arguments according to @c Signature.
+		/// @return The return value of the dispatched function wrapped in aurora::Optional, or an empty optional if no
+		///  function is registered. If @c Result is @c void, the return type is @c bool, denoting whether a function was invoked.
+		template <typename... Args>
+		TryResult					tryCall(Args&&... args) const;
+
+		/// @brief Checks whether a function is registered for a combination of identifiers
+		/// @details Usage: <tt>contains(identifier1, ..., identifierN)</tt>. If the dispatcher is symmetric, the order
+		///  of the identifiers doesn't matter.
+		template <typename... Ids>
+		bool						contains(const Ids&... identifiers) const;
+
+		/// @brief Returns the statistics recorded by all threads so far.
+		/// @details See SingleDispatcher::statistics(). Key combinations are labeled by the names of their keys, in the
+		///  sorted order of a symmetric dispatcher.
+		DispatchReport				statistics() const;
+
+		/// @brief Declares that no more functions will be registered.
+		/// @details See SingleDispatcher::seal().
+		void						seal();
+
+		/// @brief Reorganizes the table according to the calls so far.
+		/// @details See SingleDispatcher::optimize().
+		void						optimize();
+
+		/// @brief Registers a fallback function.
+		/// @details The passed function will be invoked when call() doesn't find a registered function, with the
+		///  arguments in their original order.
+		/// @param function Function according to the specified signature.
+		void						fallback(std::function<Signature> function);
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		typedef typename Traits::Key													SingleKey;
+		typedef Delegate<Signature>														BaseFunction;
+		typedef std::array<SingleKey, N>												Key;
+		typedef typename std::remove_pointer<typename std::remove_reference<Parameter>::type>::type* Object;
+		typedef std::array<Object, N>													Objects;
+		typedef std::array<std::size_t, N>												Permutation;
+		typedef detail::MakeIndexSequence<N>											Indices;
+
+		// Registered function, together with the original positions of the sorted keys
+		struct Entry
+		{
+											Entry(BaseFunction function, const Permutation& order);
+
+			BaseFunction					function;
+			Permutation						order;
+		};
+
+		typedef typename Storage::template Table<Key, Entry, RangeHasher>				FnTable;
+		typedef typename Statistics::template Recorder<Key, RangeHasher>				Recorder;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		template <typename Tuple, std::size_t... Is>
+		void						bindImpl(Tuple args, detail::IndexSequence<Is...>);
+
+		// Dispatches the arguments Is, forwards the user-defined arguments N + Js
+		template <typename Tuple, std::size_t... Is, std::size_t... Js>
+		Result						callImpl(Tuple args, detail::IndexSequence<Is...>, detail::IndexSequence<Js...>) const;
+
+		template <typename Tuple, std::size_t... Is, std::size_t... Js>
+		TryResult					tryCallImpl(Tuple args, detail::IndexSequence<Is...>, detail::IndexSequence<Js...>) const;
+
+		// Computes the composite key of the objects; order[i] is set to the position of the object with the i-th sorted key
+		template <std::size_t... Is>
+		Key							keyOf(const Objects& objects, Permutation& order, detail::IndexSequence<Is...>) const;
+
+		// Looks up the entry for a composite key; arguments[i] is set to the index of the object passed as i-th argument
+		const Entry*				find(const Key& key, const Permutation& order, Permutation& arguments) const;
+
+		// Invokes the function with the objects in the order given by arguments, followed by extra arguments
+		template <std::size_t... Is, typename... Extra>
+		static Result				invoke(const BaseFunction& function, const Objects& objects, const Permutation& arguments,
+										detail::IndexSequence<Is...>, Extra&&... extra);
+
+		// Makes sure that the keys are sorted in case we use symmetric argument dispatching.
+		// Sets order[i] to the position in keys of the i-th sorted key.
+		template <std::size_t... Is>
+		Key							makeKey(const Key& keys, Permutation& order, detail::IndexSequence<Is...>) const;
+
+		// Creates the exception for objects without registered function
+		static FunctionCallException missingError(const Objects& objects);
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		FnTable						mTable;
+		std::function<Signature>	mFallback;
+		bool						mSymmetric;
+		bool						mSealed;
+		Recorder					mStatistics;
+};
+
+/// @}
+
+} // namespace aurora
+
+#include <Aurora/Dispatch/Detail/MultiDispatcher.inl>
+
+#endif // AURORA_MULTIDISPATCHER_HPP
@@ -0,0 +1,281 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class template aurora::MulticastDispatcher
+
+#ifndef AURORA_MULTICASTDISPATCHER_HPP
+#define AURORA_MULTICASTDISPATCHER_HPP
+
+#include <Aurora/Dispatch/DispatchTraits.hpp>
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Tools/Delegate.hpp>
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Config.hpp>
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Class that invokes all functions registered for the dynamic type of an object.
+/// @details In contrast to aurora::SingleDispatcher, where each key has at most one function, any number of functions
+///  can be bound to the same key. This is useful for event systems, where multiple listeners subscribe to an event type.
+///  All functions are stored in a single contiguous array, grouped by key and ordered by registration. A call thus
+///  requires one table lookup, after which the functions of the key are invoked in sequence.
+/// @tparam Signature Function signature <b>R(B)</b> or <b>R(B, U)</b>, see SingleDispatcher. The return values of the
+///  invoked functions are discarded, so @c R is usually @c void.
+/// @tparam Traits Traits class to customize the usage of the dispatcher, see SingleDispatcher. All traits that work with
+///  SingleDispatcher can be used, such as aurora::RttiDispatchTraits or aurora::DenseDispatchTraits.
+/// @tparam Storage Policy that determines how keys are mapped to their functions, see SingleDispatcher.
+///
+/// Usage example:
+/// @code
+/// // Example class hierarchy
+/// class Event { public: virtual ~Event() {} };
+/// class Collision : public Event {};
+///
+/// // Create dispatcher and register functions
+/// aurora::MulticastDispatcher<void(Event&)> dispatcher;
+/// auto token = dispatcher.bind(aurora::Type<Collision>(), [] (Collision& c) { playSound(c); });
+/// dispatcher.bind(aurora::Type<Collision>(), [] (Collision& c) { applyDamage(c); });
+///
+/// // Invoke both functions, then remove the first one
+/// dispatcher.call(collision);
+/// dispatcher.unbind(token);
+/// @endcode
+template <typename Signature, class Traits = RttiDispatchTraits<Signature, 1>, class Storage = typename detail::TraitsStorage<Traits>::Type>
+class MulticastDispatcher : private NonCopyable
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public types
+	public:
+		/// @brief Function return type
+		///
+		typedef typename FunctionResult<Signature>::Type		Result;
+
+		/// @brief Function parameter type denoting the object used for the dispatch
+		///
+		typedef typename FunctionParam<Signature, 0>::Type		Parameter;
+
+		/// @brief First additional parameter for user data, only useful if @c Signature contains more than 1 parameter
+		///
+		typedef typename FunctionParam<Signature, 1>::Type		UserData;
+
+		/// @brief Identifies a function registered with bind(), so that it can be removed using unbind().
+		/// @details Tokens are small values that can be copied freely. A default-constructed token refers to no function.
+		///  Once the function has been unbound, the token becomes invalid, even if its storage is reused by later functions.
+		class Token
+		{
+			public:
+				/// @brief Default constructor, creates a token that refers to no function
+				///
+									Token();
+
+			private:
+									Token(std::uint32_t index, std::uint32_t generation);
+
+			private:
+				std::uint32_t		mIndex;
+				std::uint32_t		mGeneration;
+
+			friend class MulticastDispatcher;
+		};
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Static assertions
+
+	// Make sure that B is either T* or T&
+	static_assert(std::is_pointer<Parameter>::value || std::is_lvalue_reference<Parameter>::value,
+		"Function parameter must be a pointer or reference.");
+
+	// Make sure that non-owning string keys are copied by the table
+	static_assert(detail::OwnsKeys<typename Traits::Key, Storage>::value,
+		"aurora::StringKey keys require aurora::StringStorage, which copies the characters.");
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Default constructor
+		///
+									MulticastDispatcher();
+
+		/// @brief Move constructor
+		/// @details Tokens returned by @c source remain valid for the new dispatcher. @c source must not be in a call().
+									MulticastDispatcher(MulticastDispatcher&& source);
+
+		/// @brief Move assignment operator
+		MulticastDispatcher&		operator= (MulticastDispatcher&& source);
+
+		/// @brief Destructor
+									~MulticastDispatcher();
+
+		/// @brief Registers a function bound to a specific key.
+		/// @details In contrast to SingleDispatcher::bind(), previously registered functions for the same key are kept;
+		///  the new function is invoked after them.
+		///  @n@n bind() may be invoked by a function that is being called. The new function is then held back and first
+		///  invoked by the next call() that starts after bind() has returned. It is inserted into the storage by the next
+		///  bind(), unbind() or flush() outside of calls.
+		/// @param identifier Type identifier, see SingleDispatcher::bind().
+		/// @param function Function to register, see SingleDispatcher::bind().
+		/// @return Token that can be passed to unbind() in order to remove the function.
+		template <typename Id, typename Fn>
+		Token						bind(const Id& identifier, Fn function);
+
+		/// @brief Removes a function registered with bind().
+		/// @details Functions bound to other keys are not affected, neither is the order of the remaining functions.
+		///  The slot of the removed function is marked as empty and skipped by call(); once many functions have been removed,
+		///  the storage is compacted.
+		///  @n@n unbind() may be invoked by a function that is being called, also for itself. The removed function is not
+		///  invoked anymore, but it is only destroyed by the next bind(), unbind() or flush() outside of calls.
+		/// @param token Token returned by bind().
+		/// @return true if the function has been removed, false if the token doesn't refer to a registered function.
+		bool						unbind(Token token);
+
+		/// @brief Invokes all functions registered for the key of @c arg.
+		/// @details <tt>Traits::keyFromBase(arg)</tt> is invoked to determine the key of the argument. The functions bound
+		///  to this key are then invoked in the order of their registration. Keys without functions are no error.
+		///  The invoked functions may call bind(), unbind() and call() on this dispatcher, see bind() and unbind().
+		///  @n@n call() doesn't modify the storage, but it counts the depth of nested calls. It must therefore not be invoked
+		///  by multiple threads at the same time.
+		/// @param arg Function argument as a reference or pointer.
+		/// @param args Additional user arguments according to @c Signature. Since they are shared by all invoked functions,
+		///  they are passed as lvalues and never moved from.
+		/// @return The number of invoked functions.
+		template <typename... Args>
+		std::size_t					call(Parameter arg, Args&&... args) const;
+
+		/// @brief Applies the changes that bind() and unbind() have held back during calls.
+		/// @details Destroys the functions that have been unbound and inserts the ones that have been bound. This happens
+		///  anyway at the next bind() or unbind(), flush() is only needed to release the resources of unbound functions
+		///  earlier. Must not be invoked during a call().
+		void						flush();
+
+		/// @brief Checks whether any function is registered for a given key.
+		/// @param identifier Type identifier, the key is determined through <tt>Traits::keyFromId(identifier)</tt>.
+		template <typename Id>
+		bool						contains(const Id& identifier) const;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		typedef typename Traits::Key											Key;
+		typedef Delegate<Signature>												BaseFunction;
+
+		// Range of slots that belong to one key; index is the position of the key in mKeys
+		struct Group
+		{
+			std::uint32_t				begin;
+			std::uint32_t				count;
+			std::uint32_t				index;
+		};
+
+		// Registered function, together with the handle that refers to it (removedHandle if unbound)
+		struct Slot
+		{
+										Slot(BaseFunction function, std::uint32_t handle);
+
+			BaseFunction				function;
+			std::uint32_t				handle;
+		};
+
+		// Position of a token's slot; the generation is incremented when the handle is released
+		struct Handle
+		{
+			std::uint32_t				slot;
+			std::uint32_t				generation;
+		};
+
+		// Function bound during a call, which is inserted by the next applyPending() (slot.handle is removedHandle if unbound).
+		// They are kept in a deque, so that call() can invoke them while further functions are bound.
+		struct PendingSlot
+		{
+			Key							key;
+			Slot						slot;
+		};
+
+		typedef typename Storage::template Table<Key, Group, Hasher>			GroupTable;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private constants
+	private:
+		// Slot::handle of unbound functions
+		static const std::uint32_t		removedHandle = 0xffffffffu;
+
+		// Handle::slot of functions in mPendingSlots
+		static const std::uint32_t		pendingSlot = 0xffffffffu;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		// Returns a free handle, reusing released ones
+		std::uint32_t				acquireHandle();
+
+		// Inserts a slot behind the last function of the key
+		void						insert(const Key& key, Slot slot);
+
+		// Removes empty slots and updates groups and handles accordingly
+		void						compact();
+
+		// Performs the destructions, insertions and the compaction that have been held back during calls
+		void						applyPending();
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		GroupTable					mGroups;
+		std::vector<Key>			mKeys;
+		std::vector<Slot>			mSlots;
+		std::vector<Handle>			mHandles;
+		std::vector<std::uint32_t>	mFreeHandles;
+		std::deque<PendingSlot>		mPendingSlots;
+		std::vector<std::uint32_t>	mUnboundSlots;
+		std::size_t					mEmptySlots;
+		mutable std::uint32_t		mCallDepth;
+};
+
+/// @}
+
+} // namespace aurora
+
+#include <Aurora/Dispatch/Detail/MulticastDispatcher.inl>
+
+#endif // AURORA_MULTICASTDISPATCHER_HPP
@@ -30,19 +30,71 @@
 #define AURORA_SINGLEDISPATCHER_HPP
 
 #include <Aurora/Dispatch/DispatchTraits.hpp>
-#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Dispatch/DispatchStatistics.hpp>
+#include <Aurora/Dispatch/Detail/BatchScratch.hpp>
+#include <Aurora/Dispatch/Detail/BaseResolver.hpp>
 #include <Aurora/Tools/Exceptions.hpp>
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Tools/Delegate.hpp>
+#include <Aurora/Tools/Optional.hpp>
+#include <Aurora/Tools/Hash.hpp>
 #include <Aurora/Meta/Templates.hpp>
 #include <Aurora/Config.hpp>
 
-#include <unordered_map>
 #include <functional>
 #include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <atomic>
 #include <cassert>
 
 
 namespace aurora
 {
+namespace detail
+{
+
+	// Function object returned by SingleDispatcher::resolve(): invokes a copy of a registered function and records the
+	// call in the dispatcher's statistics
+	template <typename Result, typename Function, typename Recorder, typename Key>
+	class RecordedFunction
+	{
+		public:
+			RecordedFunction(const Function& function, const Recorder& recorder, const Key& key)
+			: mFunction(function)
+			, mRecorder(recorder)
+			, mKey(key)
+			{
+			}
+
+			template <typename... Args>
+			Result operator() (Args&&... args)
+			{
+				auto measurement = mRecorder.measure(mKey);
+				return mFunction(std::forward<Args>(args)...);
+			}
+
+		private:
+			Function		mFunction;
+			Recorder		mRecorder;
+			Key				mKey;
+	};
+
+	// Returns a number that is unique across all dispatchers, used to detect modifications of dispatcher tables
+	inline std::size_t nextDispatchGeneration()
+	{
+		static std::atomic<std::size_t> counter(0u);
+		return ++counter;
+	}
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
 
 /// @addtogroup Dispatch
 /// @{
@@ -83,13 +135,23 @@ namespace aurora
 ///	    // R(B) signature. It therefore acts as a wrapper for user-defined functions which can link different signatures together.
 ///	    // For example, this is the place to insert downcasts.
 ///	    // The first template parameter Id is required, as it will be explicitly specified when trampoline1() is called.
+///	    // The returned function object is stored in an aurora::Delegate. It must fit into AURORA_DELEGATE_CAPACITY, unless
+///	    // AURORA_DELEGATE_ALLOW_HEAP is defined, in which case larger function objects are allocated on the heap.
 ///	    template <typename Id, typename Fn>
-///	    static std::function<R(B)> trampoline1(Fn f);
+///	    static aurora::Delegate<R(B)> trampoline1(Fn f);
 ///
 ///	    // Optional function that returns a string representation of key for debugging.
 ///	    static const char* name(Key k);
+///
+///	    // Optional storage policy that is used if the dispatcher's Storage parameter is not specified.
+///	    typedef S Storage;
 /// };
 /// @endcode
+/// @tparam Storage Policy that determines how the registered functions are stored. By default, @c Traits::Storage is used
+///  if it exists, and aurora::HashStorage otherwise. aurora::FlatStorage keeps keys and functions in a contiguous array,
+///  which makes lookups more cache-friendly. aurora::DenseStorage is an array indexed by integral keys.
+/// @tparam Statistics Policy that determines whether calls are recorded: aurora::NoDispatchStatistics (default) records
+///  nothing and has no overhead, aurora::DispatchStatistics counts calls and misses and measures latencies per key.
 ///
 /// Usage example:
 /// @code
@@ -112,7 +174,8 @@ namespace aurora
 /// dispatcher.call(ptr); // Invokes void func1(Derived1* d);
 /// delete ptr;
 /// @endcode
-template <typename Signature, class Traits = RttiDispatchTraits<Signature, 1>>
+template <typename Signature, class Traits = RttiDispatchTraits<Signature, 1>, class Storage = typename detail::TraitsStorage<Traits>::Type,
+	class Statistics = NoDispatchStatistics>
 class SingleDispatcher : private NonCopyable
 {
 	// ---------------------------------------------------------------------------------------------------------------------------
@@ -126,10 +189,18 @@ class SingleDispatcher : private NonCopyable
 		///
 		typedef typename FunctionParam<Signature, 0>::Type		Parameter;
 
-		/// @brief Addition parameter for user data, only useful if @c Signature contains more than 1 parameter
+		/// @brief First additional parameter for user data, only useful if @c Signature contains more than 1 parameter
 		///
 		typedef typename FunctionParam<Signature, 1>::Type		UserData;
 
+		/// @brief Return type of tryCall(): <tt>aurora::Optional<Result></tt>, or @c bool if @c Result is @c void
+		///
+		typedef typename detail::TryCall<Result>::Type			TryResult;
+
+		/// @brief Traits class that computes the keys of dispatched objects
+		///
+		typedef Traits											KeyTraits;
+
 
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Static assertions
@@ -138,12 +209,31 @@ class SingleDispatcher : private NonCopyable
 	static_assert(std::is_pointer<Parameter>::value || std::is_lvalue_reference<Parameter>::value,
 		"Function parameter must be a pointer or reference.");
 
+	// Make sure that non-owning string keys are copied by the table
+	static_assert(detail::OwnsKeys<typename Traits::Key, Storage>::value,
+		"aurora::StringKey keys require aurora::StringStorage, which copies the characters.");
+
 
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Public member functions
 	public:
-		/// @brief Default constructor
-									SingleDispatcher();
+		/// @brief Constructor
+		/// @param resolveBases Determines whether objects whose exact class has no registered function are dispatched to
+		///  the function of their nearest registered base class. This requires aurora::Type<T> identifiers in bind() and a
+		///  polymorphic base class. The first call for a class searches the registered classes using @c dynamic_cast and
+		///  inserts the result into a table that later calls read without locking. The resolved functions are discarded by
+		///  bind() and seal(). Classes without registered base class are remembered, too; they are passed to the fallback
+		///  function. Dispatchers that don't resolve base classes allocate none of this state.
+		explicit					SingleDispatcher(bool resolveBases = false);
+
+		/// @brief Constructor with allocator
+		/// @details Requires a storage policy whose tables can be constructed from @c allocator, such as aurora::AllocatorStorage
+		///  or aurora::PmrStorage. All tables of the dispatcher, including those for resolved base classes, then allocate
+		///  their memory through @c allocator.
+		/// @param resolveBases See SingleDispatcher(bool).
+		/// @param allocator Allocator, or (for aurora::PmrStorage) pointer to a @c std::pmr::memory_resource.
+		template <typename Allocator>
+									SingleDispatcher(bool resolveBases, const Allocator& allocator);
 
 		/// @brief Move constructor
 									SingleDispatcher(SingleDispatcher&& source);
@@ -162,8 +252,15 @@ class SingleDispatcher : private NonCopyable
 		///  identifier through Traits::keyFromId(identifier).
 		/// @param function Function to register and associate with the given identifier. Usually, the function has the signature
 		///  <tt>Result(Parameter)</tt>, but it's possible to deviate from it (e.g. using derived classes), see also the note about
-		///  trampolines in the Traits classes. In case you specified a second parameter for the @c Signature template
-		///  parameter, the function should have the signature <tt>Result(Parameter, Parameter, UserData)</tt>.
+		///  trampolines in the Traits classes. In case you specified further parameters for the @c Signature template
+		///  parameter, the function should accept them after the first one, e.g. <tt>Result(Parameter, UserData)</tt>.
+		///  @n@n If the dispatcher resolves base classes (see constructor), a function bound to class @c T is also invoked
+		///  for objects of classes derived from @c T, unless a more derived class has its own function. The function must
+		///  therefore accept a pointer or reference to @c T.
+		///  @n@n The function object returned by the trampoline is stored in an aurora::Delegate. Function objects larger than
+		///  @c AURORA_DELEGATE_CAPACITY bytes (by default three pointers) fail to compile, unless @c AURORA_DELEGATE_ALLOW_HEAP
+		///  is defined, in which case they are allocated on the heap.
+		/// @throw FunctionCallException if the dispatcher has been sealed.
 		template <typename Id, typename Fn>
 		void						bind(const Id& identifier, Fn function);
 
@@ -172,21 +269,72 @@ class SingleDispatcher : private NonCopyable
 		///  that key is then looked up in the map and invoked. If no match is found and a fallback function has been registered
 		///  using fallback(), then the fallback function will be invoked.
 		/// @param arg Function argument as a reference or pointer.
+		/// @param args Additional user arguments, one for each further parameter in @c Signature. They are perfectly forwarded
+		///  to the function, so rvalues and move-only types are not copied on the way.
 		/// @return The return value of the dispatched function, if any.
 		/// @throw FunctionCallException when no corresponding function is found and no fallback has been registered.
-		Result						call(Parameter arg) const;
+		template <typename... Args>
+		Result						call(Parameter arg, Args&&... args) const;
 
-		/// @brief Invokes the function depending on @c arg and passes a user-defined argument @c data
-		/// @brief Dispatches the key of @c arg and invokes the corresponding function
-		/// @details <tt>Traits::keyFromBase(arg)</tt> is invoked to determine the key of the passed argument. The function bound to
-		///  that key is then looked up in the map and invoked. If no match is found and a fallback function has been registered
-		///  using fallback(), then the fallback function will be invoked.
-		///  @n@n This method is only enabled if the @c Signature template parameter contains 2 parameters.
+		/// @brief Invokes the function registered for @c arg, if any
+		/// @details Like call(), but a missing function is reported through the return value: there is no exception, no
+		///  memory allocation and no call to Traits::name(). The fallback function is not invoked.
 		/// @param arg Function argument as a reference or pointer.
-		/// @param data An additional user argument that is forwarded to the function.
-		/// @return The return value of the dispatched function, if any.
+		/// @param args Additional user arguments, forwarded like in call().
+		/// @return The return value of the dispatched function wrapped in aurora::Optional, or an empty optional if no
+		///  function is registered. If @c Result is @c void, the return type is @c bool, denoting whether a function was invoked.
+		template <typename... Args>
+		TryResult					tryCall(Parameter arg, Args&&... args) const;
+
+		/// @brief Looks up the function that call() would invoke for @c arg, without invoking it
+		/// @details Returns a copy of the function, which stays valid when the dispatcher is modified or destroyed. Calls of
+		///  the returned function are recorded in the dispatcher's statistics; a miss is recorded by resolve() itself, and
+		///  the fallback function is returned. This is the lookup used by aurora::callAsync().
+		/// @param arg Function argument as a reference or pointer. It is only used for the lookup and not stored.
+		/// @return Function to be invoked with @c arg and the user arguments.
 		/// @throw FunctionCallException when no corresponding function is found and no fallback has been registered.
-		Result						call(Parameter arg, UserData data) const;
+		std::function<Signature>	resolve(Parameter arg) const;
+
+		/// @brief Checks whether a function is registered for a specific key
+		/// @param identifier Value that identifies the object, as in bind().
+		/// @return True if bind() has been called with this identifier. Base class resolution is not taken into account.
+		template <typename Id>
+		bool						contains(const Id& identifier) const;
+
+		/// @brief Dispatches every object in the range [first, last), grouped by the invoked function
+		/// @details The keys of all objects are computed first, and the objects are sorted by their function using a stable
+		///  counting sort. Then, each function is invoked on its objects in a row. For large ranges of mixed types, this
+		///  keeps the branch target predictable and the function hot in the instruction cache, compared to repeated call().
+		///  @n@n The functions are not invoked in the order of the range, but objects with the same function keep their
+		///  relative order. Return values are discarded. Objects with unregistered keys are passed to the fallback function;
+		///  if there is none, an exception is thrown before any function is invoked.
+		///  @n@n The sorting buffers are kept per thread and reused, so repeated batches do not allocate memory once the
+		///  buffers have reached the batch size.
+		/// @tparam Itr Forward iterator. The elements are pointers or references to objects, they are dereferenced or their
+		///  address is taken to match @c Parameter.
+		/// @param args Additional user arguments, one for each further parameter in @c Signature. Since they are shared by
+		///  all function calls, they are passed as lvalues and never moved from; @c Signature must therefore not contain
+		///  rvalue reference parameters.
+		/// @throw FunctionCallException when a key is not registered and no fallback has been registered.
+		template <typename Itr, typename... Args>
+		void						callBatch(Itr first, Itr last, Args&&... args) const;
+
+		/// @brief Returns the statistics recorded by all threads so far.
+		/// @details The report is only filled if the @c Statistics template parameter is aurora::DispatchStatistics. It
+		///  contains the calls and misses of call(), tryCall(), callBatch(), CallSite::call() and resolve(); keys
+		///  are labeled using Traits::name().
+		DispatchReport				statistics() const;
+
+		/// @brief Declares that no more functions will be registered.
+		/// @details Gives the storage policy the opportunity to reorganize its table for faster lookups; for example,
+		///  aurora::PerfectHashStorage computes a perfect hash function. After this call, bind() throws an exception.
+		///  The fallback function can still be changed.
+		void						seal();
+
+		/// @brief Reorganizes the table according to the calls so far.
+		/// @details Only has an effect with adaptive storage policies such as aurora::AdaptiveStorage, which move the most
+		///  frequently called keys to the front. Can be called periodically, but not while other threads call the dispatcher.
+		void						optimize();
 
 		/// @brief Registers a fallback function.
 		/// @details The passed function will be invoked when call() doesn't find a registered function. It can be used when
@@ -199,16 +347,119 @@ class SingleDispatcher : private NonCopyable
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Private types
 	private:
-		typedef typename Traits::Key					Key;
-		typedef std::function<Signature>				BaseFunction;
-		typedef std::unordered_map<Key, BaseFunction>	FnMap;
+		typedef typename Traits::Key											Key;
+		typedef Delegate<Signature>											BaseFunction;
+		typedef typename Storage::template Table<Key, BaseFunction, Hasher>	FnTable;
+		typedef typename detail::StorageAllocator<Storage, char>::Type			ContainerAllocator;
+		typedef detail::BaseResolver<Key, Parameter, BaseFunction, Hasher, ContainerAllocator> BaseResolver;
+		typedef typename detail::StorageAllocator<Storage, BaseResolver>::Type	ResolverAllocator;
+		typedef std::unique_ptr<BaseResolver, detail::AllocatorDeleter<BaseResolver, ResolverAllocator>> ResolverPtr;
+		typedef typename Statistics::template Recorder<Key, Hasher>			Recorder;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public classes
+	public:
+		/// @brief Cache for a single call site, remembering the functions of the last @c N dispatched keys.
+		/// @details Most call sites see only few dynamic types. A CallSite object stores the keys and functions that have
+		///  recently been looked up in a dispatcher, and consults the dispatcher's table only if the key is not among them.
+		///  The cache is invalidated automatically when the dispatcher is modified through bind(). It may be used with
+		///  different dispatchers, but is only effective if the same dispatcher is used repeatedly.
+		///  @n@n A CallSite must not be used by multiple threads concurrently; declare it @c thread_local if necessary.
+		/// @code
+		/// static thread_local Dispatcher::CallSite<> site;
+		/// site.call(dispatcher, object);
+		/// @endcode
+		/// @tparam N Number of (key, function) pairs that are remembered.
+		template <std::size_t N = 4>
+		class CallSite
+		{
+			// ---------------------------------------------------------------------------------------------------------------------------
+			// Public member functions
+			public:
+				/// @brief Default constructor
+											CallSite();
+
+				/// @brief Dispatches @c arg using @c dispatcher, with the same semantics as SingleDispatcher::call().
+				/// @details Base classes are resolved if the dispatcher does so, and the call is recorded by the dispatcher's
+				///  statistics.
+				template <typename... Args>
+				Result						call(const SingleDispatcher& dispatcher, Parameter arg, Args&&... args);
+
+				/// @brief Returns the number of calls that were resolved by the cache.
+				///
+				std::size_t					hits() const;
+
+				/// @brief Returns the number of calls that had to look up the dispatcher's table.
+				///
+				std::size_t					misses() const;
+
+				/// @brief Returns the ratio of hits to all calls, or 0 if no call has been made yet.
+				///
+				float						hitRate() const;
+
+
+			// ---------------------------------------------------------------------------------------------------------------------------
+			// Private member functions
+			private:
+				// Returns the function for key, or nullptr if the dispatcher has no function for it (not even for a base class)
+				const BaseFunction*			lookup(const SingleDispatcher& dispatcher, const Key& key, Parameter arg);
+
+
+			// ---------------------------------------------------------------------------------------------------------------------------
+			// Private variables
+			private:
+				Optional<Key>				mKeys[N];
+				const BaseFunction*			mFunctions[N];
+				std::size_t					mSize;
+				std::size_t					mNext;
+				std::size_t					mGeneration;
+				std::size_t					mHits;
+				std::size_t					mMisses;
+		};
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		// Copy constructor, only accessible through clone()
+									SingleDispatcher(const SingleDispatcher& origin, detail::CloneTag);
+
+		// Returns a new copy, used by aurora::ConcurrentDispatcher to create new versions of the dispatcher
+		SingleDispatcher*			clone() const;
+
+		// Returns the function for arg's key, or nullptr if neither the key nor (if enabled) a base class is registered
+		const BaseFunction*			find(const Key& key, Parameter arg) const;
+
+		// Discards all resolved functions, must not be called concurrently with calls
+		void						clearResolvedBases();
+
+		// Sorts the range by function and calls invoker(function, arg) on each object, with nullptr denoting the fallback
+		template <typename Itr, typename Invoker>
+		void						dispatchBatch(Itr first, Itr last, Invoker invoker) const;
+
+		// Calls invoker(function, arg) for one object of a batch, and records the call if statistics are enabled
+		template <typename Invoker>
+		void						invokeBatched(const BaseFunction* function, Parameter arg, Invoker& invoker, std::true_type) const;
+
+		template <typename Invoker>
+		void						invokeBatched(const BaseFunction* function, Parameter arg, Invoker& invoker, std::false_type) const;
 
 
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// Private variables
 	private:
-		FnMap						mMap;
-		BaseFunction				mFallback;
+		FnTable						mTable;
+		std::function<Signature>	mFallback;
+		std::size_t					mGeneration;
+		bool						mSealed;
+
+		ResolverPtr					mResolver;			// null if base classes are not resolved
+
+		Recorder					mStatistics;
+
+	template <class Dispatcher>
+	friend class ConcurrentDispatcher;
 };
 
 /// @}
@@ -0,0 +1,242 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class template aurora::StaticDispatcher
+
+#ifndef AURORA_STATICDISPATCHER_HPP
+#define AURORA_STATICDISPATCHER_HPP
+
+#include <Aurora/Dispatch/DispatchTraits.hpp>
+#include <Aurora/Dispatch/DispatchStorage.hpp>
+#include <Aurora/Tools/Exceptions.hpp>
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Meta/Variadic.hpp>
+#include <Aurora/Config.hpp>
+
+#include <array>
+#include <string>
+
+
+namespace aurora
+{
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Binds a class to a free function at compile time, for aurora::StaticDispatcher.
+/// @tparam T Class of the dispatched object.
+/// @tparam F Function pointer type.
+/// @tparam Function Function to invoke for objects of class @c T. It takes @c T in the form of the dispatcher's
+///  parameter (pointer or reference), and the user data if the dispatcher's signature contains it.
+/// @see AURORA_STATIC_BINDING
+template <typename T, typename F, F Function>
+struct StaticBinding
+{
+	/// @brief Class of the dispatched object
+	///
+	typedef T Class;
+};
+
+/// @brief Macro to specify an aurora::StaticBinding without repeating the function type
+/// @details Expands to <tt>aurora::StaticBinding<Class, decltype(&function), &function></tt>. Since @c decltype is used,
+///  @c function must not be overloaded; in this case, specify aurora::StaticBinding directly.
+/// @hideinitializer
+#define AURORA_STATIC_BINDING(Class, function) aurora::StaticBinding<Class, decltype(&function), &function>
+
+/// @}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
+
+namespace detail
+{
+
+	// Function with the dispatcher's signature, which downcasts the argument and invokes the bound function
+	template <typename Signature, typename Binding>
+	struct StaticThunk;
+
+	template <typename R, typename B, typename... Us, typename T, typename F, F Function>
+	struct StaticThunk<R(B, Us...), StaticBinding<T, F, Function>>
+	{
+		static R invoke(B arg, Us... userData)
+		{
+			typedef AURORA_REPLICATE(B, T) Derived;
+			return Function(static_cast<Derived>(arg), std::forward<Us>(userData)...);
+		}
+	};
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
+
+/// @addtogroup Dispatch
+/// @{
+
+/// @brief Class that performs dynamic dispatch on functions which are registered at compile time.
+/// @details Behaves like aurora::SingleDispatcher, but the functions are specified as template arguments instead of being
+///  registered with bind(). The functions are wrapped in a constant array of function pointers, which lives in read-only
+///  memory and requires neither allocations nor initialization at runtime. The constructor only computes the key of each
+///  class and stores it in the table, together with a pointer into that array.
+///  Use this class when the set of dispatched functions is known at compile time, to reduce the startup cost of many bind() calls.
+/// @tparam Signature Function signature <b>R(B)</b> or <b>R(B, U)</b>, see SingleDispatcher.
+/// @tparam Bindings aurora::Typelist of aurora::StaticBinding types, usually created with the @ref AURORA_STATIC_BINDING macro.
+///  If a class appears multiple times, the last binding is used.
+/// @tparam Traits Traits class to customize the usage of the dispatcher, see SingleDispatcher. The function
+///  <tt>Traits::keyFromId()</tt> must accept aurora::Type<T> identifiers, which is the case for aurora::RttiDispatchTraits
+///  and aurora::DenseDispatchTraits. The objects are downcast using @c static_cast, trampolines are not used.
+/// @tparam Storage Policy that determines how the keys are stored, see SingleDispatcher. Since all keys are known at
+///  construction, the table is sealed, which makes aurora::PerfectHashStorage a good choice.
+///
+/// Usage example:
+/// @code
+/// // Example class hierarchy
+/// class Base { public: virtual ~Base() {} };
+/// class Derived1 : public Base {};
+/// class Derived2 : public Base {};
+///
+/// // Free functions for the derived types
+/// void func1(Derived1& d);
+/// void func2(Derived2& d);
+///
+/// // Create dispatcher with all functions
+/// typedef aurora::Typelist<
+///     AURORA_STATIC_BINDING(Derived1, func1),
+///     AURORA_STATIC_BINDING(Derived2, func2)
+/// > Bindings;
+/// aurora::StaticDispatcher<void(Base&), Bindings> dispatcher;
+///
+/// // Invoke functions on base class reference
+/// Derived1 d;
+/// dispatcher.call(d); // Invokes void func1(Derived1& d);
+/// @endcode
+template <typename Signature, typename Bindings, class Traits = RttiDispatchTraits<Signature, 1>,
+	class Storage = typename detail::TraitsStorage<Traits>::Type>
+class StaticDispatcher;
+
+/// @brief Partial specialization that unpacks the typelist
+/// @details See aurora::StaticDispatcher for documentation.
+template <typename Signature, class Traits, class Storage, typename... Bindings>
+class StaticDispatcher<Signature, Typelist<Bindings...>, Traits, Storage>
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public types
+	public:
+		/// @brief Function return type
+		///
+		typedef typename FunctionResult<Signature>::Type		Result;
+
+		/// @brief Function parameter type denoting the object used for the dispatch
+		///
+		typedef typename FunctionParam<Signature, 0>::Type		Parameter;
+
+		/// @brief First additional parameter for user data, only useful if @c Signature contains more than 1 parameter
+		///
+		typedef typename FunctionParam<Signature, 1>::Type		UserData;
+
+		/// @brief Return type of tryCall(): <tt>aurora::Optional<Result></tt>, or @c bool if @c Result is @c void
+		///
+		typedef typename detail::TryCall<Result>::Type			TryResult;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Static assertions
+
+	// Make sure that B is either T* or T&
+	static_assert(std::is_pointer<Parameter>::value || std::is_lvalue_reference<Parameter>::value,
+		"Function parameter must be a pointer or reference.");
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Default constructor
+		/// @details Computes the keys of all bound classes and stores them in the table.
+									StaticDispatcher();
+
+		/// @brief Dispatches the key of @c arg and invokes the corresponding function.
+		/// @details See SingleDispatcher::call().
+		/// @param arg Function argument as a reference or pointer.
+		/// @param args Additional user arguments according to @c Signature, which are perfectly forwarded to the function.
+		/// @return The return value of the dispatched function, if any.
+		/// @throw FunctionCallException when no corresponding function is found and no fallback has been registered.
+		template <typename... Args>
+		Result						call(Parameter arg, Args&&... args) const;
+
+		/// @brief Dispatches the key of @c arg and invokes the corresponding function, if there is one.
+		/// @details See SingleDispatcher::tryCall().
+		/// @param arg Function argument as a reference or pointer.
+		/// @param args Additional user arguments according to @c Signature, which are perfectly forwarded to the function.
+		/// @return The return value of the dispatched function, or an empty result if no function is registered for @c arg.
+		///  The fallback function is not invoked.
+		template <typename... Args>
+		TryResult					tryCall(Parameter arg, Args&&... args) const;
+
+		/// @brief Checks whether a function is bound to a given key.
+		/// @param identifier Type identifier, the key is determined through <tt>Traits::keyFromId(identifier)</tt>.
+		template <typename Id>
+		bool						contains(const Id& identifier) const;
+
+		/// @brief Registers a fallback function.
+		/// @details The passed function will be invoked when call() doesn't find a registered function. Only a pointer is
+		///  stored, so the dispatcher still doesn't allocate; captureless lambdas convert implicitly. The table is not modified.
+		/// @param function Function according to the specified signature, or @c nullptr to remove the fallback.
+		void						fallback(Signature* function);
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		typedef typename Traits::Key											Key;
+		typedef Signature*														Function;
+		typedef std::array<Function, sizeof...(Bindings)>						FunctionArray;
+		typedef typename Storage::template Table<Key, Function, Hasher>			FnTable;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		// Looks up the function for the key of arg, returns the fallback or throws if there is none
+		Function					find(Parameter arg) const;
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		static constexpr FunctionArray	sFunctions = {{ &detail::StaticThunk<Signature, Bindings>::invoke... }};
+
+		FnTable						mTable;
+		Function					mFallback;
+};
+
+/// @}
+
+} // namespace aurora
+
+#include <Aurora/Dispatch/Detail/StaticDispatcher.inl>
+
+#endif // AURORA_STATICDISPATCHER_HPP
@@ -39,73 +39,48 @@ namespace aurora
 namespace detail
 {
 
-	// Get type by index in list
-	template <std::size_t N, typename T0, typename T1, typename T2>
-	struct NthType;
+	// Type denoting "nothing"
+	// We don't use void because it can't be used in some contexts (parameter lists)
+	struct EmptyType {};
 
-	template <typename T0, typename T1, typename T2>
-	struct NthType<0, T0, T1, T2>
-	{
-		typedef T0 Type;
-	};
 
-	template <typename T0, typename T1, typename T2>
-	struct NthType<1, T0, T1, T2>
+	// Get type by index in list, EmptyType if the index is out of range
+	template <std::size_t N, typename... Ts>
+	struct NthType
 	{
-		typedef T1 Type;
+		typedef EmptyType Type;
 	};
 
-	template <typename T0, typename T1, typename T2>
-	struct NthType<2, T0, T1, T2>
+	template <typename T, typename... Ts>
+	struct NthType<0, T, Ts...>
 	{
-		typedef T2 Type;
+		typedef T Type;
 	};
 
-
-	// Helper for FunctionSignature metafunction
-	template <typename R, std::size_t N, typename P0, typename P1, typename P2>
-	struct FunctionSignatureBase
+	template <std::size_t N, typename T, typename... Ts>
+	struct NthType<N, T, Ts...>
 	{
-		typedef R ResultType;
-		static const std::size_t arity = N;
-
-		template <std::size_t M>
-		struct Param
-		{
-			typedef typename NthType<M, P0, P1, P2>::Type Type;
-		};
+		typedef typename NthType<N - 1, Ts...>::Type Type;
 	};
 
 
-	// Type denoting "nothing"
-	// We don't use void because it can't be used in some contexts (parameter lists)
-	struct EmptyType {};
-
-
 	// Provides member typedefs for function return and parameter types:
 	// FunctionSignature<S>::ResultType      return type
 	// FunctionSignature<S>::Param<N>::Type  N-th parameter type (use ::template Param in dependent context)
 	template <typename S>
 	struct FunctionSignature;
 
-	template <typename R>
-	struct FunctionSignature<R()> : FunctionSignatureBase<R, 0, EmptyType, EmptyType, EmptyType>
-	{
-	};
-
-	template <typename R, typename P0>
-	struct FunctionSignature<R(P0)> : FunctionSignatureBase<R, 1, P0, EmptyType, EmptyType>
-	{
-	};
-
-	template <typename R, typename P0, typename P1>
-	struct FunctionSignature<R(P0, P1)> : FunctionSignatureBase<R, 2, P0, P1, EmptyType>
+	template <typename R, typename... Ps>
+	struct FunctionSignature<R(Ps...)>
 	{
-	};
+		typedef R ResultType;
+		static const std::size_t arity = sizeof...(Ps);
 
-	template <typename R, typename P0, typename P1, typename P2>
-	struct FunctionSignature<R(P0, P1, P2)> : FunctionSignatureBase<R, 3, P0, P1, P2>
-	{
+		template <std::size_t M>
+		struct Param
+		{
+			typedef typename NthType<M, Ps...>::Type Type;
+		};
 	};
 
 } // namespace detail
@@ -33,7 +33,6 @@
 
 #include <utility> // std::forward()
 
-#ifdef AURORA_HAS_VARIADIC_TEMPLATES
 
 namespace aurora
 {
@@ -61,6 +60,28 @@ namespace detail
 	};
 
 
+	// Compile-time sequence of indices, to expand tuples and arrays into parameter packs
+	template <std::size_t... Is>
+	struct IndexSequence
+	{
+	};
+
+	template <std::size_t N, std::size_t... Is>
+	struct MakeIndexSequenceImpl : MakeIndexSequenceImpl<N - 1, N - 1, Is...>
+	{
+	};
+
+	template <std::size_t... Is>
+	struct MakeIndexSequenceImpl<0, Is...>
+	{
+		typedef IndexSequence<Is...> Type;
+	};
+
+	// IndexSequence<0, 1, ..., N-1>
+	template <std::size_t N>
+	using MakeIndexSequence = typename MakeIndexSequenceImpl<N>::Type;
+
+
 	// Metafunction to apply a class template 'Function' to each type of variadic pack typelist
 	template <typename Function, typename... Ts>
 	struct ForEachType;
@@ -215,5 +236,4 @@ void foreach(Function&& fn, Ts&&... args)
 
 } // namespace aurora
 
-#endif // AURORA_HAS_VARIADIC_TEMPLATES
 #endif // AURORA_VARIADIC_HPP
@@ -30,6 +30,7 @@
 #define AURORA_MODULE_TOOLS_HPP
 
 #include <Aurora/Tools/Algorithms.hpp>
+#include <Aurora/Tools/Delegate.hpp>
 #include <Aurora/Tools/Downcast.hpp>
 #include <Aurora/Tools/Exceptions.hpp>
 #include <Aurora/Tools/ForEach.hpp>
@@ -37,7 +38,9 @@
 #include <Aurora/Tools/NamedTuple.hpp>
 #include <Aurora/Tools/NonCopyable.hpp>
 #include <Aurora/Tools/SafeBool.hpp>
+#include <Aurora/Tools/StringKey.hpp>
 #include <Aurora/Tools/Swap.hpp>
 #include <Aurora/Tools/Typeid.hpp>
+#include <Aurora/Tools/WorkerPool.hpp>
 
 #endif // AURORA_MODULE_TOOLS_HPP
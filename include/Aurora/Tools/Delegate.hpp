@@ -0,0 +1,362 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class template aurora::Delegate
+
+#ifndef AURORA_DELEGATE_HPP
+#define AURORA_DELEGATE_HPP
+
+#include <Aurora/Tools/SafeBool.hpp>
+#include <Aurora/Meta/Templates.hpp>
+#include <Aurora/Config.hpp>
+
+#include <type_traits>
+#include <utility>
+#include <cassert>
+#include <new>
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Type with the strictest alignment among the usual members of function objects
+	union DelegateAlignment
+	{
+		void*		pointer;
+		void		(*function)();
+		double		floating;
+		long long	integer;
+	};
+
+	// Invokes a function object and converts its return value (or discards it, for void)
+	template <typename R>
+	struct DelegateCall
+	{
+		template <typename Fn, typename... Args>
+		static R call(Fn& function, Args&&... args)
+		{
+			return function(std::forward<Args>(args)...);
+		}
+	};
+
+	template <>
+	struct DelegateCall<void>
+	{
+		template <typename Fn, typename... Args>
+		static void call(Fn& function, Args&&... args)
+		{
+			function(std::forward<Args>(args)...);
+		}
+	};
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
+
+/// @addtogroup Tools
+/// @{
+
+/// @brief Default capacity of aurora::Delegate in bytes
+/// @details Three pointers are enough for function pointers, member function pointers together with an object pointer,
+///  and lambda expressions capturing up to three pointers. Larger function objects (such as std::function) do not
+///  compile, unless @c AURORA_DELEGATE_ALLOW_HEAP is defined. You can define this macro before including Aurora headers
+///  to change the default.
+#ifndef AURORA_DELEGATE_CAPACITY
+	#define AURORA_DELEGATE_CAPACITY (3 * sizeof(void*))
+#endif
+
+/// @brief Function object with fixed-size inline storage.
+/// @details Like std::function, a delegate can store any callable object that can be invoked with the parameters of
+///  @c Signature. Function objects that fit into @c Capacity bytes are stored inside the delegate itself -- there is no
+///  heap allocation, neither when the delegate is constructed nor when it is copied. Function objects that are larger,
+///  over-aligned or not nothrow move-constructible fail to compile by default. If the macro @c AURORA_DELEGATE_ALLOW_HEAP
+///  is defined before including Aurora headers, they are allocated on the heap instead.
+///  @n@n Moving a delegate never throws.
+/// @tparam Signature Function signature <b>R(Args...)</b>.
+/// @tparam Capacity Size of the inline storage, in bytes.
+/// @code
+/// aurora::Delegate<int(int)> twice = [] (int i) { return 2 * i; };
+/// int result = twice(4); // 8
+/// @endcode
+template <typename Signature, std::size_t Capacity = AURORA_DELEGATE_CAPACITY>
+class Delegate;
+
+/// @}
+
+template <typename R, typename... Args, std::size_t Capacity>
+class Delegate<R(Args...), Capacity>
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Construct empty delegate
+		///
+		Delegate()
+		: mInvoker(nullptr)
+		, mManager(nullptr)
+		{
+		}
+
+		/// @brief Construct from function object
+		/// @details The function object must be copy-constructible. It is stored inside the delegate if it fits into
+		///  @c Capacity bytes and its move constructor is @c noexcept. Otherwise, it is allocated on the heap if
+		///  @c AURORA_DELEGATE_ALLOW_HEAP is defined, and the constructor fails to compile if not.
+		template <typename Fn>
+		Delegate(Fn function
+			AURORA_ENABLE_IF(!std::is_same<typename std::decay<Fn>::type, Delegate>::value))
+		: mInvoker(&invoke<Fn>)
+		, mManager(&manage<Fn>)
+		{
+#ifndef AURORA_DELEGATE_ALLOW_HEAP
+			static_assert(sizeof(Fn) <= Capacity,
+				"Function object is too large for aurora::Delegate. Capture less state, increase AURORA_DELEGATE_CAPACITY "
+				"or define AURORA_DELEGATE_ALLOW_HEAP.");
+			static_assert(std::alignment_of<Fn>::value <= std::alignment_of<Storage>::value,
+				"Function object is over-aligned for aurora::Delegate. Define AURORA_DELEGATE_ALLOW_HEAP to allocate it.");
+			static_assert(std::is_nothrow_move_constructible<Fn>::value,
+				"Function object for aurora::Delegate must be nothrow move-constructible. Define AURORA_DELEGATE_ALLOW_HEAP to allocate it.");
+#endif
+
+			construct<Fn>(&mStorage, std::move(function), IsInline<Fn>());
+		}
+
+		/// @brief Copy constructor
+		///
+		Delegate(const Delegate& origin)
+		: mInvoker(origin.mInvoker)
+		, mManager(origin.mManager)
+		{
+			if (mManager)
+				mManager(Copy, &mStorage, const_cast<Storage*>(&origin.mStorage));
+		}
+
+		/// @brief Move constructor
+		///
+		Delegate(Delegate&& source) noexcept
+		: mInvoker(source.mInvoker)
+		, mManager(source.mManager)
+		{
+			if (mManager)
+			{
+				mManager(Move, &mStorage, &source.mStorage);
+				source.mInvoker = nullptr;
+				source.mManager = nullptr;
+			}
+		}
+
+		/// @brief Copy assignment operator
+		///
+		Delegate& operator= (const Delegate& origin)
+		{
+			Delegate(origin).swap(*this);
+			return *this;
+		}
+
+		/// @brief Move assignment operator
+		///
+		Delegate& operator= (Delegate&& source) noexcept
+		{
+			Delegate(std::move(source)).swap(*this);
+			return *this;
+		}
+
+		/// @brief Destructor
+		///
+		~Delegate()
+		{
+			if (mManager)
+				mManager(Destroy, &mStorage, nullptr);
+		}
+
+		/// @brief Exchanges the contents of two delegates.
+		///
+		void swap(Delegate& other) noexcept
+		{
+			Delegate temp;
+			temp.relocateFrom(*this);
+			this->relocateFrom(other);
+			other.relocateFrom(temp);
+		}
+
+		/// @brief Invokes the stored function object.
+		/// @warning Calling an empty delegate yields undefined behavior.
+		R operator() (Args... args) const
+		{
+			assert(mInvoker);
+			return mInvoker(const_cast<Storage*>(&mStorage), std::forward<Args>(args)...);
+		}
+
+		/// @brief Check if the delegate contains a function object.
+		///
+		operator SafeBool() const
+		{
+			return toSafeBool(mInvoker != nullptr);
+		}
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		enum Operation
+		{
+			Copy,
+			Move,
+			Destroy,
+		};
+
+		typedef typename std::aligned_storage<Capacity, std::alignment_of<detail::DelegateAlignment>::value>::type	Storage;
+		typedef R (*Invoker)(void*, Args&&...);
+		typedef void (*Manager)(Operation, void*, void*);
+
+		// Whether a function object is stored inline; if not, the storage holds a pointer to a heap-allocated one.
+		// Moving inline objects must not throw, since delegates are moved by noexcept operations.
+		template <typename Fn>
+		struct IsInline : std::integral_constant<bool,
+			sizeof(Fn) <= Capacity && std::alignment_of<Fn>::value <= std::alignment_of<Storage>::value
+			&& std::is_nothrow_move_constructible<Fn>::value>
+		{
+		};
+
+		static_assert(sizeof(void*) <= Capacity, "aurora::Delegate capacity must be able to hold a pointer.");
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		// Moves the function object of an empty source into this empty delegate
+		void relocateFrom(Delegate& source) noexcept
+		{
+			if (source.mManager)
+				source.mManager(Move, &mStorage, &source.mStorage);
+
+			mInvoker = source.mInvoker;
+			mManager = source.mManager;
+			source.mInvoker = nullptr;
+			source.mManager = nullptr;
+		}
+
+		template <typename Fn>
+		static void construct(void* storage, Fn&& function, std::true_type /*inline*/)
+		{
+			new (storage) Fn(std::move(function));
+		}
+
+		template <typename Fn>
+		static void construct(void* storage, Fn&& function, std::false_type /*inline*/)
+		{
+			new (storage) Fn*(new Fn(std::move(function)));
+		}
+
+		template <typename Fn>
+		static Fn& target(void* storage, std::true_type /*inline*/)
+		{
+			return *static_cast<Fn*>(storage);
+		}
+
+		template <typename Fn>
+		static Fn& target(void* storage, std::false_type /*inline*/)
+		{
+			return **static_cast<Fn**>(storage);
+		}
+
+		template <typename Fn>
+		static R invoke(void* storage, Args&&... args)
+		{
+			return detail::DelegateCall<R>::call(target<Fn>(storage, IsInline<Fn>()), std::forward<Args>(args)...);
+		}
+
+		template <typename Fn>
+		static void manage(Operation operation, void* destination, void* source)
+		{
+			manage<Fn>(operation, destination, source, IsInline<Fn>());
+		}
+
+		// Copy: copy-construct source into destination
+		// Move: move-construct source into destination, destroy source
+		// Destroy: destroy destination
+		template <typename Fn>
+		static void manage(Operation operation, void* destination, void* source, std::true_type /*inline*/)
+		{
+			switch (operation)
+			{
+				case Copy:
+					new (destination) Fn(*static_cast<const Fn*>(source));
+					break;
+
+				case Move:
+					new (destination) Fn(std::move(*static_cast<Fn*>(source)));
+					static_cast<Fn*>(source)->~Fn();
+					break;
+
+				case Destroy:
+					static_cast<Fn*>(destination)->~Fn();
+					break;
+			}
+		}
+
+		// Heap-allocated function objects: Move only transfers the pointer
+		template <typename Fn>
+		static void manage(Operation operation, void* destination, void* source, std::false_type /*inline*/)
+		{
+			switch (operation)
+			{
+				case Copy:
+					new (destination) Fn*(new Fn(**static_cast<Fn**>(source)));
+					break;
+
+				case Move:
+					new (destination) Fn*(*static_cast<Fn**>(source));
+					break;
+
+				case Destroy:
+					delete *static_cast<Fn**>(destination);
+					break;
+			}
+		}
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		Storage						mStorage;
+		Invoker						mInvoker;
+		Manager						mManager;
+};
+
+/// @relates Delegate
+/// @brief Swaps two delegates.
+template <typename Signature, std::size_t Capacity>
+void swap(Delegate<Signature, Capacity>& lhs, Delegate<Signature, Capacity>& rhs)
+{
+	lhs.swap(rhs);
+}
+
+} // namespace aurora
+
+#endif // AURORA_DELEGATE_HPP
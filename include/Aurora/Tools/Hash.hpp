@@ -32,10 +32,30 @@
 #include <Aurora/Meta/Templates.hpp>
 
 #include <functional>
+#include <cstdint>
 
 
 namespace aurora
 {
+namespace detail
+{
+
+	// 2^64 divided by the golden ratio; multiplying by it spreads the bits of weak hash values (Fibonacci hashing)
+	const std::uint64_t goldenRatio64 = 0x9e3779b97f4a7c15ull;
+
+	// Finalizer of MurmurHash3 (fmix64), mixes all input bits into all output bits
+	inline std::uint64_t mixBits(std::uint64_t x)
+	{
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ull;
+		x ^= x >> 33;
+		return x;
+	}
+
+} // namespace detail
+
 
 /// @addtogroup Tools
 /// @{
@@ -76,6 +96,17 @@ void hashRange(std::size_t& seed, Itr begin, Itr end)
 		hashCombine(seed, *begin);
 }
 
+/// @brief Hash object that forwards to hashValue()
+/// @details Unlike std::hash<T>, this functor can be used for any type supported by hashValue(), including enums.
+struct Hasher
+{
+	template <typename T>
+	std::size_t operator() (const T& object) const
+	{
+		return hashValue(object);
+	}
+};
+
 /// @brief Hash object for std::pair
 ///
 struct PairHasher
@@ -91,6 +122,20 @@ struct PairHasher
 	}
 };
 
+/// @brief Hash object for ranges, such as std::array or std::vector
+/// @details Combines the hash values of all elements in the range [begin(), end()).
+struct RangeHasher
+{
+	template <typename Range>
+	std::size_t operator() (const Range& range) const
+	{
+		std::size_t hash = 0u;
+		hashRange(hash, range.begin(), range.end());
+
+		return hash;
+	}
+};
+
 /// @}
 
 } // namespace aurora
@@ -269,7 +269,7 @@ class Optional
 			// Exception safety: set mFilled only to true after successful construction
 
 			assert(!mFilled);
-			new (&content()) T(std::forward<Args>(args)...);
+			new (&mStorage) T(std::forward<Args>(args)...);
 			mFilled = true;
 		}
 
@@ -278,7 +278,7 @@ class Optional
 		void construct(T& source)
 		{
 			assert(!mFilled);
-			new (&content()) T(std::move(source);
+			new (&mStorage) T(std::move(source));
 			mFilled = true;
 		}
 
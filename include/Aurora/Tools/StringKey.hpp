@@ -0,0 +1,204 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class aurora::StringKey
+
+#ifndef AURORA_STRINGKEY_HPP
+#define AURORA_STRINGKEY_HPP
+
+#include <Aurora/Tools/Hash.hpp>
+#include <Aurora/Config.hpp>
+
+#include <string>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+
+#ifdef AURORA_HAS_CXX17
+	#include <string_view>
+#endif
+
+
+namespace aurora
+{
+namespace detail
+{
+
+	// Hashes a byte sequence, processing 8 bytes at a time
+	inline std::size_t hashString(const char* data, std::size_t length)
+	{
+		std::uint64_t hash = 0xcbf29ce484222325ull ^ length;
+
+		for (; length >= 8u; data += 8u, length -= 8u)
+		{
+			std::uint64_t word;
+			std::memcpy(&word, data, 8u);
+
+			hash = (hash ^ word) * goldenRatio64;
+			hash ^= hash >> 32;
+		}
+
+		if (length > 0u)
+		{
+			std::uint64_t word = 0u;
+			std::memcpy(&word, data, length);
+
+			hash = (hash ^ word) * goldenRatio64;
+		}
+
+		return static_cast<std::size_t>(mixBits(hash));
+	}
+
+} // namespace detail
+
+
+/// @addtogroup Tools
+/// @{
+
+/// @brief Non-owning reference to a string, together with its precomputed hash value.
+/// @details Can be implicitly constructed from string literals, <tt>const char*</tt>, std::string and (in C++17)
+///  std::string_view, without allocating memory. The hash value is computed once during construction, so that subsequent
+///  lookups in hash tables don't need to process the characters again. Comparisons check hash value and length first.
+/// @n@n The referenced characters are not copied, so they must outlive the StringKey. Strings may contain null characters.
+/// @see aurora::StringDispatchTraits
+class StringKey
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Construct from null-terminated string
+		///
+		StringKey(const char* string)
+		: mData(string)
+		, mSize(std::strlen(string))
+		, mHash(detail::hashString(mData, mSize))
+		{
+		}
+
+		/// @brief Construct from character array with explicit length
+		///
+		StringKey(const char* data, std::size_t size)
+		: mData(data)
+		, mSize(size)
+		, mHash(detail::hashString(mData, mSize))
+		{
+		}
+
+		/// @brief Construct from std::string
+		///
+		StringKey(const std::string& string)
+		: mData(string.data())
+		, mSize(string.size())
+		, mHash(detail::hashString(mData, mSize))
+		{
+		}
+
+#ifdef AURORA_HAS_CXX17
+		/// @brief Construct from std::string_view
+		///
+		StringKey(std::string_view string)
+		: mData(string.data())
+		, mSize(string.size())
+		, mHash(detail::hashString(mData, mSize))
+		{
+		}
+#endif
+
+		/// @brief Returns a pointer to the first character (not necessarily null-terminated)
+		///
+		const char* data() const
+		{
+			return mData;
+		}
+
+		/// @brief Returns the number of characters
+		///
+		std::size_t size() const
+		{
+			return mSize;
+		}
+
+		/// @brief Returns the precomputed hash value
+		///
+		std::size_t hash() const
+		{
+			return mHash;
+		}
+
+		/// @brief Copies the characters into a std::string
+		///
+		std::string str() const
+		{
+			return std::string(mData, mSize);
+		}
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		const char*			mData;
+		std::size_t			mSize;
+		std::size_t			mHash;
+};
+
+/// @relates StringKey
+/// @brief Checks whether two keys refer to equal character sequences
+inline bool operator== (const StringKey& lhs, const StringKey& rhs)
+{
+	return lhs.hash() == rhs.hash()
+		&& lhs.size() == rhs.size()
+		&& std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+/// @relates StringKey
+/// @brief Checks whether two keys refer to different character sequences
+inline bool operator!= (const StringKey& lhs, const StringKey& rhs)
+{
+	return !(lhs == rhs);
+}
+
+/// @}
+
+} // namespace aurora
+
+
+namespace std
+{
+
+	/// @brief Specialization of std::hash, returns the precomputed hash value
+	///
+	template <>
+	struct hash<aurora::StringKey>
+	{
+		std::size_t operator() (const aurora::StringKey& key) const
+		{
+			return key.hash();
+		}
+	};
+
+} // namespace std
+
+#endif // AURORA_STRINGKEY_HPP
@@ -0,0 +1,264 @@
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Aurora C++ Library
+// Copyright (c) 2012-2022 Jan Haller
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Class aurora::WorkerPool
+
+#ifndef AURORA_WORKERPOOL_HPP
+#define AURORA_WORKERPOOL_HPP
+
+#include <Aurora/Tools/NonCopyable.hpp>
+#include <Aurora/Config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace aurora
+{
+
+/// @addtogroup Tools
+/// @{
+
+/// @brief Pool of threads that execute submitted tasks, balanced by work stealing.
+/// @details Every worker thread owns a queue. Tasks submitted by a worker are pushed to its own queue, other tasks are
+///  distributed among the queues in turn. A worker takes the most recent task from its own queue; when it runs empty,
+///  the worker steals the oldest task of another queue. Idle workers sleep until new tasks arrive.
+/// @code
+/// aurora::WorkerPool pool;
+/// std::future<int> result = pool.submit([] () { return computeExpensiveValue(); });
+/// int value = result.get();
+/// @endcode
+class WorkerPool : private NonCopyable
+{
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Public member functions
+	public:
+		/// @brief Constructor, starts the worker threads
+		/// @param threadCount Number of worker threads. If 0, the number of hardware threads is used.
+		explicit WorkerPool(std::size_t threadCount = 0u)
+		: mQueues()
+		, mThreads()
+		, mSleepMutex()
+		, mWakeUp()
+		, mPending(0u)
+		, mSleeping(0u)
+		, mNextQueue(0u)
+		, mStopping(false)
+		{
+			if (threadCount == 0u)
+				threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+			for (std::size_t i = 0u; i < threadCount; ++i)
+				mQueues.emplace_back(new Queue());
+
+			for (std::size_t i = 0u; i < threadCount; ++i)
+				mThreads.emplace_back(&WorkerPool::run, this, i);
+		}
+
+		/// @brief Destructor
+		/// @details Executes the tasks that are still pending, then joins the worker threads.
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+				mStopping = true;
+			}
+
+			mWakeUp.notify_all();
+
+			for (std::thread& thread : mThreads)
+				thread.join();
+		}
+
+		/// @brief Submits a function to be executed by a worker thread.
+		/// @param function Function object without parameters. It is copied or moved to the worker thread.
+		/// @return Future that receives the return value of @c function, or the exception thrown by it.
+		template <typename Fn>
+		std::future<decltype(std::declval<Fn&>()())> submit(Fn function)
+		{
+			typedef decltype(std::declval<Fn&>()()) R;
+
+			// std::function requires copyable functions, so share the packaged task
+			std::shared_ptr<std::packaged_task<R()>> task = std::make_shared<std::packaged_task<R()>>(std::move(function));
+			std::future<R> future = task->get_future();
+
+			execute([task] () { (*task)(); });
+			return future;
+		}
+
+		/// @brief Submits a function to be executed by a worker thread, without result.
+		/// @param task Function to execute. It must not throw exceptions.
+		void execute(std::function<void()> task)
+		{
+			// Counted before the task is queued, so that a worker taking it never sees mPending wrap around
+			++mPending;
+
+			// Workers push to their own queue, other threads distribute the tasks
+			const Worker& worker = currentWorker();
+			const std::size_t index = (worker.pool == this) ? worker.index : mNextQueue++ % mQueues.size();
+
+			{
+				Queue& queue = *mQueues[index];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				queue.tasks.push_back(std::move(task));
+			}
+
+			// A worker going to sleep registers before it checks mPending, so either it sees the task or we see it.
+			// The mutex makes sure that it is already waiting when notified.
+			if (mSleeping > 0u)
+			{
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+				mWakeUp.notify_one();
+			}
+		}
+
+		/// @brief Returns the number of worker threads
+		///
+		std::size_t threadCount() const
+		{
+			return mThreads.size();
+		}
+
+		/// @brief Returns a pool that is shared across the application
+		/// @details The pool is created on first use with one thread per hardware thread.
+		static WorkerPool& global()
+		{
+			static WorkerPool pool;
+			return pool;
+		}
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private types
+	private:
+		typedef std::function<void()> Task;
+
+		struct Queue
+		{
+			std::mutex				mutex;
+			std::deque<Task>		tasks;
+		};
+
+		// Identifies the pool and queue of the current thread, if it is a worker
+		struct Worker
+		{
+			const WorkerPool*		pool;
+			std::size_t				index;
+		};
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private member functions
+	private:
+		static Worker& currentWorker()
+		{
+			static thread_local Worker worker = { nullptr, 0u };
+			return worker;
+		}
+
+		// Takes a task from the own queue (newest first), otherwise steals from other queues (oldest first)
+		bool pop(std::size_t index, Task& task)
+		{
+			for (std::size_t i = 0u; i < mQueues.size(); ++i)
+			{
+				Queue& queue = *mQueues[(index + i) % mQueues.size()];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+
+				if (!queue.tasks.empty())
+				{
+					if (i == 0u)
+					{
+						task = std::move(queue.tasks.back());
+						queue.tasks.pop_back();
+					}
+					else
+					{
+						task = std::move(queue.tasks.front());
+						queue.tasks.pop_front();
+					}
+
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void run(std::size_t index)
+		{
+			Worker& worker = currentWorker();
+			worker.pool = this;
+			worker.index = index;
+
+			for (;;)
+			{
+				Task task;
+				if (pop(index, task))
+				{
+					--mPending;
+					task();
+					continue;
+				}
+
+				// Pending tasks may not be in a queue yet, in which case the wait returns immediately and we try again
+				std::unique_lock<std::mutex> lock(mSleepMutex);
+				++mSleeping;
+				mWakeUp.wait(lock, [this] () { return mStopping || mPending > 0u; });
+				--mSleeping;
+
+				if (mStopping && mPending == 0u)
+					return;
+			}
+		}
+
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// Private variables
+	private:
+		std::vector<std::unique_ptr<Queue>>	mQueues;
+		std::vector<std::thread>			mThreads;
+		std::mutex							mSleepMutex;
+		std::condition_variable				mWakeUp;
+		std::atomic<std::size_t>			mPending;
+		std::atomic<std::size_t>			mSleeping;
+		std::atomic<std::size_t>			mNextQueue;
+		bool								mStopping;
+};
+
+/// @}
+
+} // namespace aurora
+
+#endif // AURORA_WORKERPOOL_HPP